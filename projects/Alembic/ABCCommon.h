@@ -4,6 +4,11 @@
 #include "ABCTree.h"
 #include "Alembic/Abc/IObject.h"
 #include "zeno/ListObject.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace zeno {
 class TimeAndSamplesMap {
@@ -26,6 +31,47 @@ private:
     bool m_isVerbose;
 };
 
+// faces of a mesh as read on an earlier frame, reusable for as long as the
+// schema says they can't change (constant or homogeneous topology)
+struct ABCMeshTopology {
+    bool constant = false;          // positions can't change either
+    std::vector<vec3f> positions;   // only kept when constant
+    std::vector<int> loops;
+    std::vector<vec2i> polys;
+    bool is_point = false;
+    bool has_uvs = false;           // uvs are constant too, or there are none
+    std::vector<vec2f> uvs;
+    std::vector<int> loop_uvs;
+    bool read_face_set = false;
+    std::vector<int> faceset;
+    std::vector<std::string> faceset_names;
+};
+
+// kept by the reader nodes across frames, keyed by the abc path of the mesh
+struct ABCReadCache {
+    std::shared_ptr<ABCMeshTopology const> get(std::string const &path) {
+        std::lock_guard lck(mtx);
+        auto it = meshes.find(path);
+        return it == meshes.end() ? nullptr : it->second;
+    }
+
+    void set(std::string const &path, std::shared_ptr<ABCMeshTopology const> topo) {
+        std::lock_guard lck(mtx);
+        meshes[path] = std::move(topo);
+    }
+
+    void clear() {
+        std::lock_guard lck(mtx);
+        meshes.clear();
+    }
+
+private:
+    std::mutex mtx;
+    std::unordered_map<std::string, std::shared_ptr<ABCMeshTopology const>> meshes;
+};
+
+// children of each object are visited in parallel; with a cache, the faces
+// of meshes with constant or homogeneous topology are only read once
 extern void traverseABC(
     Alembic::AbcGeom::IObject &obj,
     ABCTree &tree,
@@ -36,7 +82,8 @@ extern void traverseABC(
     const TimeAndSamplesMap & iTimeMap,
     ObjectVisibility parent_visible,
     bool skipInvisibleObject,
-    bool outOfRangeAsEmpty
+    bool outOfRangeAsEmpty,
+    ABCReadCache *cache = nullptr
 );
 
 extern Alembic::AbcGeom::IArchive readABC(std::string const &path);
@@ -8,10 +8,12 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/PrimitiveUtils.h>
 #include <zeno/extra/GlobalState.h>
+#include <zeno/utils/frame_prefetcher.h>
 #include "ABCCommon.h"
 #include "ABCTree.h"
 #include "zeno/utils/string.h"
 #include <queue>
+#include <tuple>
 #include <utility>
 
 namespace zeno {
@@ -407,6 +409,10 @@ ZENDEFNODE(GetAlembicCamera, {
 struct ImportAlembicPrim : INode {
     Alembic::Abc::v12::IArchive archive;
     std::string usedPath;
+    std::tuple<bool, bool> usedOptions;
+    ABCReadCache cache;
+    // last member: its pending reads must finish before the archive goes away
+    FramePrefetcher<ABCTree> prefetcher;
     virtual void apply() override {
         int frameid;
         if (has_input("frameid")) {
@@ -414,14 +420,23 @@ struct ImportAlembicPrim : INode {
         } else {
             frameid = getGlobalState()->frameid;
         }
-        auto abctree = std::make_shared<ABCTree>();
+        std::shared_ptr<ABCTree> abctree;
         {
             auto path = get_input2<std::string>("path");
+            bool read_face_set = get_input2<bool>("read_face_set");
+            bool outOfRangeAsEmpty = get_input2<bool>("outOfRangeAsEmpty");
+            int prefetch = get_input2<int>("prefetch");
+            auto options = std::make_tuple(read_face_set, outOfRangeAsEmpty);
             bool read_done = archive.valid() && (path == usedPath);
+            if (!read_done || usedOptions != options || prefetch <= 0) {
+                prefetcher.cancel();
+            }
             if (!read_done) {
                 archive = readABC(path);
                 usedPath = path;
+                cache.clear();
             }
+            usedOptions = options;
             double start, _end;
             GetArchiveStartAndEndTime(archive, start, _end);
             TimeAndSamplesMap timeMap;
@@ -430,10 +445,17 @@ struct ImportAlembicPrim : INode {
                 timeMap.add(archive.getTimeSampling(s),
                             archive.getMaxNumSamplesForTimeSamplingIndex(s));
             }
-            auto obj = archive.getTop();
-            bool read_face_set = get_input2<bool>("read_face_set");
-            bool outOfRangeAsEmpty = get_input2<bool>("outOfRangeAsEmpty");
-            traverseABC(obj, *abctree, frameid, read_done, read_face_set, "", timeMap, ObjectVisibility::kVisibilityDeferred, false, outOfRangeAsEmpty);
+            auto readFrame = [this, timeMap, read_done, read_face_set, outOfRangeAsEmpty] (int frame) {
+                auto tree = std::make_shared<ABCTree>();
+                auto obj = archive.getTop();
+                traverseABC(obj, *tree, frame, read_done, read_face_set, "", timeMap, ObjectVisibility::kVisibilityDeferred, false, outOfRangeAsEmpty, &cache);
+                return tree;
+            };
+            if (prefetch > 0 && read_done) {
+                abctree = prefetcher.fetch(frameid, prefetch, readFrame);
+            } else {
+                abctree = readFrame(frameid);
+            }
         }
         bool use_xform = get_input2<bool>("use_xform");
         auto index = get_input2<int>("index");
@@ -475,6 +497,7 @@ ZENDEFNODE(ImportAlembicPrim, {
         {"bool", "triangulate", "0"},
         {"bool", "read_face_set", "0"},
         {"bool", "outOfRangeAsEmpty", "0"},
+        {"int", "prefetch", "0"},
     },
     {
         "prim",
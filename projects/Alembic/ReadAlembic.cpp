@@ -21,7 +21,13 @@
 #include <filesystem>
 #include <zeno/utils/string.h>
 #include <zeno/utils/scope_exit.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/utils/frame_prefetcher.h>
 #include <numeric>
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <tuple>
 
 #ifdef ZENO_WITH_PYTHON3
     #include <Python.h>
@@ -581,6 +587,7 @@ static std::shared_ptr<PrimitiveObject> foundABCMesh(
         , bool read_face_set
         , bool outOfRangeAsEmpty
         , std::string abc_name
+        , std::shared_ptr<ABCMeshTopology const> &topology
 ) {
     auto prim = std::make_shared<PrimitiveObject>();
 
@@ -595,20 +602,39 @@ static std::shared_ptr<PrimitiveObject> foundABCMesh(
         return prim;
     }
     ISampleSelector iSS = Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index);
-    Alembic::AbcGeom::IPolyMeshSchema::Sample mesamp = mesh.getValue(iSS);
 
-    if (auto marr = mesamp.getPositions()) {
+    // the cached faces are only trusted while the schema promises they won't change
+    auto variance = mesh.getTopologyVariance();
+    if (variance == kHeterogenousTopology || (topology && topology->read_face_set != read_face_set)) {
+        topology = nullptr;
+    }
+    std::shared_ptr<ABCMeshTopology> fresh;
+    if (!topology) {
+        fresh = std::make_shared<ABCMeshTopology>();
+        fresh->constant = variance == kConstantTopology;
+        fresh->read_face_set = read_face_set;
+    }
+
+    if (topology && topology->constant) {
+        prim->verts.values = topology->positions;
+    } else if (auto marr = mesh.getPositionsProperty().getValue(iSS)) {
         if (!read_done) {
             log_debug("[alembic] totally {} positions", marr->size());
         }
         auto &parr = prim->verts;
+        parr.resize(marr->size());
         for (size_t i = 0; i < marr->size(); i++) {
             auto const &val = (*marr)[i];
-            parr.emplace_back(val[0], val[1], val[2]);
+            parr[i] = {val[0], val[1], val[2]};
+        }
+        if (fresh && fresh->constant) {
+            fresh->positions = prim->verts.values;
         }
     }
 
-    read_velocity(prim, mesamp.getVelocities(), read_done);
+    if (auto vel = mesh.getVelocitiesProperty()) {
+        read_velocity(prim, vel.getValue(iSS), read_done);
+    }
     if (auto nrm = mesh.getNormalsParam()) {
         auto nrmsamp =
                 nrm.getIndexedValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
@@ -623,81 +649,102 @@ static std::shared_ptr<PrimitiveObject> foundABCMesh(
         }
     }
 
-    if (auto marr = mesamp.getFaceIndices()) {
-        if (!read_done) {
-            log_debug("[alembic] totally {} face indices", marr->size());
-        }
-        auto &parr = prim->loops;
-        for (size_t i = 0; i < marr->size(); i++) {
-            int ind = (*marr)[i];
-            parr.push_back(ind);
-        }
-    }
-
     bool is_point = true;
 
-    if (auto marr = mesamp.getFaceCounts()) {
-        if (!read_done) {
-            log_debug("[alembic] totally {} faces", marr->size());
+    if (topology) {
+        prim->loops.values = topology->loops;
+        prim->polys.values = topology->polys;
+        is_point = topology->is_point;
+    } else {
+        if (auto marr = mesh.getFaceIndicesProperty().getValue(iSS)) {
+            if (!read_done) {
+                log_debug("[alembic] totally {} face indices", marr->size());
+            }
+            auto &parr = prim->loops;
+            parr.resize(marr->size());
+            for (size_t i = 0; i < marr->size(); i++) {
+                parr[i] = (*marr)[i];
+            }
         }
-        auto &loops = prim->loops;
-        auto &parr = prim->polys;
-        int base = 0;
-        for (size_t i = 0; i < marr->size(); i++) {
-            int cnt = (*marr)[i];
-            parr.emplace_back(base, cnt);
-            base += cnt;
-            if (cnt != 1) {
-                is_point = false;
+
+        if (auto marr = mesh.getFaceCountsProperty().getValue(iSS)) {
+            if (!read_done) {
+                log_debug("[alembic] totally {} faces", marr->size());
+            }
+            auto &parr = prim->polys;
+            parr.resize(marr->size());
+            int base = 0;
+            for (size_t i = 0; i < marr->size(); i++) {
+                int cnt = (*marr)[i];
+                parr[i] = {base, cnt};
+                base += cnt;
+                if (cnt != 1) {
+                    is_point = false;
+                }
             }
         }
+        fresh->loops = prim->loops.values;
+        fresh->polys = prim->polys.values;
+        fresh->is_point = is_point;
     }
-    if (auto uv = mesh.getUVsParam()) {
-        auto uvsamp =
-            uv.getIndexedValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
-        int value_size = (int)uvsamp.getVals()->size();
-        int index_size = (int)uvsamp.getIndices()->size();
-        if (!read_done) {
-            log_debug("[alembic] totally {} uv value", value_size);
-            log_debug("[alembic] totally {} uv indices", index_size);
+
+    auto uv = mesh.getUVsParam();
+    if (topology && topology->has_uvs) {
+        prim->uvs.values = topology->uvs;
+        prim->loops.add_attr<int>("uvs") = topology->loop_uvs;
+    } else {
+        if (uv) {
+            auto uvsamp =
+                uv.getIndexedValue(Alembic::Abc::v12::ISampleSelector((Alembic::AbcCoreAbstract::index_t)sample_index));
+            int value_size = (int)uvsamp.getVals()->size();
+            int index_size = (int)uvsamp.getIndices()->size();
+            if (!read_done) {
+                log_debug("[alembic] totally {} uv value", value_size);
+                log_debug("[alembic] totally {} uv indices", index_size);
+                if (prim->loops.size() == index_size) {
+                    log_debug("[alembic] uv per face");
+                } else if (prim->verts.size() == index_size) {
+                    log_debug("[alembic] uv per vertex");
+                } else {
+                    log_error("[alembic] error uv indices");
+                }
+            }
+            prim->uvs.resize(value_size);
+            {
+                auto marr = uvsamp.getVals();
+                for (size_t i = 0; i < marr->size(); i++) {
+                    auto const &val = (*marr)[i];
+                    prim->uvs[i] = {val[0], val[1]};
+                }
+            }
             if (prim->loops.size() == index_size) {
-                log_debug("[alembic] uv per face");
-            } else if (prim->verts.size() == index_size) {
-                log_debug("[alembic] uv per vertex");
-            } else {
-                log_error("[alembic] error uv indices");
+                auto &loop_uvs = prim->loops.add_attr<int>("uvs");
+                for (auto i = 0; i < prim->loops.size(); i++) {
+                    loop_uvs[i] = (*uvsamp.getIndices())[i];
+                }
             }
-        }
-        prim->uvs.resize(value_size);
-        {
-            auto marr = uvsamp.getVals();
-            for (size_t i = 0; i < marr->size(); i++) {
-                auto const &val = (*marr)[i];
-                prim->uvs[i] = {val[0], val[1]};
+            else if (prim->verts.size() == index_size) {
+                auto &loop_uvs = prim->loops.add_attr<int>("uvs");
+                for (auto i = 0; i < prim->loops.size(); i++) {
+                    loop_uvs[i] = prim->loops[i];
+                }
             }
         }
-        if (prim->loops.size() == index_size) {
-            prim->loops.add_attr<int>("uvs");
-            for (auto i = 0; i < prim->loops.size(); i++) {
-                prim->loops.attr<int>("uvs")[i] = (*uvsamp.getIndices())[i];
+        if (!prim->loops.has_attr("uvs")) {
+            if (!read_done) {
+                log_warn("[alembic] Not found uv, auto fill zero.");
             }
-        }
-        else if (prim->verts.size() == index_size) {
+            prim->uvs.resize(1);
+            prim->uvs[0] = zeno::vec2f(0, 0);
             prim->loops.add_attr<int>("uvs");
             for (auto i = 0; i < prim->loops.size(); i++) {
-                prim->loops.attr<int>("uvs")[i] = prim->loops[i];
+                prim->loops.attr<int>("uvs")[i] = 0;
             }
         }
-    }
-    if (!prim->loops.has_attr("uvs")) {
-        if (!read_done) {
-            log_warn("[alembic] Not found uv, auto fill zero.");
-        }
-        prim->uvs.resize(1);
-        prim->uvs[0] = zeno::vec2f(0, 0);
-        prim->loops.add_attr<int>("uvs");
-        for (auto i = 0; i < prim->loops.size(); i++) {
-            prim->loops.attr<int>("uvs")[i] = 0;
+        if (fresh && (!uv || uv.isConstant())) {
+            fresh->has_uvs = true;
+            fresh->uvs = prim->uvs.values;
+            fresh->loop_uvs = prim->loops.attr<int>("uvs");
         }
     }
     ICompoundProperty arbattrs = mesh.getArbGeomParams();
@@ -705,6 +752,10 @@ static std::shared_ptr<PrimitiveObject> foundABCMesh(
     ICompoundProperty usrData = mesh.getUserProperties();
     read_user_data(prim, usrData, iSS, read_done);
 
+    if (fresh && variance != kHeterogenousTopology) {
+        topology = fresh;
+    }
+
     if (is_point) {
         prim->loops.clear();
         prim->polys.clear();
@@ -713,30 +764,37 @@ static std::shared_ptr<PrimitiveObject> foundABCMesh(
 
     if (read_face_set) {
         auto &faceset = prim->polys.add_attr<int>("faceset");
-        std::fill(faceset.begin(), faceset.end(), -1);
         auto &ud = prim->userData();
         std::vector<std::string> faceSetNames;
-        mesh.getFaceSetNames(faceSetNames);
-        for (auto i = 0; i < faceSetNames.size(); i++) {
-            auto n = faceSetNames[i];
-            IFaceSet faceSet = mesh.getFaceSet(n);
-            IFaceSetSchema::Sample faceSetSample = faceSet.getSchema().getValue();
-            size_t s = faceSetSample.getFaces()->size();
-            for (auto j = 0; j < s; j++) {
-                int f = faceSetSample.getFaces()->get()[j];
-                faceset[f] = i;
+        if (!fresh) {
+            faceset = topology->faceset;
+            faceSetNames = topology->faceset_names;
+        } else {
+            std::fill(faceset.begin(), faceset.end(), -1);
+            mesh.getFaceSetNames(faceSetNames);
+            for (auto i = 0; i < faceSetNames.size(); i++) {
+                auto n = faceSetNames[i];
+                IFaceSet faceSet = mesh.getFaceSet(n);
+                IFaceSetSchema::Sample faceSetSample = faceSet.getSchema().getValue();
+                size_t s = faceSetSample.getFaces()->size();
+                for (auto j = 0; j < s; j++) {
+                    int f = faceSetSample.getFaces()->get()[j];
+                    faceset[f] = i;
+                }
             }
-        }
-        bool found_unbind_faces = false;
-        int next_faceset_index = faceSetNames.size();
-        for (auto i = 0; i < faceset.size(); i++) {
-            if (faceset[i] == -1) {
-                found_unbind_faces = true;
-                faceset[i] = next_faceset_index;
+            bool found_unbind_faces = false;
+            int next_faceset_index = faceSetNames.size();
+            for (auto i = 0; i < faceset.size(); i++) {
+                if (faceset[i] == -1) {
+                    found_unbind_faces = true;
+                    faceset[i] = next_faceset_index;
+                }
             }
-        }
-        if (found_unbind_faces) {
-            faceSetNames.push_back(abc_name);
+            if (found_unbind_faces) {
+                faceSetNames.push_back(abc_name);
+            }
+            fresh->faceset = faceset;
+            fresh->faceset_names = faceSetNames;
         }
         for (auto i = 0; i < faceSetNames.size(); i++) {
             auto n = faceSetNames[i];
@@ -1020,7 +1078,8 @@ void traverseABC(
     const TimeAndSamplesMap & iTimeMap,
     ObjectVisibility parent_visible,
     bool skipInvisibleObject,
-    bool outOfRangeAsEmpty
+    bool outOfRangeAsEmpty,
+    ABCReadCache *cache
 ) {
     {
         auto const &md = obj.getMetaData();
@@ -1059,7 +1118,15 @@ void traverseABC(
 
                 Alembic::AbcGeom::IPolyMesh meshy(obj);
                 auto &mesh = meshy.getSchema();
-                tree.prim = foundABCMesh(mesh, frameid, read_done, read_face_set, outOfRangeAsEmpty, obj.getName());
+                std::shared_ptr<ABCMeshTopology const> topology;
+                if (cache) {
+                    topology = cache->get(path);
+                }
+                auto cachedTopology = topology;
+                tree.prim = foundABCMesh(mesh, frameid, read_done, read_face_set, outOfRangeAsEmpty, obj.getName(), topology);
+                if (cache && topology != cachedTopology) {
+                    cache->set(path, std::move(topology));
+                }
                 tree.prim->userData().set2("_abc_name", obj.getName());
                 prim_set_abcpath(tree.prim.get(), path);
             } else if (Alembic::AbcGeom::IXformSchema::matches(md)) {
@@ -1122,17 +1189,28 @@ void traverseABC(
         log_debug("[alembic] found {} children", nch);
     }
 
-    for (size_t i = 0; i < nch; i++) {
-        auto const &name = obj.getChildHeader(i).getName();
-        if (!read_done) {
-            log_debug("[alembic] at {} name: [{}]", i, name);
-        }
+    // sibling subtrees are independent, visit them in parallel, the archive
+    // serializes its own reads (Ogawa is opened with a stream per thread)
+    tree.children.resize(nch);
+    std::vector<std::exception_ptr> errors(nch);
+    parallel_for(nch, [&] (size_t i) {
+        try {
+            auto const &name = obj.getChildHeader(i).getName();
+            if (!read_done) {
+                log_debug("[alembic] at {} name: [{}]", i, name);
+            }
 
-        Alembic::AbcGeom::IObject child(obj, name);
+            Alembic::AbcGeom::IObject child(obj, name);
 
-        auto childTree = std::make_shared<ABCTree>();
-        traverseABC(child, *childTree, frameid, read_done, read_face_set, path, iTimeMap, tree.visible, skipInvisibleObject, outOfRangeAsEmpty);
-        tree.children.push_back(std::move(childTree));
+            auto childTree = std::make_shared<ABCTree>();
+            traverseABC(child, *childTree, frameid, read_done, read_face_set, path, iTimeMap, tree.visible, skipInvisibleObject, outOfRangeAsEmpty, cache);
+            tree.children[i] = std::move(childTree);
+        } catch (...) {
+            errors[i] = std::current_exception();
+        }
+    });
+    for (auto const &e: errors) {
+        if (e) std::rethrow_exception(e);
     }
 }
 
@@ -1154,7 +1232,7 @@ Alembic::AbcGeom::IArchive readABC(std::string const &path) {
         return {Alembic::AbcCoreHDF5::ReadArchive(), native_path};
     } else if (hdr == "Ogaw") {
         log_info("[alembic] opening as Ogawa format");
-        return {Alembic::AbcCoreOgawa::ReadArchive(), native_path};
+        return {Alembic::AbcCoreOgawa::ReadArchive(std::max(1u, std::thread::hardware_concurrency())), native_path};
     } else {
         throw Exception("[alembic] unrecognized ABC header: [" + hdr + "]");
     }
@@ -1163,7 +1241,11 @@ Alembic::AbcGeom::IArchive readABC(std::string const &path) {
 struct ReadAlembic : INode {
     Alembic::Abc::v12::IArchive archive;
     std::string usedPath;
+    std::tuple<bool, bool, bool> usedOptions;
     bool read_done = false;
+    ABCReadCache cache;
+    // last member: its pending reads must finish before the archive goes away
+    FramePrefetcher<ABCTree> prefetcher;
     virtual void apply() override {
         int frameid;
         if (has_input("frameid")) {
@@ -1171,23 +1253,28 @@ struct ReadAlembic : INode {
         } else {
             frameid = getGlobalState()->frameid;
         }
-        auto abctree = std::make_shared<ABCTree>();
+        std::shared_ptr<ABCTree> abctree;
         {
             auto path = get_input<StringObject>("path")->get();
+            bool read_face_set = get_input2<bool>("read_face_set");
+            bool outOfRangeAsEmpty = get_input2<bool>("outOfRangeAsEmpty");
+            bool skipInvisibleObject = get_input2<bool>("skipInvisibleObject");
+            int prefetch = get_input2<int>("prefetch");
+            auto options = std::make_tuple(read_face_set, outOfRangeAsEmpty, skipInvisibleObject);
             if (usedPath != path) {
                 read_done = false;
             }
+            if (read_done == false || usedOptions != options || prefetch <= 0) {
+                prefetcher.cancel();
+            }
             if (read_done == false) {
                 archive = readABC(path);
+                cache.clear();
             }
             double start, _end;
             GetArchiveStartAndEndTime(archive, start, _end);
             // fmt::print("GetArchiveStartAndEndTime: {}\n", start);
             // fmt::print("archive.getNumTimeSamplings: {}\n", archive.getNumTimeSamplings());
-            auto obj = archive.getTop();
-            bool read_face_set = get_input2<bool>("read_face_set");
-            bool outOfRangeAsEmpty = get_input2<bool>("outOfRangeAsEmpty");
-            bool skipInvisibleObject = get_input2<bool>("skipInvisibleObject");
             Alembic::Util::uint32_t numSamplings = archive.getNumTimeSamplings();
             TimeAndSamplesMap timeMap;
             for (Alembic::Util::uint32_t s = 0; s < numSamplings; ++s)             {
@@ -1195,10 +1282,21 @@ struct ReadAlembic : INode {
                             archive.getMaxNumSamplesForTimeSamplingIndex(s));
             }
 
-            traverseABC(obj, *abctree, frameid, read_done, read_face_set, "", timeMap, ObjectVisibility::kVisibilityDeferred,
-                        skipInvisibleObject, outOfRangeAsEmpty);
+            auto readFrame = [this, timeMap, read_done = read_done, read_face_set, skipInvisibleObject, outOfRangeAsEmpty] (int frame) {
+                auto tree = std::make_shared<ABCTree>();
+                auto obj = archive.getTop();
+                traverseABC(obj, *tree, frame, read_done, read_face_set, "", timeMap, ObjectVisibility::kVisibilityDeferred,
+                            skipInvisibleObject, outOfRangeAsEmpty, &cache);
+                return tree;
+            };
+            if (prefetch > 0 && read_done) {
+                abctree = prefetcher.fetch(frameid, prefetch, readFrame);
+            } else {
+                abctree = readFrame(frameid);
+            }
             read_done = true;
             usedPath = path;
+            usedOptions = options;
         }
         {
             auto namelist = std::make_shared<zeno::ListObject>();
@@ -1226,6 +1324,7 @@ ZENDEFNODE(ReadAlembic, {
         {"bool", "outOfRangeAsEmpty", "0"},
         {"bool", "skipInvisibleObject", "1"},
         {"frameid"},
+        {"int", "prefetch", "0"},
     },
     {
         {"ABCTree", "abctree"},
@@ -18,8 +18,16 @@
 #include "zeno/utils/fileio.h"
 #include "zeno/funcs/PrimitiveUtils.h"
 #include "zeno/extra/TempNode.h"
+#include "zeno/utils/disable_copy.h"
 #include <numeric>
 #include <filesystem>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
 
 namespace fs = std::filesystem;
 
@@ -544,6 +552,90 @@ void prim_to_poly_if_only_vertex(PrimitiveObject* p) {
     }
 }
 
+// runs the jobs handed to it one at a time and in order on its own thread, so
+// encoding and writing a frame overlaps with cooking the next one; submit
+// blocks while maxPending jobs are queued, and the error of a failed job is
+// rethrown by the next submit or wait
+struct BackgroundWriter : disable_copy {
+    explicit BackgroundWriter(size_t maxPending = 2) : maxPending(maxPending) {}
+
+    ~BackgroundWriter() {
+        {
+            std::lock_guard lck(mtx);
+            stopping = true;
+        }
+        cv.notify_all();
+        if (worker.joinable()) {
+            worker.join();
+        }
+        if (error) {
+            log_error("[alembic] background write failed, the archive may be incomplete");
+        }
+    }
+
+    void submit(std::function<void()> job) {
+        std::unique_lock lck(mtx);
+        rethrowError();
+        if (!worker.joinable()) {
+            worker = std::thread([this] { run(); });
+        }
+        cv.wait(lck, [&] { return jobs.size() < maxPending || error; });
+        rethrowError();
+        jobs.push_back(std::move(job));
+        cv.notify_all();
+    }
+
+    // until every submitted job is written
+    void wait() {
+        std::unique_lock lck(mtx);
+        cv.wait(lck, [&] { return jobs.empty() && !busy; });
+        rethrowError();
+    }
+
+private:
+    void run() {
+        std::unique_lock lck(mtx);
+        while (true) {
+            cv.wait(lck, [&] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            busy = true;
+            lck.unlock();
+            std::exception_ptr e;
+            try {
+                job();
+            } catch (...) {
+                e = std::current_exception();
+            }
+            lck.lock();
+            busy = false;
+            if (e && !error) {
+                error = e;
+                jobs.clear();
+            }
+            cv.notify_all();
+        }
+    }
+
+    void rethrowError() {
+        if (error) {
+            std::rethrow_exception(std::exchange(error, nullptr));
+        }
+    }
+
+    size_t maxPending;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    std::exception_ptr error;
+    bool busy = false;
+    bool stopping = false;
+    std::thread worker;
+};
+
 struct WriteAlembic2 : INode {
     OArchive archive;
     OPolyMesh meshyObj;
@@ -557,10 +649,15 @@ struct WriteAlembic2 : INode {
     std::map<std::string, OFaceSetSchema> o_faceset_schema;
     std::map<int, vec3i> prim_size_per_frame;
     int real_frame_start = -1;
+    // last member: queued frames must be written before the archive closes
+    BackgroundWriter writer;
 
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
         bool flipFrontBack = get_input2<int>("flipFrontBack");
+        bool outputPoint = get_input2<bool>("outputPoint");
+        bool outputToMaya = get_input2<bool>("outputToMaya");
+        bool asyncWrite = get_input2<bool>("asyncWrite");
         float fps = get_input2<float>("fps");
         int frameid;
         if (has_input("frameid")) {
@@ -574,6 +671,7 @@ struct WriteAlembic2 : INode {
         path = create_directories_when_write_file(path);
 
         if (usedPath != path) {
+            writer.wait();
             usedPath = path;
             archive = CreateArchiveWithInfo(
                 Alembic::AbcCoreOgawa::WriteArchive(),
@@ -583,7 +681,7 @@ struct WriteAlembic2 : INode {
                 "None"
             );
             real_frame_start = -1;
-            if (get_input2<bool>("outputPoint")) {
+            if (outputPoint) {
                 pointsObj = OPoints (OObject( archive, 1 ), "points");
             }
             else {
@@ -605,10 +703,23 @@ struct WriteAlembic2 : INode {
         if (archive.valid() == false) {
             zeno::makeError("Not init. Check whether in correct correct frame range.");
         }
+        if (asyncWrite) {
+            // written later, snapshot it so the graph is free to change it meanwhile
+            auto snapshot = std::make_shared<PrimitiveObject>(*prim);
+            writer.submit([this, snapshot, frameid, flipFrontBack, outputPoint, outputToMaya] {
+                writeFrame(snapshot, frameid, flipFrontBack, outputPoint, outputToMaya);
+            });
+        } else {
+            writer.wait();
+            writeFrame(prim, frameid, flipFrontBack, outputPoint, outputToMaya);
+        }
+    }
+
+    void writeFrame(std::shared_ptr<PrimitiveObject> prim, int frameid, bool flipFrontBack, bool outputPoint, bool outputToMaya) {
         if (flipFrontBack) {
             primFlipFaces(prim.get());
         }
-        if (!get_input2<bool>("outputPoint")) {
+        if (!outputPoint) {
             prim_to_poly_if_only_vertex(prim.get());
             // Create a PolyMesh class.
             OPolyMeshSchema &mesh = meshyObj.getSchema();
@@ -674,7 +785,7 @@ struct WriteAlembic2 : INode {
                             uvsamp);
                     write_velocity(prim, mesh_samp);
                     write_normal(prim, mesh_samp);
-                    if (get_input2<bool>("outputToMaya") == false) {
+                    if (outputToMaya == false) {
                         write_attrs(verts_attrs, loops_attrs, polys_attrs, "", prim, mesh, frameid, real_frame_start, prim_size_per_frame);
                     }
                     mesh.set( mesh_samp );
@@ -686,7 +797,7 @@ struct WriteAlembic2 : INode {
                             Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ));
                     write_velocity(prim, mesh_samp);
                     write_normal(prim, mesh_samp);
-                    if (get_input2<bool>("outputToMaya") == false) {
+                    if (outputToMaya == false) {
                         write_attrs(verts_attrs, loops_attrs, polys_attrs, "", prim, mesh, frameid, real_frame_start, prim_size_per_frame);
                     }
                     mesh.set( mesh_samp );
@@ -711,7 +822,7 @@ struct WriteAlembic2 : INode {
             }
             samp.setIds(Alembic::Abc::UInt64ArraySample(ids.data(), ids.size()));
             write_velocity(prim, samp);
-            if (get_input2<bool>("outputToMaya") == false) {
+            if (outputToMaya == false) {
                 write_attrs(verts_attrs, loops_attrs, polys_attrs, "", prim, points, frameid, real_frame_start, prim_size_per_frame);
             }
             points.set( samp );
@@ -730,6 +841,7 @@ ZENDEFNODE(WriteAlembic2, {
         {"bool", "flipFrontBack", "1"},
         {"bool", "outputPoint", "0"},
         {"bool", "outputToMaya", "0"},
+        {"bool", "asyncWrite", "1"},
     },
     {
     },
@@ -749,6 +861,8 @@ struct WriteAlembicPrims : INode {
     std::map<std::string, std::map<std::string, OFaceSetSchema>> o_faceset_schema;
     std::map<std::string, std::map<int, vec3i>> prim_size_per_frame;
     int real_frame_start = -1;
+    // last member: queued frames must be written before the archive closes
+    BackgroundWriter writer;
 
     virtual void apply() override {
         std::vector<std::shared_ptr<PrimitiveObject>> prims;
@@ -761,6 +875,8 @@ struct WriteAlembicPrims : INode {
             prims = get_input<ListObject>("prims")->get<PrimitiveObject>();
         }
         bool flipFrontBack = get_input2<int>("flipFrontBack");
+        bool outputToMaya = get_input2<bool>("outputToMaya");
+        bool asyncWrite = get_input2<bool>("asyncWrite");
         float fps = get_input2<float>("fps");
         int frameid;
         if (has_input("frameid")) {
@@ -830,6 +946,7 @@ struct WriteAlembicPrims : INode {
             }
         }
         if (usedPath != path) {
+            writer.wait();
             usedPath = path;
             archive = CreateArchiveWithInfo(
                 Alembic::AbcCoreOgawa::WriteArchive(),
@@ -877,6 +994,21 @@ struct WriteAlembicPrims : INode {
         if (archive.valid() == false) {
             zeno::makeError("Not init. Check whether in correct correct frame range.");
         }
+        if (asyncWrite) {
+            // written later, snapshot them so the graph is free to change them meanwhile
+            for (auto &prim: new_prims) {
+                prim = std::make_shared<PrimitiveObject>(*prim);
+            }
+            writer.submit([this, new_prims = std::move(new_prims), frameid, flipFrontBack, outputToMaya] {
+                writeFrame(new_prims, frameid, flipFrontBack, outputToMaya);
+            });
+        } else {
+            writer.wait();
+            writeFrame(new_prims, frameid, flipFrontBack, outputToMaya);
+        }
+    }
+
+    void writeFrame(std::vector<std::shared_ptr<PrimitiveObject>> const &new_prims, int frameid, bool flipFrontBack, bool outputToMaya) {
         for (auto prim: new_prims) {
             if (flipFrontBack) {
                 primFlipFaces(prim.get());
@@ -951,7 +1083,7 @@ struct WriteAlembicPrims : INode {
                                 uvsamp);
                         write_velocity(prim, mesh_samp);
                         write_normal(prim, mesh_samp);
-                        if (get_input2<bool>("outputToMaya") == false) {
+                        if (outputToMaya == false) {
                             write_attrs(verts_attrs, loops_attrs, polys_attrs, path, prim, mesh, frameid, real_frame_start, prim_size_per_frame[path]);
                         }
                         mesh.set( mesh_samp );
@@ -963,7 +1095,7 @@ struct WriteAlembicPrims : INode {
                                 Int32ArraySample( vertex_count_per_face.data(), vertex_count_per_face.size() ));
                         write_velocity(prim, mesh_samp);
                         write_normal(prim, mesh_samp);
-                        if (get_input2<bool>("outputToMaya") == false) {
+                        if (outputToMaya == false) {
                             write_attrs(verts_attrs, loops_attrs, polys_attrs, path, prim, mesh, frameid, real_frame_start, prim_size_per_frame[path]);
                         }
                         mesh.set( mesh_samp );
@@ -985,6 +1117,7 @@ ZENDEFNODE(WriteAlembicPrims, {
         {"float", "fps", "25"},
         {"bool", "flipFrontBack", "1"},
         {"bool", "outputToMaya", "0"},
+        {"bool", "asyncWrite", "1"},
     },
     {
     },
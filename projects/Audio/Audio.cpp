@@ -11,6 +11,8 @@
 #include <zeno/types/ListObject.h>
 #include "AudioFile.h"
 #include <algorithm>
+#include <cstring>
+#include <zeno/para/parallel_for.h>
 
 #define MINIMP3_IMPLEMENTATION
 #define MINIMP3_FLOAT_OUTPUT
@@ -436,6 +438,163 @@ static std::shared_ptr<PrimitiveObject> readMp3(std::string path) {
         },
     });
 
+    // whole-clip short time fourier transform, frames are windowed the same
+    // way as AudioFFT and transformed in parallel, the result is kept until
+    // the samples or the parameters change so a per-frame graph only has to
+    // look up its row
+    struct AudioSTFT : zeno::INode {
+        struct Cache {
+            std::size_t waveHash = 0;
+            std::vector<float> params;
+            std::shared_ptr<PrimitiveObject> spectrogram;
+            std::shared_ptr<PrimitiveObject> bands;
+        };
+
+        virtual void apply() override {
+            auto wave = get_input<PrimitiveObject>("wave");
+            int duration_count = get_input2<int>("duration_count");
+            int hop = get_input2<int>("hop");
+            int band_count = get_input2<int>("bandCount");
+            auto pre_emphasis = get_input2<int>("preEmphasis");
+            auto alpha = get_input2<float>("preEmphasisAlpha");
+            auto hamming_window = get_input2<int>("hammingWindow");
+            if (duration_count < 4 || (duration_count & (duration_count - 1)))
+                throw makeError("AudioSTFT: duration_count must be a power of two, got " + std::to_string(duration_count));
+            if (hop <= 0)
+                throw makeError("AudioSTFT: hop must be positive, got " + std::to_string(hop));
+            if (wave->size() == 0)
+                throw makeError("AudioSTFT: wave is empty");
+            float sampleFrequency = wave->userData().get<zeno::NumericObject>("SampleRate")->get<float>();
+            int bins = duration_count / 2 + 1;
+            band_count = std::clamp(band_count, 1, bins);
+
+            // hash the samples rather than trusting the wave object, which may
+            // have been edited in place since the last cook
+            auto &value = wave->attr<float>("value");
+            std::size_t waveHash = 14695981039346656037ull;
+            for (auto const &v: value) {
+                uint32_t bits;
+                std::memcpy(&bits, &v, sizeof(bits));
+                waveHash = (waveHash ^ bits) * 1099511628211ull;
+            }
+            std::vector<float> params{(float)value.size(), sampleFrequency, (float)duration_count, (float)hop,
+                                      (float)band_count, (float)pre_emphasis, alpha, (float)hamming_window};
+            if (!cache.spectrogram || cache.waveHash != waveHash || cache.params != params) {
+                cache.waveHash = waveHash;
+                cache.params = params;
+                compute(wave.get(), duration_count, hop, band_count, pre_emphasis, alpha, hamming_window,
+                        sampleFrequency);
+            }
+
+            int frames = cache.bands->userData().get2<int>("h");
+            int frame = int(sampleFrequency * get_input2<float>("time")) / hop;
+            frame = std::clamp(frame, 0, frames - 1);
+            // downstream nodes may modify their inputs, hand out copies
+            set_output("spectrogram", std::make_shared<PrimitiveObject>(*cache.spectrogram));
+            set_output("bands", std::make_shared<PrimitiveObject>(*cache.bands));
+            set_output("frame", std::make_shared<NumericObject>(frame));
+        }
+
+        void compute(PrimitiveObject *wave, int duration_count, int hop, int band_count, bool pre_emphasis,
+                     float alpha, bool hamming_window, float sampleFrequency) {
+            auto &value = wave->attr<float>("value");
+            int size = value.size();
+            int frames = std::max(1, (size + hop - 1) / hop);
+            int bins = duration_count / 2 + 1;
+
+            std::vector<double> window(duration_count, 1.0);
+            if (hamming_window) {
+                for (auto i = 0; i < duration_count; i++) {
+                    window[i] = 0.54 - 0.46 * std::cos(2.0 * M_PI * i / (duration_count - 1));
+                }
+            }
+
+            auto spectrogram = std::make_shared<PrimitiveObject>();
+            spectrogram->resize((size_t)frames * bins);
+            auto &power = spectrogram->add_attr<float>("power");
+            auto bands = std::make_shared<PrimitiveObject>();
+            bands->resize((size_t)frames * band_count);
+            auto &energy = bands->add_attr<float>("energy");
+            auto &t = bands->add_attr<float>("t");
+
+            auto transform = [&] (int f) {
+                // cdft rewrites the bit reversal table of its plan on every
+                // call, so plans can not be shared between threads
+                thread_local std::shared_ptr<Aquila::Fft> fft;
+                thread_local int fft_size = 0;
+                if (fft_size != duration_count) {
+                    fft = Aquila::FftFactory::getFft(duration_count);
+                    fft_size = duration_count;
+                }
+                thread_local std::vector<double> samples;
+                samples.resize(duration_count + 1);
+                int start_index = f * hop;
+                for (auto i = 0; i < duration_count + 1; i++) {
+                    samples[i] = value[min(start_index + i, size - 1)];
+                }
+                if (pre_emphasis) {
+                    for (auto i = 0; i < duration_count; i++) {
+                        samples[i] = samples[i+1] - alpha * samples[i];
+                    }
+                }
+                for (auto i = 0; i < duration_count; i++) {
+                    samples[i] *= window[i];
+                }
+                Aquila::SpectrumType spectrums = fft->fft(samples.data());
+
+                size_t row = (size_t)f * bins;
+                for (auto i = 0; i < bins; i++) {
+                    float r = spectrums[i].real();
+                    float im = spectrums[i].imag();
+                    spectrogram->verts[row + i] = vec3f(f, i, 0);
+                    power[row + i] = (r * r + im * im) / duration_count;
+                }
+                size_t band_row = (size_t)f * band_count;
+                for (auto b = 0; b < band_count; b++) {
+                    int s = b * bins / band_count, e = (b + 1) * bins / band_count;
+                    float E = 0;
+                    for (auto i = s; i < e; i++) {
+                        E += power[row + i];
+                    }
+                    bands->verts[band_row + b] = vec3f(f, b, 0);
+                    energy[band_row + b] = E;
+                    t[band_row + b] = (float)start_index / sampleFrequency;
+                }
+            };
+            parallel_for(frames, transform);
+
+            spectrogram->userData().set2("w", bins);
+            spectrogram->userData().set2("h", frames);
+            bands->userData().set2("w", band_count);
+            bands->userData().set2("h", frames);
+            cache.spectrogram = std::move(spectrogram);
+            cache.bands = std::move(bands);
+        }
+
+        Cache cache;
+    };
+    ZENDEFNODE(AudioSTFT, {
+        {
+            "wave",
+            {"float", "time", "0"},
+            {"bool", "preEmphasis", "0"},
+            {"float", "preEmphasisAlpha", "0.97"},
+            {"bool", "hammingWindow", "1"},
+            {"int", "duration_count", "1024"},
+            {"int", "hop", "512"},
+            {"int", "bandCount", "8"},
+        },
+        {
+            "spectrogram",
+            "bands",
+            "frame",
+        },
+        {},
+        {
+            "audio"
+        },
+    });
+
     struct AudioTrim : zeno::INode {
         virtual void apply() override {
             auto audio = get_input<PrimitiveObject>("audio");
@@ -232,6 +232,31 @@ public:
         field_helper.iterateGridParallel(copyU, 1);
         field_helper.iterateGridParallel(copyP, 1);
     };
+    // grid node and kind (0: P, 1: Y, 2: H) of every dof, in the [P, Y, H] order of the built system
+    void collect_dof_layout(FieldHelper& field_helper, std::vector<IV>& coords, std::vector<int>& kinds)
+    {
+        StorageIndex n_P = global_operators.Linear_P.size(), n_Y = global_operators.Linear_Y.size(), n_H = global_operators.Linear_H.size();
+        coords.assign(n_P + n_Y + n_H, IV::Zero());
+        kinds.assign(n_P + n_Y + n_H, 0);
+        auto collect = [&](const IV& I) {
+            StorageIndex idP = get_idP(field_helper, I);
+            StorageIndex idY = get_idY(field_helper, I);
+            StorageIndex idH = get_idH(field_helper, I);
+            if (idP >= 0) {
+                coords[idP] = I;
+                kinds[idP] = 0;
+            }
+            if (idY >= 0) {
+                coords[n_P + idY] = I;
+                kinds[n_P + idY] = 1;
+            }
+            if (idH >= 0) {
+                coords[n_P + n_Y + idH] = I;
+                kinds[n_P + n_Y + idH] = 2;
+            }
+        };
+        field_helper.iterateGridParallel(collect, 1);
+    };
     virtual void copy_from_spatial_field(FieldHelper& field_helper){};
     virtual void copy_to_spatial_field(FieldHelper& field_helper){};
     // for diagonal mass/stiffness matrix
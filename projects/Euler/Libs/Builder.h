@@ -2,6 +2,7 @@
 #define LINEAR_BUILDER_H
 
 #include "Assembler.h"
+#include "Multigrid.h"
 
 namespace ZenEulerGas {
 namespace LinearProjection {
@@ -11,12 +12,18 @@ class Builder {
 public:
     using IJK = Eigen::Triplet<T>;
     Eigen::ConjugateGradient<Eigen::SparseMatrix<T, Eigen::ColMajor, StorageIndex>, Eigen::Lower | Eigen::Upper> solver;
+    Eigen::ConjugateGradient<Eigen::SparseMatrix<T, Eigen::ColMajor, StorageIndex>, Eigen::Lower | Eigen::Upper, MultigridPreconditioner<T, dim, StorageIndex>> mg_solver;
     Eigen::SparseMatrix<T, Eigen::ColMajor, StorageIndex> A;
     Vector<T, Eigen::Dynamic> RHS;
     Vector<T, Eigen::Dynamic> x;
 
     T dx;
 
+    // multigrid preconditioned CG, needs the grid node of every dof (see AssemblerBase::collect_dof_layout)
+    bool use_multigrid = false;
+    std::vector<Vector<int, dim>> dof_coords;
+    std::vector<int> dof_kinds;
+
     Builder(T dx_)
         : dx(dx_){};
 
@@ -83,6 +90,18 @@ public:
     {
         // BOW_TIMER_FLAG("Solve");
         // Logging::debug("Solve");
+        if (use_multigrid && (StorageIndex)dof_coords.size() == A.rows()) {
+            if (compute) {
+                mg_solver.setMaxIterations(it_limit);
+                mg_solver.setTolerance(converge_cretiria);
+                mg_solver.preconditioner().set_dof_layout(dof_coords, dof_kinds);
+                mg_solver.compute(A);
+            }
+            x = mg_solver.solve(RHS);
+            // Logging::info("#iterations:     ", mg_solver.iterations());
+            // Logging::info("estimated error: ", mg_solver.error());
+            return;
+        }
         if (compute) {
             solver.setMaxIterations(it_limit);
             solver.setTolerance(converge_cretiria);
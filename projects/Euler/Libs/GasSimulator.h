@@ -26,6 +26,7 @@ struct solverControl {
     bool add_source_term = false;
     T cg_converge_cretiria = 1e-7;
     int cg_it_limit = 500;
+    bool use_multigrid = true;
     bool output_vtk = false;
     // calculating dt
     T dt_min = 5e-10;
@@ -69,6 +70,7 @@ public:
     bool add_source_term = false;
     T cg_converge_cretiria = 1e-7;
     int cg_it_limit = 500;
+    bool use_multigrid = true;
     bool output_vtk = false;
     // calculating dt
     T dt_min = 5e-10;
@@ -128,6 +130,7 @@ public:
         _sc.add_source_term = add_source_term;
         _sc.cg_converge_cretiria = cg_converge_cretiria;
         _sc.cg_it_limit = cg_it_limit;
+        _sc.use_multigrid = use_multigrid;
         _sc.output_vtk = output_vtk;
         _sc.dt_min = dt_min;
         _sc.dt_max = dt_max;
@@ -153,6 +156,7 @@ public:
         add_source_term = _sc.add_source_term;
         cg_converge_cretiria = _sc.cg_converge_cretiria;
         cg_it_limit = _sc.cg_it_limit;
+        use_multigrid = _sc.use_multigrid;
         output_vtk = _sc.output_vtk;
         dt_min = _sc.dt_min;
         dt_max = _sc.dt_max;
@@ -311,6 +315,9 @@ public:
 
         gas_assembler.copy_from_spatial_field(field_helper);
         gas_assembler.assemble(field_helper, field_helper.B_interfaces, field_helper.H_interfaces, field_helper.moving_Yf_interfaces_override, (substep > 0));
+        sys_builder.use_multigrid = use_multigrid;
+        if (use_multigrid && substep == 0)
+            gas_assembler.collect_dof_layout(field_helper, sys_builder.dof_coords, sys_builder.dof_kinds);
         sys_builder.build_and_solve(dt, gas_assembler.global_operators, (substep > 0), cg_it_limit, cg_converge_cretiria);
         gas_assembler.copy_to_spatial_field(field_helper);
 
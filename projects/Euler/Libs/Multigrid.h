@@ -0,0 +1,502 @@
+#ifndef LINEAR_MULTIGRID_H
+#define LINEAR_MULTIGRID_H
+
+#include "Types.h"
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <tbb/tbb.h>
+
+namespace ZenEulerGas {
+namespace LinearProjection {
+
+// Geometric multigrid V-cycle used as the preconditioner of the projection CG.
+// Every dof of the linear system lives on a grid node (P, Y and H dofs are all
+// attached to field_helper.grid[I]), so the hierarchy is built by vertex-centered
+// coarsening of those nodes: coarse node J sits on fine node 2J, prolongation is
+// multilinear and coarse operators are Galerkin (R A P). Dofs of different kinds
+// are never mixed into the same coarse dof.
+// The B1B0 operators only couple nodes at most one cell apart, so coloring the
+// nodes by the parity of their coordinates (red-black generalized to 2^dim colors)
+// gives independent sets that are smoothed in parallel with TBB. Levels whose
+// stencil happens to be wider fall back to damped Jacobi.
+// The hierarchy is kept across compute calls: an identical matrix reuses it as is,
+// and a matrix with the same sparsity pattern and dof layout only recomputes the
+// Galerkin products on the existing prolongations.
+template <class T, int dim, class StorageIndex>
+class MultigridPreconditioner {
+public:
+    using IV = Vector<int, dim>;
+    using SpMat = Eigen::SparseMatrix<T, Eigen::RowMajor, StorageIndex>;
+    using TVec = Vector<T, Eigen::Dynamic>;
+    typedef T Scalar;
+    typedef TVec VectorType;
+    enum {
+        ColsAtCompileTime = Eigen::Dynamic,
+        MaxColsAtCompileTime = Eigen::Dynamic
+    };
+
+    struct Level {
+        SpMat A;
+        // prolongation (fine x coarse) and restriction (its transpose) to the next level
+        SpMat P, R;
+        TVec inv_diag;
+        std::vector<IV> coords;
+        std::vector<int> kinds;
+        // rows sorted by (color, node), nodes are contiguous runs in order
+        std::vector<StorageIndex> order;
+        std::vector<StorageIndex> node_begin;
+        std::vector<StorageIndex> color_begin;
+        bool colored = false;
+        // workspace
+        mutable TVec x, b, r;
+    };
+
+    // control
+    int pre_smooth = 2;
+    int post_smooth = 2;
+    int max_levels = 12;
+    StorageIndex coarsest_size = 2048;
+    T jacobi_weight = (T)2 / (T)3;
+
+    MultigridPreconditioner()
+        : m_info(Eigen::Success){};
+
+    template <class MatType>
+    explicit MultigridPreconditioner(const MatType& mat)
+        : m_info(Eigen::Success)
+    {
+        compute(mat);
+    }
+
+    // grid coordinates and kind (0: P, 1: Y, 2: H) of each dof, must be set before compute
+    void set_dof_layout(const std::vector<IV>& coords, const std::vector<int>& kinds)
+    {
+        if (coords == m_coords && kinds == m_kinds)
+            return;
+        m_coords = coords;
+        m_kinds = kinds;
+        m_layout_changed = true;
+    }
+
+    Eigen::Index rows() const { return levels.empty() ? 0 : levels[0].A.rows(); }
+    Eigen::Index cols() const { return levels.empty() ? 0 : levels[0].A.cols(); }
+    int num_levels() const { return (int)levels.size(); }
+
+    template <class MatType>
+    MultigridPreconditioner& analyzePattern(const MatType&)
+    {
+        return *this;
+    }
+
+    template <class MatType>
+    MultigridPreconditioner& factorize(const MatType& mat)
+    {
+        return compute(mat);
+    }
+
+    template <class MatType>
+    MultigridPreconditioner& compute(const MatType& mat)
+    {
+        // BOW_TIMER_FLAG("MG Setup");
+        SpMat A = mat;
+        A.makeCompressed();
+        if (!m_layout_changed && !levels.empty() && same_pattern(levels[0].A, A)) {
+            if (std::equal(A.valuePtr(), A.valuePtr() + A.nonZeros(), levels[0].A.valuePtr())) {
+                m_info = Eigen::Success;
+                return *this;
+            }
+            // same stencils on the same nodes: keep P and R, redo the coarse operators
+            levels[0].A = std::move(A);
+            setup_smoother(levels[0]);
+            for (size_t lv = 1; lv < levels.size(); ++lv) {
+                galerkin(levels[lv - 1], levels[lv]);
+                setup_smoother(levels[lv]);
+            }
+        }
+        else {
+            levels.clear();
+            levels.emplace_back();
+            levels[0].A = std::move(A);
+            if ((StorageIndex)m_coords.size() == levels[0].A.rows()) {
+                levels[0].coords = m_coords;
+                levels[0].kinds = m_kinds.size() == m_coords.size() ? m_kinds : std::vector<int>(m_coords.size(), 0);
+            }
+            setup_smoother(levels[0]);
+
+            // without a dof layout there is no geometry to coarsen, degrade to a smoother
+            while (!levels.back().coords.empty() && (int)levels.size() < max_levels && levels.back().A.rows() > coarsest_size) {
+                Level coarse;
+                if (!coarsen(levels.back(), coarse))
+                    break;
+                setup_smoother(coarse);
+                levels.push_back(std::move(coarse));
+            }
+            m_layout_changed = false;
+        }
+
+        m_coarse_solver_ok = false;
+        if (levels.size() > 1 || levels[0].A.rows() <= coarsest_size) {
+            Eigen::SparseMatrix<T, Eigen::ColMajor, StorageIndex> Ac = levels.back().A;
+            m_coarse_solver.compute(Ac);
+            m_coarse_solver_ok = (m_coarse_solver.info() == Eigen::Success);
+        }
+        // Logging::info("multigrid levels: ", levels.size());
+        m_info = Eigen::Success;
+        return *this;
+    }
+
+    template <class Rhs>
+    TVec solve(const Eigen::MatrixBase<Rhs>& b) const
+    {
+        TVec x;
+        if (levels.empty()) {
+            x = b;
+            return x;
+        }
+        levels[0].b = b;
+        v_cycle(0);
+        return levels[0].x;
+    }
+
+    Eigen::ComputationInfo info() { return m_info; }
+
+protected:
+    std::vector<Level> levels;
+    std::vector<IV> m_coords;
+    std::vector<int> m_kinds;
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<T, Eigen::ColMajor, StorageIndex>> m_coarse_solver;
+    bool m_coarse_solver_ok = false;
+    bool m_layout_changed = true;
+    Eigen::ComputationInfo m_info;
+
+    static int color_of(const IV& I)
+    {
+        int c = 0;
+        for (int d = 0; d < dim; d++)
+            c |= (I(d) & 1) << d;
+        return c;
+    }
+
+    static bool coords_less(const IV& a, const IV& b)
+    {
+        for (int d = dim - 1; d >= 0; d--)
+            if (a(d) != b(d))
+                return a(d) < b(d);
+        return false;
+    }
+
+    static int floor_div2(int i)
+    {
+        return (i >= 0) ? i / 2 : -((-i + 1) / 2);
+    }
+
+    static bool same_pattern(const SpMat& a, const SpMat& b)
+    {
+        return a.rows() == b.rows() && a.cols() == b.cols() && a.nonZeros() == b.nonZeros()
+            && std::equal(a.outerIndexPtr(), a.outerIndexPtr() + a.outerSize() + 1, b.outerIndexPtr())
+            && std::equal(a.innerIndexPtr(), a.innerIndexPtr() + a.nonZeros(), b.innerIndexPtr());
+    }
+
+    void setup_smoother(Level& l) const
+    {
+        StorageIndex n = l.A.rows();
+        l.inv_diag.resize(n);
+        tbb::parallel_for((StorageIndex)0, n, [&](StorageIndex i) {
+            T a = l.A.coeff(i, i);
+            l.inv_diag[i] = a != 0 ? (T)1 / a : (T)0;
+        });
+        l.x.setZero(n);
+        l.b.setZero(n);
+        l.r.setZero(n);
+
+        l.colored = false;
+        if (l.coords.empty())
+            return;
+        // independent sets are only valid if nodes couple within one cell
+        bool narrow = tbb::parallel_reduce(
+            tbb::blocked_range<StorageIndex>(0, n), true,
+            [&](const tbb::blocked_range<StorageIndex>& range, bool ok) {
+                for (StorageIndex i = range.begin(); ok && i < range.end(); ++i)
+                    for (typename SpMat::InnerIterator it(l.A, i); it; ++it)
+                        if (((l.coords[i] - l.coords[it.col()]).cwiseAbs().array() > 1).any()) {
+                            ok = false;
+                            break;
+                        }
+                return ok;
+            },
+            [](bool a, bool b) { return a && b; });
+        if (!narrow)
+            return;
+
+        l.order.resize(n);
+        for (StorageIndex i = 0; i < n; ++i)
+            l.order[i] = i;
+        tbb::parallel_sort(l.order.begin(), l.order.end(), [&](StorageIndex a, StorageIndex b) {
+            int ca = color_of(l.coords[a]), cb = color_of(l.coords[b]);
+            if (ca != cb)
+                return ca < cb;
+            if (l.coords[a] != l.coords[b])
+                return coords_less(l.coords[a], l.coords[b]);
+            return a < b;
+        });
+        l.node_begin.clear();
+        l.color_begin.assign((1 << dim) + 1, 0);
+        for (StorageIndex k = 0; k < n; ++k) {
+            if (k == 0 || l.coords[l.order[k]] != l.coords[l.order[k - 1]]) {
+                int c = color_of(l.coords[l.order[k]]);
+                l.node_begin.push_back(k);
+                l.color_begin[c + 1] = (StorageIndex)l.node_begin.size();
+            }
+        }
+        l.node_begin.push_back(n);
+        // colors without any node inherit the end of the previous one
+        for (int c = 1; c <= (1 << dim); c++)
+            l.color_begin[c] = std::max(l.color_begin[c], l.color_begin[c - 1]);
+        l.colored = true;
+    }
+
+    bool coarsen(Level& fine, Level& coarse) const
+    {
+        StorageIndex n = fine.A.rows();
+        // a fine node I is interpolated from the coarse nodes J with |I - 2J| <= 1,
+        // one per odd coordinate choice, with multilinear weights that sum to one.
+        // coarse dofs are identified by a packed (kind, J) key whose order is
+        // kind first, then the coordinates from the last axis down
+        const int bits = 62 / dim;
+        std::pair<IV, IV> bounds = tbb::parallel_reduce(
+            tbb::blocked_range<StorageIndex>(0, n), std::pair<IV, IV>(IV::Constant(std::numeric_limits<int>::max()), IV::Constant(std::numeric_limits<int>::min())),
+            [&](const tbb::blocked_range<StorageIndex>& range, std::pair<IV, IV> b) {
+                for (StorageIndex i = range.begin(); i < range.end(); ++i) {
+                    b.first = b.first.cwiseMin(fine.coords[i]);
+                    b.second = b.second.cwiseMax(fine.coords[i]);
+                }
+                return b;
+            },
+            [](const std::pair<IV, IV>& a, const std::pair<IV, IV>& b) {
+                return std::pair<IV, IV>(a.first.cwiseMin(b.first), a.second.cwiseMax(b.second));
+            });
+        IV J_min;
+        for (int d = 0; d < dim; d++) {
+            J_min(d) = floor_div2(bounds.first(d));
+            if ((int64_t)floor_div2(bounds.second(d)) + 1 - J_min(d) >= ((int64_t)1 << bits))
+                return false;
+        }
+        auto make_key = [&](int kind, const IV& J) {
+            uint64_t key = (uint64_t)kind;
+            for (int d = dim - 1; d >= 0; d--)
+                key = (key << bits) | (uint64_t)(J(d) - J_min(d));
+            return key;
+        };
+        auto stencil_size = [&](const IV& I) {
+            int n_odd = 0;
+            for (int d = 0; d < dim; d++)
+                n_odd += I(d) & 1;
+            return 1 << n_odd;
+        };
+        auto for_stencil = [&](const IV& I, auto&& f) {
+            for (int s = 0; s < stencil_size(I); s++) {
+                IV J;
+                T w = 1;
+                int bit = 0;
+                for (int d = 0; d < dim; d++) {
+                    J(d) = floor_div2(I(d));
+                    if (I(d) & 1) {
+                        J(d) += (s >> bit++) & 1;
+                        w *= (T)0.5;
+                    }
+                }
+                f(J, w);
+            }
+        };
+
+        std::vector<StorageIndex> offsets(n + 1, 0);
+        for (StorageIndex i = 0; i < n; ++i)
+            offsets[i + 1] = offsets[i] + stencil_size(fine.coords[i]);
+        StorageIndex nnz = offsets[n];
+        std::vector<uint64_t> keys(nnz);
+        tbb::parallel_for((StorageIndex)0, n, [&](StorageIndex i) {
+            StorageIndex k = offsets[i];
+            for_stencil(fine.coords[i], [&](const IV& J, T) { keys[k++] = make_key(fine.kinds[i], J); });
+        });
+        tbb::parallel_sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        keys.shrink_to_fit();
+        StorageIndex nc = (StorageIndex)keys.size();
+        // stop when coarsening stalls, e.g. on thin slabs
+        if (nc == 0 || nc * 10 > n * 8)
+            return false;
+
+        coarse.coords.resize(nc);
+        coarse.kinds.resize(nc);
+        const uint64_t mask = ((uint64_t)1 << bits) - 1;
+        tbb::parallel_for((StorageIndex)0, nc, [&](StorageIndex c) {
+            uint64_t key = keys[c];
+            for (int d = 0; d < dim; d++) {
+                coarse.coords[c](d) = (int)(key & mask) + J_min(d);
+                key >>= bits;
+            }
+            coarse.kinds[c] = (int)key;
+        });
+
+        fine.P.resize(n, nc);
+        fine.P.resizeNonZeros(nnz);
+        std::copy(offsets.begin(), offsets.end(), fine.P.outerIndexPtr());
+        tbb::parallel_for((StorageIndex)0, n, [&](StorageIndex i) {
+            StorageIndex begin = offsets[i], k = begin;
+            for_stencil(fine.coords[i], [&](const IV& J, T w) {
+                fine.P.innerIndexPtr()[k] = (StorageIndex)(std::lower_bound(keys.begin(), keys.end(), make_key(fine.kinds[i], J)) - keys.begin());
+                fine.P.valuePtr()[k++] = w;
+            });
+            // columns of a row in increasing order, insertion sort over at most 2^dim entries
+            for (StorageIndex a = begin + 1; a < k; ++a)
+                for (StorageIndex b = a; b > begin && fine.P.innerIndexPtr()[b - 1] > fine.P.innerIndexPtr()[b]; --b) {
+                    std::swap(fine.P.innerIndexPtr()[b - 1], fine.P.innerIndexPtr()[b]);
+                    std::swap(fine.P.valuePtr()[b - 1], fine.P.valuePtr()[b]);
+                }
+        });
+        fine.R = fine.P.transpose();
+        galerkin(fine, coarse);
+        return true;
+    }
+
+    // coarse.A = R A P, one coarse row per task accumulated into a dense per-thread
+    // row (Gustavson); exact zeros are dropped
+    void galerkin(const Level& fine, Level& coarse) const
+    {
+        using Coeff = std::pair<StorageIndex, T>;
+        struct Accumulator {
+            std::vector<T> value;
+            std::vector<StorageIndex> mark, cols;
+        };
+        StorageIndex nc = fine.R.rows();
+        std::vector<std::vector<Coeff>> rows(nc);
+        tbb::enumerable_thread_specific<Accumulator> scratch;
+        tbb::parallel_for((StorageIndex)0, nc, [&](StorageIndex I) {
+            Accumulator& acc = scratch.local();
+            if ((StorageIndex)acc.mark.size() != nc) {
+                acc.value.assign(nc, 0);
+                acc.mark.assign(nc, -1);
+            }
+            acc.cols.clear();
+            for (typename SpMat::InnerIterator r(fine.R, I); r; ++r)
+                for (typename SpMat::InnerIterator a(fine.A, r.col()); a; ++a) {
+                    T ra = r.value() * a.value();
+                    for (typename SpMat::InnerIterator p(fine.P, a.col()); p; ++p) {
+                        StorageIndex J = p.col();
+                        if (acc.mark[J] != I) {
+                            acc.mark[J] = I;
+                            acc.value[J] = 0;
+                            acc.cols.push_back(J);
+                        }
+                        acc.value[J] += ra * p.value();
+                    }
+                }
+            std::sort(acc.cols.begin(), acc.cols.end());
+            std::vector<Coeff>& row = rows[I];
+            row.reserve(acc.cols.size());
+            for (StorageIndex J : acc.cols)
+                if (acc.value[J] != 0)
+                    row.emplace_back(J, acc.value[J]);
+        });
+
+        coarse.A.resize(nc, nc);
+        StorageIndex* outer = coarse.A.outerIndexPtr();
+        outer[0] = 0;
+        for (StorageIndex I = 0; I < nc; ++I)
+            outer[I + 1] = outer[I] + (StorageIndex)rows[I].size();
+        coarse.A.resizeNonZeros(outer[nc]);
+        tbb::parallel_for((StorageIndex)0, nc, [&](StorageIndex I) {
+            StorageIndex k = coarse.A.outerIndexPtr()[I];
+            for (const Coeff& c : rows[I]) {
+                coarse.A.innerIndexPtr()[k] = c.first;
+                coarse.A.valuePtr()[k++] = c.second;
+            }
+        });
+    }
+
+    void residual(const Level& l) const
+    {
+        tbb::parallel_for(tbb::blocked_range<StorageIndex>(0, l.A.rows()), [&](const tbb::blocked_range<StorageIndex>& range) {
+            for (StorageIndex i = range.begin(); i < range.end(); ++i) {
+                T sum = l.b[i];
+                for (typename SpMat::InnerIterator it(l.A, i); it; ++it)
+                    sum -= it.value() * l.x[it.col()];
+                l.r[i] = sum;
+            }
+        });
+    }
+
+    inline void relax_row(const Level& l, StorageIndex i) const
+    {
+        T sum = l.b[i];
+        for (typename SpMat::InnerIterator it(l.A, i); it; ++it)
+            sum -= it.value() * l.x[it.col()];
+        l.x[i] += sum * l.inv_diag[i];
+    }
+
+    // forward sweeps for pre-smoothing, reversed sweeps for post-smoothing,
+    // which keeps the V-cycle symmetric as CG requires
+    void smooth(const Level& l, int iterations, bool reverse) const
+    {
+        for (int iter = 0; iter < iterations; ++iter) {
+            if (!l.colored) {
+                residual(l);
+                l.x += jacobi_weight * l.inv_diag.cwiseProduct(l.r);
+                continue;
+            }
+            int n_color = 1 << dim;
+            for (int c_ = 0; c_ < n_color; ++c_) {
+                int c = reverse ? n_color - 1 - c_ : c_;
+                tbb::parallel_for(l.color_begin[c], l.color_begin[c + 1], [&](StorageIndex node) {
+                    StorageIndex begin = l.node_begin[node], end = l.node_begin[node + 1];
+                    if (!reverse)
+                        for (StorageIndex k = begin; k < end; ++k)
+                            relax_row(l, l.order[k]);
+                    else
+                        for (StorageIndex k = end - 1; k >= begin; --k)
+                            relax_row(l, l.order[k]);
+                });
+            }
+        }
+    }
+
+    void v_cycle(size_t lv) const
+    {
+        const Level& l = levels[lv];
+        if (lv + 1 == levels.size()) {
+            if (m_coarse_solver_ok)
+                l.x = m_coarse_solver.solve(l.b);
+            else {
+                l.x.setZero(l.A.rows());
+                smooth(l, pre_smooth + post_smooth, false);
+                smooth(l, pre_smooth + post_smooth, true);
+            }
+            return;
+        }
+        const Level& c = levels[lv + 1];
+        l.x.setZero(l.A.rows());
+        smooth(l, pre_smooth, false);
+        residual(l);
+        tbb::parallel_for((StorageIndex)0, (StorageIndex)c.A.rows(), [&](StorageIndex i) {
+            T sum = 0;
+            for (typename SpMat::InnerIterator it(l.R, i); it; ++it)
+                sum += it.value() * l.r[it.col()];
+            c.b[i] = sum;
+        });
+        v_cycle(lv + 1);
+        tbb::parallel_for((StorageIndex)0, (StorageIndex)l.A.rows(), [&](StorageIndex i) {
+            T sum = 0;
+            for (typename SpMat::InnerIterator it(l.P, i); it; ++it)
+                sum += it.value() * c.x[it.col()];
+            l.x[i] += sum;
+        });
+        smooth(l, post_smooth, true);
+    }
+};
+}
+} // namespace ZenEulerGas::LinearProjection
+
+#endif
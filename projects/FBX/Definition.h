@@ -33,6 +33,10 @@ std::cout.setstate(std::ios::failbit); std::cout \
 #include <zeno/utils/log.h>
 #include <zeno/utils/vec.h>
 #include <zeno/core/IObject.h>
+#include <memory>
+#include <string>
+
+struct aiScene;
 
 inline namespace ZenoFBXDefinition {
 
@@ -58,6 +62,11 @@ struct SFBXReadOption {
     float offsetInSeconds = 0.0f;
 };
 
+// assimp scene parsed once per process and shared by the FBX nodes, it is only
+// parsed again when the file (mtime or size) or the import flags change;
+// nullptr if the file can't be read
+std::shared_ptr<aiScene const> FBXLoadScene(std::string const &path, unsigned int flags);
+
 struct SFBXEvalOption {
     bool writeData = false;
     bool interAnimData = false;
@@ -572,6 +581,58 @@ struct AnimInfo : zeno::IObjectClone<AnimInfo>{
     float minTimeStamp;
 };
 
+// NodeTree, BoneTree and the skin weights flattened for EvalFBXAnim: nodes in
+// depth-first order so a parent always comes before its children, keyframes of
+// all the animated nodes packed per channel, and bones referred to by index,
+// built once and reused by every frame evaluated on the same data
+struct SFBXEvalRig {
+    struct Node {
+        std::string name;
+        std::string path;   // "/root/.../name", the key of the lazy transforms
+        aiMatrix4x4 transformation;
+        aiMatrix4x4 offset;
+        int parent = -1;
+        int anim = -1;      // index into anims, -1 if the node has no key-anim
+        int boneSlot = -1;  // index into boneNames, -1 if no bone offset
+    };
+
+    struct Channel {
+        int begin = 0;
+        int count = 0;
+    };
+
+    struct Anim {
+        Channel position;
+        Channel rotation;
+        Channel scale;
+    };
+
+    std::vector<Node> nodes;
+    std::unordered_map<std::string, int> pathIndex;
+    std::vector<std::string> boneNames;
+
+    std::vector<Anim> anims;
+    std::vector<float> positionTimes;
+    std::vector<aiVector3D> positionKeys;
+    std::vector<float> rotationTimes;
+    std::vector<aiQuaternion> rotationKeys;
+    std::vector<float> scaleTimes;
+    std::vector<aiVector3D> scaleKeys;
+
+    // influences of vertex i are [skinBegin[i], skinBegin[i + 1])
+    std::vector<int> skinBegin;
+    std::vector<int> skinBone;
+    std::vector<int> skinJoint;
+    std::vector<float> skinWeight;
+    int maxInfluence = 0;
+
+    // what the rig was built from, to tell when it is stale
+    std::weak_ptr<NodeTree const> nodeTree;
+    std::weak_ptr<BoneTree const> boneTree;
+    SVertex const *vertices = nullptr;
+    size_t numVertices = 0;
+};
+
 struct IMaterial : zeno::IObjectClone<IMaterial>{
     std::unordered_map<std::string, SMaterial> value;  // key: meshName
 };
@@ -646,6 +707,9 @@ struct FBXData : zeno::IObjectClone<FBXData>{
     std::shared_ptr<BoneTree> boneTree;
     std::shared_ptr<NodeTree> nodeTree;
     std::shared_ptr<AnimInfo> animInfo;
+
+    // compiled by EvalFBXAnim on first use
+    std::shared_ptr<SFBXEvalRig const> evalRig;
 };
 
 struct IFBXData : zeno::IObjectClone<IFBXData>{
@@ -7,6 +7,7 @@
 #include <zeno/types/DictObject.h>
 #include <zeno/types/CameraObject.h>
 #include <zeno/types/UserData.h>
+#include <zeno/para/parallel_for.h>
 
 #include "assimp/scene.h"
 
@@ -18,51 +19,154 @@
 #include <glm/mat4x4.hpp>
 
 #include <unordered_map>
+#include <algorithm>
+#include <memory>
+#include <vector>
 
 namespace {
 
+glm::mat4 toGlmMat4(aiMatrix4x4 const &tr) {
+    return glm::mat4(tr.a1,tr.b1,tr.c1,tr.d1,
+                     tr.a2,tr.b2,tr.c2,tr.d2,
+                     tr.a3,tr.b3,tr.c3,tr.d3,
+                     tr.a4,tr.b4,tr.c4,tr.d4);
+}
+
+// same as SAnimBone::get*Index and SAnimBone::getScaleFactor, but binary
+// searching the packed key times
+float keyFactor(float const *times, int count, float animationTime, int &i0, int &i1) {
+    i0 = std::lower_bound(times + 1, times + count, animationTime) - (times + 1);
+    i1 = std::min(i0 + 1, count - 1);
+    if (animationTime <= times[i0]) {
+        return 0.0f;
+    } else if (animationTime >= times[i1]) {
+        return 1.0f;
+    }
+    return (animationTime - times[i0]) / (times[i1] - times[i0]);
+}
+
+std::shared_ptr<SFBXEvalRig const> compileRig(std::shared_ptr<NodeTree> const &nodeTree,
+                                              std::shared_ptr<BoneTree> const &boneTree,
+                                              std::shared_ptr<FBXData> const &fbxData) {
+    auto rig = std::make_shared<SFBXEvalRig>();
+    auto const &vertices = fbxData->iVertices.value;
+    auto const &boneOffsets = fbxData->iBoneOffset.value;
+    auto const &animBones = boneTree->AnimBoneMap;
+    rig->nodeTree = nodeTree;
+    rig->boneTree = boneTree;
+    rig->vertices = vertices.data();
+    rig->numVertices = vertices.size();
+
+    std::unordered_map<std::string, int> boneSlots;
+    auto boneSlot = [&] (std::string const &boneName) {
+        auto [it, inserted] = boneSlots.try_emplace(boneName, (int)rig->boneNames.size());
+        if (inserted)
+            rig->boneNames.push_back(boneName);
+        return it->second;
+    };
+
+    // depth-first, children pushed reversed to visit them in the tree order
+    std::unordered_map<std::string, int> jointIndex;
+    std::vector<std::pair<NodeTree const *, int>> stack{{nodeTree.get(), -1}};
+    while (!stack.empty()) {
+        auto [node, parent] = stack.back();
+        stack.pop_back();
+        int index = rig->nodes.size();
+        auto &n = rig->nodes.emplace_back();
+        n.name = node->name;
+        n.path = (parent == -1 ? std::string() : rig->nodes[parent].path) + "/" + node->name;
+        n.transformation = node->transformation;
+        n.parent = parent;
+        rig->pathIndex[n.path] = index;
+        jointIndex[n.name] = index;
+
+        if (auto it = animBones.find(n.name); it != animBones.end()) {
+            auto const &bone = it->second;
+            auto &anim = rig->anims.emplace_back();
+            anim.position = {(int)rig->positionTimes.size(), (int)bone.m_Positions.size()};
+            for (auto const &key: bone.m_Positions) {
+                rig->positionTimes.push_back(key.timeStamp);
+                rig->positionKeys.push_back(key.position);
+            }
+            anim.rotation = {(int)rig->rotationTimes.size(), (int)bone.m_Rotations.size()};
+            for (auto const &key: bone.m_Rotations) {
+                rig->rotationTimes.push_back(key.timeStamp);
+                rig->rotationKeys.push_back(key.orientation);
+            }
+            anim.scale = {(int)rig->scaleTimes.size(), (int)bone.m_Scales.size()};
+            for (auto const &key: bone.m_Scales) {
+                rig->scaleTimes.push_back(key.timeStamp);
+                rig->scaleKeys.push_back(key.scale);
+            }
+            n.anim = rig->anims.size() - 1;
+        }
+
+        if (auto it = boneOffsets.find(n.name); it != boneOffsets.end()) {
+            n.offset = it->second.offset;
+            n.boneSlot = boneSlot(it->second.name);
+        }
+
+        for (int i = node->childrenCount - 1; i >= 0; i--)
+            stack.emplace_back(&node->children[i], index);
+    }
+
+    // bones only known by the weights stay identity, as before
+    rig->skinBegin.reserve(vertices.size() + 1);
+    rig->skinBegin.push_back(0);
+    for (auto const &v: vertices) {
+        for (auto const &[boneName, weight]: v.boneWeights) {
+            auto it = jointIndex.find(boneName);
+            rig->skinBone.push_back(boneSlot(boneName));
+            rig->skinJoint.push_back(it == jointIndex.end() ? 0 : it->second);
+            rig->skinWeight.push_back(weight);
+        }
+        rig->skinBegin.push_back(rig->skinBone.size());
+        rig->maxInfluence = std::max(rig->maxInfluence, (int)v.boneWeights.size());
+    }
+    return rig;
+}
+
 struct EvalAnim{
     float m_CurrentFrame;
     float m_DeltaTime;
 
     SFBXEvalOption m_evalOption;
-    NodeTree m_RootNode;
     SFBXData m_FbxData;
     AnimInfo m_animInfo;
     IMeshName m_meshName;
     IPathName m_pathName;
     IPathTrans m_PathTrans;
 
-    std::unordered_map<std::string, aiMatrix4x4> m_BoneTransforms;
-    std::unordered_map<std::string, aiMatrix4x4> m_LazyTransforms;
-    std::unordered_map<std::string, SBoneOffset> m_BoneOffset;
-    std::unordered_map<std::string, SAnimBone> m_AnimBones;
-
-    std::vector<SVertex> m_Vertices;
-    std::vector<unsigned int> m_IndicesTris;
-    std::vector<unsigned int> m_IndicesLoops;
-    std::vector<zeno::vec2i> m_IndicesPolys;
+    std::shared_ptr<FBXData> m_Data;
+    std::shared_ptr<SFBXEvalRig const> m_Rig;
 
-    std::unordered_map<std::string, int> m_JointCorrespondingIndex;
+    // by node index, the lazy transforms
+    std::vector<aiMatrix4x4> m_GlobalTransforms;
+    // by bone slot, the final bone matrices
+    std::vector<aiMatrix4x4> m_BoneTransforms;
 
     void initAnim(std::shared_ptr<NodeTree>& nodeTree,
                   std::shared_ptr<BoneTree>& boneTree,
                   std::shared_ptr<FBXData>& fbxData,
                   std::shared_ptr<AnimInfo>& animInfo){
         m_animInfo = *animInfo;
-
-        m_Vertices = fbxData->iVertices.value;
-        m_IndicesTris = fbxData->iIndices.valueTri;
-        m_IndicesPolys = fbxData->iIndices.valuePolys;
-        m_IndicesLoops = fbxData->iIndices.valueLoops;
+        m_Data = fbxData;
 
         m_meshName = fbxData->iMeshName;
         m_pathName = fbxData->iPathName;
         m_PathTrans = fbxData->iPathTrans;
 
-        m_RootNode = *nodeTree;
-        m_AnimBones = boneTree->AnimBoneMap;
-        m_BoneOffset = fbxData->iBoneOffset.value;
+        auto sameOwner = [] (auto const &weak, auto const &ptr) {
+            return !weak.owner_before(ptr) && !ptr.owner_before(weak);
+        };
+        auto rig = std::atomic_load(&fbxData->evalRig);
+        if (!rig || !sameOwner(rig->nodeTree, nodeTree) || !sameOwner(rig->boneTree, boneTree)
+            || rig->vertices != fbxData->iVertices.value.data()
+            || rig->numVertices != fbxData->iVertices.value.size()) {
+            rig = compileRig(nodeTree, boneTree, fbxData);
+            std::atomic_store(&fbxData->evalRig, rig);
+        }
+        m_Rig = std::move(rig);
 
         m_CurrentFrame = 0.0f;
     }
@@ -80,12 +184,12 @@ struct EvalAnim{
         //ED_COUT << "FBX: FrameID " << fi << " Tick " << m_animInfo.tick << " DeltaTime " << dt << std::endl;
 
         if(m_evalOption.writeData){
-            expandBoneTransform(&m_RootNode, "", aiMatrix4x4());
-            calculateMaxBoneInfluence();
+            expandBoneTransform();
+            m_FbxData.jointIndices_elementSize = std::max(m_Rig->maxInfluence, m_FbxData.jointIndices_elementSize);
 
             for(float s = m_animInfo.minTimeStamp; s<=m_animInfo.maxTimeStamp; s+=1.0f){
                 //std::cout << "FBX: Calculate Anim Transform Time " << s << std::endl;
-                calculateAnimTransform(&m_RootNode, s);
+                calculateAnimTransform(s);
             }
         }
 
@@ -93,7 +197,7 @@ struct EvalAnim{
             std::cout << "----- >" << m_pathName.value << "\n";
         }
 //        TIMER_START(UpdateAnim_CalcTrans)
-        calculateBoneTransform(&m_RootNode, aiMatrix4x4(), "");
+        calculateBoneTransform(m_CurrentFrame);
 //        TIMER_END(UpdateAnim_CalcTrans)
 
 //        TIMER_START(UpdateAnim_CalcPrim)
@@ -109,12 +213,13 @@ struct EvalAnim{
                             std::shared_ptr<zeno::DictObject> &r,
                             std::shared_ptr<zeno::DictObject> &s){
 
-        for(auto& m:m_BoneTransforms){
-            //zeno::log_info("A {}", m.first);
+        for(size_t i = 0; i < m_BoneTransforms.size(); i++){
+            auto const &boneName = m_Rig->boneNames[i];
+            //zeno::log_info("A {}", boneName);
             aiVector3t<float> trans;
             aiQuaterniont<float> rotate;
             aiVector3t<float> scale;
-            m.second.Decompose(scale, rotate, trans);
+            m_BoneTransforms[i].Decompose(scale, rotate, trans);
             //zeno::log_info("    T {: f} {: f} {: f}", trans.x, trans.y, trans.z);
             //zeno::log_info("    R {: f} {: f} {: f} {: f}", rotate.x, rotate.y, rotate.z, rotate.w);
             //zeno::log_info("    S {: f} {: f} {: f}", scale.x, scale.y, scale.z);
@@ -128,120 +233,113 @@ struct EvalAnim{
             auto ns = std::make_shared<zeno::NumericObject>();
             ns->value = zeno::vec3f(scale.x, scale.y, scale.z);
 
-            t->lut[m.first] = nt;
-            r->lut[m.first] = nr;
-            s->lut[m.first] = ns;
+            t->lut[boneName] = nt;
+            r->lut[boneName] = nr;
+            s->lut[boneName] = ns;
         }
     }
 
-    void calculateMaxBoneInfluence(){
-        for(unsigned int i=0; i<m_Vertices.size(); i++) {
-            int s = m_Vertices[i].boneWeights.size();
-            m_FbxData.jointIndices_elementSize = std::max(s, m_FbxData.jointIndices_elementSize);
+    // T * R * S of an animated node at the given time, what SAnimBone::update computes
+    aiMatrix4x4 localTransform(int animIndex, float animationTime) const {
+        auto const &anim = m_Rig->anims[animIndex];
+        int i0, i1;
+
+        aiVector3D position;
+        if (auto c = anim.position; c.count == 1) {
+            position = m_Rig->positionKeys[c.begin];
+        } else if (c.count > 1) {
+            float f = keyFactor(m_Rig->positionTimes.data() + c.begin, c.count, animationTime, i0, i1);
+            auto const *keys = m_Rig->positionKeys.data() + c.begin;
+            position = keys[i0] * (1.0f - f) + keys[i1] * f;
         }
-        //std::cout << "FBX: MaxJointInfluence " << m_FbxData.jointIndices_elementSize << std::endl;
-    }
-
-    void calculateAnimTransform(const NodeTree *node, float timeCode){
-        std::string nodeName = node->name;
-        aiVector3t<float> trans{0.0f,0.0f,0.0f};
-        aiQuaterniont<float> rotate;
-        aiVector3t<float> scale{1.0f,1.0f,1.0f};
 
-        if (m_AnimBones.find(nodeName) != m_AnimBones.end()) {
-            auto& bone = m_AnimBones[nodeName];
-            bone.update(timeCode);
-            bone.m_LocalTransform.Decompose(scale, rotate, trans);
+        aiQuaternion rotation;
+        if (auto c = anim.rotation; c.count == 1) {
+            rotation = m_Rig->rotationKeys[c.begin];
+        } else if (c.count > 1) {
+            float f = keyFactor(m_Rig->rotationTimes.data() + c.begin, c.count, animationTime, i0, i1);
+            auto const *keys = m_Rig->rotationKeys.data() + c.begin;
+            aiQuaternion::Interpolate(rotation, keys[i0], keys[i1], f);
         }
 
-        m_FbxData.rotations_timeSamples[timeCode].emplace_back(rotate.x,rotate.y,rotate.z,rotate.w);
-        m_FbxData.translations_timeSamples[timeCode].emplace_back(trans.x,trans.y,trans.z);
-        m_FbxData.scales_timeSamples[timeCode].emplace_back(scale.x,scale.y,scale.z);
+        aiVector3D scaling(1.0f, 1.0f, 1.0f);
+        if (auto c = anim.scale; c.count == 1) {
+            scaling = m_Rig->scaleKeys[c.begin];
+        } else if (c.count > 1) {
+            float f = keyFactor(m_Rig->scaleTimes.data() + c.begin, c.count, animationTime, i0, i1);
+            auto const *keys = m_Rig->scaleKeys.data() + c.begin;
+            scaling = keys[i0] * (1.0f - f) + keys[i1] * f;
+        }
 
-        for (int i = 0; i < node->childrenCount; i++)
-            calculateAnimTransform(&node->children[i], timeCode);
+        aiMatrix4x4 translation, scale;
+        aiMatrix4x4::Translation(position, translation);
+        aiMatrix4x4::Scaling(scaling, scale);
+        return translation * aiMatrix4x4(rotation.GetMatrix()) * scale;
     }
 
-    void expandBoneTransform(const NodeTree *node, std::string pPath, aiMatrix4x4 parentTransform) {
-        std::string nodeName = node->name;
-        std::string cName;
-        pPath.empty() ? cName = nodeName : cName = pPath + "/" + nodeName;
-        aiMatrix4x4 nodeTransform = node->transformation;
-
-        m_FbxData.joints.push_back(cName);
-        m_FbxData.jointNames.push_back(nodeName);
-        m_JointCorrespondingIndex[nodeName] = m_FbxData.joints.size()-1;
-        //std::cout << "FBX: Bone name " << nodeName << " " << cName << " " << m_FbxData.joints.size() << std::endl;
-
-        aiMatrix4x4 globalTransformation = parentTransform * nodeTransform;
-        m_FbxData.restTransforms.push_back(globalTransformation);
-        m_FbxData.bindTransforms.push_back(nodeTransform);
-
-        if (m_BoneOffset.find(nodeName) != m_BoneOffset.end()) {  // found
-            std::string boneName = m_BoneOffset[nodeName].name;
-            aiMatrix4x4 boneOffset = m_BoneOffset[nodeName].offset;
-            m_BoneTransforms[boneName] = globalTransformation * boneOffset;
-        }
+    void calculateAnimTransform(float timeCode){
+        auto &rotations = m_FbxData.rotations_timeSamples[timeCode];
+        auto &translations = m_FbxData.translations_timeSamples[timeCode];
+        auto &scales = m_FbxData.scales_timeSamples[timeCode];
 
-        for (int i = 0; i < node->childrenCount; i++)
-            expandBoneTransform(&node->children[i], cName, globalTransformation);
-    }
+        for (auto const &node: m_Rig->nodes) {
+            aiVector3t<float> trans{0.0f,0.0f,0.0f};
+            aiQuaterniont<float> rotate;
+            aiVector3t<float> scale{1.0f,1.0f,1.0f};
 
-    void calculateBoneTransform(const NodeTree *node, aiMatrix4x4 parentTransform, std::string parent_path) {
-        std::string nodeName = node->name;
-        aiMatrix4x4 nodeTransform = node->transformation;
-        auto pathName = parent_path + "/" + nodeName;
+            if (node.anim != -1)
+                localTransform(node.anim, timeCode).Decompose(scale, rotate, trans);
 
-        if(m_evalOption.printAnimData) {
-            std::cout << "---------- ---------- ----------\n";
-            std::cout << "FBX: ***** Node Name " << nodeName << std::endl;
-            Helper::printAiMatrix(nodeTransform);
-            std::cout << "++++++++++ ++++++++++ ++++++++++\n";
-            Helper::printAiMatrix(parentTransform);
-            std::cout << "---------- ---------- ----------\n";
+            rotations.emplace_back(rotate.x,rotate.y,rotate.z,rotate.w);
+            translations.emplace_back(trans.x,trans.y,trans.z);
+            scales.emplace_back(scale.x,scale.y,scale.z);
         }
+    }
 
-        // Any object that just has the key-anim is a bone
-        if (m_AnimBones.find(nodeName) != m_AnimBones.end()) {
-            auto& bone = m_AnimBones[nodeName];
+    void expandBoneTransform() {
+        auto const &nodes = m_Rig->nodes;
+        std::vector<aiMatrix4x4> restTransforms(nodes.size());
 
-            bone.update(m_CurrentFrame);
-            nodeTransform = bone.m_LocalTransform;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            auto const &node = nodes[i];
+            restTransforms[i] = node.parent == -1 ? node.transformation
+                                                  : restTransforms[node.parent] * node.transformation;
 
-            if(m_evalOption.printAnimData) {
-                std::cout << "FBX: Anim Node Name " << nodeName << std::endl;
-                //Helper::printAiMatrix(nodeTransform);
-            }
+            m_FbxData.joints.push_back(node.path.substr(1));
+            m_FbxData.jointNames.push_back(node.name);
+            m_FbxData.restTransforms.push_back(restTransforms[i]);
+            m_FbxData.bindTransforms.push_back(node.transformation);
+            //std::cout << "FBX: Bone name " << node.name << " " << node.path << " " << m_FbxData.joints.size() << std::endl;
         }
-        aiMatrix4x4 globalTransformation = parentTransform * nodeTransform;
+    }
 
-        // XXX Lazy Transform
-        if (m_BoneOffset.find(nodeName) != m_BoneOffset.end()) {  // found
-            std::string boneName = m_BoneOffset[nodeName].name;
-            aiMatrix4x4 boneOffset = m_BoneOffset[nodeName].offset;
+    // one pass over the nodes in depth-first order, every parent is final
+    // by the time its children read it
+    void calculateBoneTransform(float animationTime) {
+        auto const &nodes = m_Rig->nodes;
+        m_GlobalTransforms.resize(nodes.size());
+        m_BoneTransforms.assign(m_Rig->boneNames.size(), aiMatrix4x4());
 
-            if(m_evalOption.printAnimData) {
-                std::cout << "FBX: Bone Node Name " << nodeName << std::endl;
-                //Helper::printAiMatrix(boneOffset);
-            }
-
-            m_BoneTransforms[boneName] = globalTransformation * boneOffset;
-            if(m_evalOption.printAnimData) {
-                //std::cout << "FBX: Transform " << boneName << "\n";
-                //Helper::printAiMatrix(m_BoneTransforms[boneName]);
-            }
-        }
+        for (size_t i = 0; i < nodes.size(); i++) {
+            auto const &node = nodes[i];
+            // Any object that just has the key-anim is a bone
+            aiMatrix4x4 nodeTransform = node.anim == -1 ? node.transformation
+                                                        : localTransform(node.anim, animationTime);
+            m_GlobalTransforms[i] = node.parent == -1 ? nodeTransform
+                                                      : m_GlobalTransforms[node.parent] * nodeTransform;
 
-            // The child is already applied the parent transformation by the tree struct.
-            m_LazyTransforms[pathName] = globalTransformation;
+            if (node.boneSlot != -1)
+                m_BoneTransforms[node.boneSlot] = m_GlobalTransforms[i] * node.offset;
 
             if(m_evalOption.printAnimData) {
-                std::cout << std::fixed << "FBX: Lazy Node Name " << nodeName << std::endl;
-                Helper::printAiMatrix(globalTransformation);
+                std::cout << "---------- ---------- ----------\n";
+                std::cout << "FBX: ***** Node Name " << node.name
+                          << (node.anim != -1 ? " (Anim)" : "") << (node.boneSlot != -1 ? " (Bone)" : "") << std::endl;
+                Helper::printAiMatrix(nodeTransform);
+                std::cout << "FBX: Lazy Node Name " << node.path << std::endl;
+                Helper::printAiMatrix(m_GlobalTransforms[i]);
             }
-
-        for (int i = 0; i < node->childrenCount; i++)
-            calculateBoneTransform(&node->children[i], globalTransformation, pathName);
+        }
     }
 
     void updateCameraAndLight(std::shared_ptr<FBXData>& fbxData,
@@ -250,8 +348,8 @@ struct EvalAnim{
     {
         float gscale = m_evalOption.globalScale;
         // TODO We didn't consider that the camera might be in the hierarchy
-        for(auto& ltrans: m_LazyTransforms){
-            auto namePath = ltrans.first;
+        for(size_t i = 0; i < m_GlobalTransforms.size(); i++){
+            auto const &namePath = m_Rig->nodes[i].path;
 
             for(auto &[camName, camObj]: fbxData->iCamera.value){
                 if(namePath.find(camName) != std::string::npos){
@@ -262,7 +360,7 @@ struct EvalAnim{
                     aiQuaterniont<float> rotate;
                     aiVector3t<float> scale;
 
-                    ltrans.second.Decompose(scale, rotate, trans);
+                    m_GlobalTransforms[i].Decompose(scale, rotate, trans);
 
                     cam.pos = zeno::vec3f(trans.x * gscale, trans.y * gscale, trans.z * gscale);
                     aiMatrix3x3 r = rotate.GetMatrix().Transpose();
@@ -277,12 +375,9 @@ struct EvalAnim{
 
     void getPathTrans(std::string pathName, glm::mat4& pathTrans, int& tranType){
 
-        if(m_LazyTransforms.find(pathName) != m_LazyTransforms.end()){
-            auto& tr = m_LazyTransforms[pathName];
-            pathTrans = glm::mat4(tr.a1,tr.b1,tr.c1,tr.d1,
-                                  tr.a2,tr.b2,tr.c2,tr.d2,
-                                  tr.a3,tr.b3,tr.c3,tr.d3,
-                                  tr.a4,tr.b4,tr.c4,tr.d4);
+        if(auto it = m_Rig->pathIndex.find(pathName); it != m_Rig->pathIndex.end()){
+            auto& tr = m_GlobalTransforms[it->second];
+            pathTrans = toGlmMat4(tr);
             if(m_evalOption.printAnimData) {
                 std::cout << "Eval Lazy Trans\n";
                 Helper::printAiMatrix(tr);
@@ -292,10 +387,7 @@ struct EvalAnim{
 
         }else if(m_PathTrans.value.find(pathName) != m_PathTrans.value.end()) {
             auto& tr = m_PathTrans.value[pathName];
-            pathTrans = glm::mat4(tr.a1,tr.b1,tr.c1,tr.d1,
-                                  tr.a2,tr.b2,tr.c2,tr.d2,
-                                  tr.a3,tr.b3,tr.c3,tr.d3,
-                                  tr.a4,tr.b4,tr.c4,tr.d4);
+            pathTrans = toGlmMat4(tr);
             if(m_evalOption.printAnimData) {
                 std::cout << "Eval Path Trans\n";
                 Helper::printAiMatrix(tr);
@@ -310,16 +402,22 @@ struct EvalAnim{
     }
 
     void calculateFinal(std::shared_ptr<zeno::PrimitiveObject>& prim){
-        auto &ver = prim->verts;
+        auto const &vertices = m_Data->iVertices.value;
+        auto const &indicesTris = m_Data->iIndices.valueTri;
+        auto const &indicesLoops = m_Data->iIndices.valueLoops;
+        auto const &indicesPolys = m_Data->iIndices.valuePolys;
+        size_t numVerts = vertices.size();
+
+        prim->verts.resize(numVerts);
+        prim->uvs.resize(numVerts);
+        auto &ver = prim->verts.values;
         auto &trisInd = prim->tris;
-        auto &polys = prim->polys;
-        auto &loops = prim->loops;
         auto &uvs = prim->uvs;
         auto &uv = prim->verts.add_attr<zeno::vec3f>("uv");
         auto &norm = prim->verts.add_attr<zeno::vec3f>("nrm");
         auto &posb = prim->verts.add_attr<zeno::vec3f>("posb");
         auto &clr0 = prim->verts.add_attr<zeno::vec3f>("clr0");
-        bool isTris = false;
+        bool isTris = indicesLoops.size() == 0;
 
         //std::cout << "Eval name: " << m_meshName.value << "\n";
         //std::cout << "Eval name: " << m_meshName.value_matName << "\n";
@@ -327,17 +425,13 @@ struct EvalAnim{
         //std::cout << "Eval name: " << m_pathName.value << "\n";
         //std::cout << "Eval name: " << m_pathName.value_oriPath << "\n";
 
-        if(m_IndicesLoops.size() == 0){
-            isTris = true;
-        }else{
-            isTris = false;
-        }
-        //std::cout << "mesh size loops " << m_IndicesLoops.size() << " tris " << m_IndicesTris.size() << " is tris " << isTris <<"\n";
-        for(int i=0;i<m_FbxData.jointIndices_elementSize;i++){
-            prim->verts.add_attr<float>("jointIndice_" + std::to_string(i));
-            prim->verts.add_attr<float>("jointWeight_" + std::to_string(i));
-        }
+        //std::cout << "mesh size loops " << indicesLoops.size() << " tris " << indicesTris.size() << " is tris " << isTris <<"\n";
         int elemSize = m_FbxData.jointIndices_elementSize;
+        std::vector<float *> jointIndices(elemSize), jointWeights(elemSize);
+        for(int i=0;i<elemSize;i++){
+            jointIndices[i] = prim->verts.add_attr<float>("jointIndice_" + std::to_string(i)).data();
+            jointWeights[i] = prim->verts.add_attr<float>("jointWeight_" + std::to_string(i)).data();
+        }
         prim->userData().set2("jointIndicesElementSize", elemSize);
         float gscale = m_evalOption.globalScale;
 
@@ -349,79 +443,61 @@ struct EvalAnim{
             getPathTrans(pathName, pathTrans, tranType);
         }
 
-        for(unsigned int i=0; i<m_Vertices.size(); i++){
-            auto& bwe = m_Vertices[i].boneWeights;
-            auto& pos = m_Vertices[i].position;
-            auto& uvw = m_Vertices[i].texCoord;
-            auto& nor = m_Vertices[i].normal;
-            auto& vco = m_Vertices[i].vectexColor;
+        std::vector<glm::mat4> palette(m_BoneTransforms.size());
+        for(size_t i = 0; i < palette.size(); i++)
+            palette[i] = toGlmMat4(m_BoneTransforms[i]);
 
-//            auto& exi = m_Vertices[i].extraInfos;
-//            if(pathName == "/__path__") {
-//                getPathTrans(exi["path"], pathTrans, tranType);
-//            }
+        auto const &rig = *m_Rig;
+        zeno::parallel_for(numVerts, [&] (size_t i) {
+            auto& pos = vertices[i].position;
+            auto& uvw = vertices[i].texCoord;
+            auto& nor = vertices[i].normal;
+            auto& vco = vertices[i].vectexColor;
 
             glm::vec4 tpos(0.0f, 0.0f, 0.0f, 0.0f);
 
-            bool boneInflued = false;
-            int bCount = 0;
             // Influence
-            for(auto& b: bwe){
-                // e.g. b.first -> joint1
+            int bBegin = rig.skinBegin[i], bEnd = rig.skinBegin[i + 1];
+            for(int b = bBegin; b < bEnd; b++){
                 if(elemSize){
-                    float bIndex = (float)m_JointCorrespondingIndex[b.first];
-                    prim->verts.attr<float>("jointIndice_" + std::to_string(bCount)).push_back(bIndex);
-                    prim->verts.attr<float>("jointWeight_" + std::to_string(bCount)).push_back(b.second);
+                    jointIndices[b - bBegin][i] = (float)rig.skinJoint[b];
+                    jointWeights[b - bBegin][i] = rig.skinWeight[b];
                 }
-                //std::cout << "FBX: Vert " << i << " name " << b.first << " bIndex " << bIndex << std::endl;
-                boneInflued = true;
-                auto& tr = m_BoneTransforms[b.first];
-                glm::mat4 trans = glm::mat4(tr.a1,tr.b1,tr.c1,tr.d1,
-                                            tr.a2,tr.b2,tr.c2,tr.d2,
-                                            tr.a3,tr.b3,tr.c3,tr.d3,
-                                            tr.a4,tr.b4,tr.c4,tr.d4);
-
-                glm::vec4 lpos = trans * glm::vec4(pos.x, pos.y, pos.z, 1.0f);
-
-                tpos += lpos * b.second;
-                bCount += 1;
+                glm::vec4 lpos = palette[rig.skinBone[b]] * glm::vec4(pos.x, pos.y, pos.z, 1.0f);
+                tpos += lpos * rig.skinWeight[b];
             }
 
             // Supplement, joint index supplement 0, weight 0
-            for(int z=bCount; z<m_FbxData.jointIndices_elementSize; z++){
-                prim->verts.attr<float>("jointIndice_" + std::to_string(bCount)).push_back(0);
-                prim->verts.attr<float>("jointWeight_" + std::to_string(bCount)).push_back(0.0f);
+            for(int z = bEnd - bBegin; z < elemSize; z++){
+                jointIndices[z][i] = 0.0f;
+                jointWeights[z][i] = 0.0f;
             }
 
             // TODO (Bone Influence) Skeleton + Transform
             //  If remove follow `if`, we will get full transform animation, but the skel animation is gone
-            if(! boneInflued) {
+            if(bBegin == bEnd) {
                 tpos = pathTrans * glm::vec4(pos.x, pos.y, pos.z, 1.0f);
             }
 
             glm::vec3 fpos = glm::vec3(tpos.x/tpos.w, tpos.y/tpos.w, tpos.z/tpos.w);
 
-            ver.emplace_back(fpos.x * gscale, fpos.y * gscale, fpos.z * gscale);
-            posb.emplace_back(0.0f, 0.0f, 0.0f);
-            uvs.emplace_back(uvw.x, uvw.y, uvw.z);
-            uv.emplace_back(uvw.x, uvw.y, uvw.z);
-            norm.emplace_back(nor.x, nor.y, nor.z);
-            clr0.emplace_back(vco.r, vco.g, vco.b);
-        }
+            ver[i] = zeno::vec3f(fpos.x * gscale, fpos.y * gscale, fpos.z * gscale);
+            posb[i] = zeno::vec3f(0.0f, 0.0f, 0.0f);
+            uvs[i] = zeno::vec2f(uvw.x, uvw.y);
+            uv[i] = zeno::vec3f(uvw.x, uvw.y, uvw.z);
+            norm[i] = zeno::vec3f(nor.x, nor.y, nor.z);
+            clr0[i] = zeno::vec3f(vco.r, vco.g, vco.b);
+        });
 
         if(isTris) {
-            for (unsigned int i = 0; i < m_IndicesTris.size(); i += 3) {
-                zeno::vec3i incs(m_IndicesTris[i], m_IndicesTris[i + 1], m_IndicesTris[i + 2]);
-                trisInd.push_back(incs);
-            }
+            trisInd.resize(indicesTris.size() / 3);
+            zeno::parallel_for(trisInd.size(), [&] (size_t i) {
+                trisInd[i] = zeno::vec3i(indicesTris[i * 3], indicesTris[i * 3 + 1], indicesTris[i * 3 + 2]);
+            });
             uvs.clear();
         }else{
-            for (unsigned int i = 0; i < m_IndicesLoops.size(); i ++) {
-                loops.emplace_back(m_IndicesLoops[i]);
-            }
-            for (unsigned int i = 0; i < m_IndicesPolys.size(); i ++) {
-                polys.emplace_back(m_IndicesPolys[i]);
-            }
+            prim->loops.values.assign(indicesLoops.begin(), indicesLoops.end());
+            prim->polys.values.assign(indicesPolys.begin(), indicesPolys.end());
             uv.clear();
         }
 
@@ -430,14 +506,14 @@ struct EvalAnim{
             auto &uv0 = prim->tris.add_attr<zeno::vec3f>("uv0");
             auto &uv1 = prim->tris.add_attr<zeno::vec3f>("uv1");
             auto &uv2 = prim->tris.add_attr<zeno::vec3f>("uv2");
-            for (unsigned int i = 0; i < trisInd.size(); i++) {
+            zeno::parallel_for(trisInd.size(), [&] (size_t i) {
                 unsigned int _i1 = trisInd[i][0];
                 unsigned int _i2 = trisInd[i][1];
                 unsigned int _i3 = trisInd[i][2];
-                uv0[i] = zeno::vec3f(m_Vertices[_i1].texCoord[0], m_Vertices[_i1].texCoord[1], 0);
-                uv1[i] = zeno::vec3f(m_Vertices[_i2].texCoord[0], m_Vertices[_i2].texCoord[1], 0);
-                uv2[i] = zeno::vec3f(m_Vertices[_i3].texCoord[0], m_Vertices[_i3].texCoord[1], 0);
-            }
+                uv0[i] = zeno::vec3f(vertices[_i1].texCoord[0], vertices[_i1].texCoord[1], 0);
+                uv1[i] = zeno::vec3f(vertices[_i2].texCoord[0], vertices[_i2].texCoord[1], 0);
+                uv2[i] = zeno::vec3f(vertices[_i3].texCoord[0], vertices[_i3].texCoord[1], 0);
+            });
         }else{
             // Crash
             //if(prim->uvs.size()) {
@@ -595,7 +671,8 @@ struct EvalFBXAnim : zeno::INode {
                                                 glm::length(glm::vec3(pathTrans[1])),
                                                 glm::length(glm::vec3(pathTrans[2])));
 
-                for(unsigned int j=0; j<blendShapeData.size(); j++){ // Mesh Vert
+                bsprim->verts.resize(blendShapeData.size());
+                zeno::parallel_for(blendShapeData.size(), [&] (size_t j){ // Mesh Vert
                     auto& vdata = blendShapeData[j];
                     auto& pos = vdata.position;
                     auto& nrm = vdata.normal;
@@ -606,11 +683,11 @@ struct EvalFBXAnim : zeno::INode {
                     glm::vec4 adpos = glm::vec4(pathTransScale, 1.0f) * glm::vec4(dpos.x, dpos.y, dpos.z, 1.0f);
                     dpos = aiVector3D(adpos.x/adpos.w, adpos.y/adpos.w, adpos.z/adpos.w);
 
-                    verAttr.emplace_back(pos.x * gScale, pos.y * gScale, pos.z * gScale);
-                    nrmAttr.emplace_back(nrm.x, nrm.y, nrm.z);
-                    dposAttr.emplace_back(adpos.x * gScale, adpos.y * gScale, adpos.z * gScale);
-                    dnrmAttr.emplace_back(dnrm.x, dnrm.y, dnrm.z);
-                }
+                    verAttr[j] = zeno::vec3f(pos.x * gScale, pos.y * gScale, pos.z * gScale);
+                    nrmAttr[j] = zeno::vec3f(nrm.x, nrm.y, nrm.z);
+                    dposAttr[j] = zeno::vec3f(adpos.x * gScale, adpos.y * gScale, adpos.z * gScale);
+                    dnrmAttr[j] = zeno::vec3f(dnrm.x, dnrm.y, dnrm.z);
+                });
 
                 bsPrimsOrigin->arr.emplace_back(bsprim);
             }
@@ -622,8 +699,8 @@ struct EvalFBXAnim : zeno::INode {
         if(bsValue.find(meshName) != bsValue.end()){
             if(fbxData->iKeyMorph.value.find(meshName) != fbxData->iKeyMorph.value.end()){
 
-                auto blendShapeData = bsValue[meshName];
-                auto keyMorphs = fbxData->iKeyMorph.value[meshName];
+                auto& blendShapeData = bsValue[meshName];
+                auto& keyMorphs = fbxData->iKeyMorph.value[meshName];
 
                 unsigned int kstart = 0;
                 unsigned int kend;
@@ -665,25 +742,24 @@ struct EvalFBXAnim : zeno::INode {
                     auto &bsw = bsprim->verts.add_attr<float>("bsw");
                     double w = kdstart.m_Weights[i] * (1.0f - factor) + kdend.m_Weights[i] * factor;
                     auto& bsdata = blendShapeData[i];
-                    for(unsigned int j=0; j<bsdata.size(); j++){
+                    bsprim->verts.resize(bsdata.size());
+                    zeno::parallel_for(bsdata.size(), [&] (size_t j){
                         auto& pos = bsdata[j].position;
                         auto& nrm = bsdata[j].normal;
                         auto& dpos = bsdata[j].deltaPosition;
                         auto& dnor = bsdata[j].deltaNormal;
 
-                        verAttr.emplace_back(pos.x * gScale, pos.y * gScale, pos.z * gScale);
-                        nrmAttr.emplace_back(nrm.x, nrm.y, nrm.z);
-                        posb.emplace_back(dpos.x * gScale, dpos.y * gScale, dpos.z * gScale);
-                        norb.emplace_back(dnor.x, dnor.y, dnor.z);
-                        bsw.emplace_back((float)w);
-                    }
+                        verAttr[j] = zeno::vec3f(pos.x * gScale, pos.y * gScale, pos.z * gScale);
+                        nrmAttr[j] = zeno::vec3f(nrm.x, nrm.y, nrm.z);
+                        posb[j] = zeno::vec3f(dpos.x * gScale, dpos.y * gScale, dpos.z * gScale);
+                        norb[j] = zeno::vec3f(dnor.x, dnor.y, dnor.z);
+                        bsw[j] = (float)w;
 
-                    if(evalBlendShape){
-                        for(unsigned int j=0; j<bsdata.size(); j++) {
+                        if(evalBlendShape){
                             //std::cout << " " << j << " " << posb[j][0] << ","<<posb[j][1] <<","<<posb[j][2] << " - " << w << "\n";
                             prim->verts[j] = prim->verts[j] + posb[j] * w;
                         }
-                    }
+                    });
 
                     bsPrims->arr.emplace_back(bsprim);
                 }
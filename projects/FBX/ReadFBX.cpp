@@ -28,8 +28,12 @@
 #include <zeno/utils/logger.h>
 #include <zeno/extra/GlobalState.h>
 
+#include <algorithm>
+#include <cstdint>
 #include <stack>
 #include <string>
+#include <map>
+#include <mutex>
 #include <unordered_map>
 #include <filesystem>
 #include <fstream>
@@ -39,6 +43,65 @@
 
 #include "Definition.h"
 
+inline namespace ZenoFBXDefinition {
+
+std::shared_ptr<aiScene const> FBXLoadScene(std::string const &path, unsigned int flags) {
+    struct Entry {
+        std::mutex mtx;
+        std::filesystem::file_time_type mtime;
+        std::uintmax_t size = 0;
+        std::shared_ptr<Assimp::Importer> importer;
+        std::uint64_t lastUse = 0;
+    };
+    // parsed scenes are kept for the few files used most recently, a scene
+    // handed out stays alive on its own after its entry is evicted
+    constexpr std::size_t kMaxEntries = 8;
+    static std::mutex mtx;
+    static std::map<std::pair<std::string, unsigned int>, std::shared_ptr<Entry>> entries;
+    static std::uint64_t useCounter = 0;
+
+    std::error_code ec;
+    auto key = std::filesystem::weakly_canonical(std::filesystem::u8path(path), ec).u8string();
+    if (ec)
+        key = path;
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    auto size = ec ? 0 : std::filesystem::file_size(path, ec);
+
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard lck(mtx);
+        auto &e = entries[{key, flags}];
+        if (!e)
+            e = std::make_shared<Entry>();
+        e->lastUse = ++useCounter;
+        entry = e;
+        if (entries.size() > kMaxEntries) {
+            auto lru = std::min_element(entries.begin(), entries.end(), [] (auto const &x, auto const &y) {
+                return x.second->lastUse < y.second->lastUse;
+            });
+            entries.erase(lru);
+        }
+    }
+    // other files keep loading in parallel, only the same entry waits
+    std::lock_guard lck(entry->mtx);
+    if (ec || !entry->importer || entry->mtime != mtime || entry->size != size) {
+        auto importer = std::make_shared<Assimp::Importer>();
+        importer->SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, true);
+        entry->importer = nullptr;
+        if (!importer->ReadFile(path, flags))
+            return nullptr;
+        entry->importer = std::move(importer);
+        entry->mtime = mtime;
+        entry->size = size;
+    } else {
+        zeno::log_info("FBX: Reuse parsed scene of {}", path);
+    }
+    // the scene keeps its importer alive, even if the entry is replaced meanwhile
+    return std::shared_ptr<aiScene const>(entry->importer, entry->importer->GetScene());
+}
+
+}
+
 namespace {
 
 using Path = std::filesystem::path;
@@ -1043,7 +1106,7 @@ void readFBXFile(
         SFBXReadOption readOption
     )
 {
-    Assimp::Importer importer;
+    std::shared_ptr<aiScene const> sceneRef;
     aiScene const* scene;
     Mesh mesh;
     mesh.m_readOption = readOption;
@@ -1054,7 +1117,8 @@ void readFBXFile(
 
     if(readOption.generate){
         TIMER_START(GenerateRead)
-        scene = importer.ReadFile(fbx_path, 0);
+        sceneRef = FBXLoadScene(fbx_path, 0);
+        scene = sceneRef.get();
         if(scene == nullptr){
             std::cout << "Read empty fbx scene\n";
             return;
@@ -1071,16 +1135,16 @@ void readFBXFile(
     }
 
     TIMER_START(ImporterRead)
-    importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, true);
     if(readOption.triangulate){
-        scene = importer.ReadFile(fbx_path, aiProcess_Triangulate
+        sceneRef = FBXLoadScene(fbx_path, aiProcess_Triangulate
                                                 //| aiProcess_FlipUVs
                                                 //| aiProcess_CalcTangentSpace
                                                 | aiProcess_ImproveCacheLocality
                                                 | aiProcess_JoinIdenticalVertices);
     }else{
-        scene = importer.ReadFile(fbx_path, aiProcess_ImproveCacheLocality | aiProcess_JoinIdenticalVertices);
+        sceneRef = FBXLoadScene(fbx_path, aiProcess_ImproveCacheLocality | aiProcess_JoinIdenticalVertices);
     }
+    scene = sceneRef.get();
     TIMER_END(ImporterRead)
 
     if(! scene)
@@ -3038,7 +3038,7 @@ void FLIP_vdb::solve_pressure_simd_uaamg(
     openvdb::Vec3fGrid::Ptr &face_weight, packed_FloatGrid3 &velocity,
     openvdb::Vec3fGrid::Ptr &solid_velocity,
     float density, float tension_coef, bool enable_tension,
-    float dt, float dx) {
+    float dt, float dx, simd_uaamg::PoissonHierarchyCache *cache) {
 
 	//skip if there is no dof to solve
 	if (liquid_sdf->tree().leafCount() == 0) {
@@ -3047,11 +3047,37 @@ void FLIP_vdb::solve_pressure_simd_uaamg(
 	//has leaf but empty leaf
 	//test construct levels
 
+	//the laplacian is linear in dt, a cached hierarchy keeps the dt it was
+	//built with so that a changing time step does not force a rebuild
+	float matrix_dt = dt;
+	if (cache) {
+		if (!cache->mSolver || cache->mDx != dx || cache->mRefDt <= 0) {
+			cache->mSolver.reset();
+			cache->mRefDt = dt;
+			cache->mDx = dx;
+		}
+		matrix_dt = cache->mRefDt;
+	}
+
 	auto lhs_matrix = simd_uaamg::LaplacianWithLevel::
-		createPressurePoissonLaplacian(liquid_sdf, face_weight, dt);
-	auto simd_solver = simd_uaamg::PoissonSolver(lhs_matrix);
+		createPressurePoissonLaplacian(liquid_sdf, face_weight, matrix_dt);
+	std::shared_ptr<simd_uaamg::PoissonSolver> solver_ptr;
+	if (cache && cache->mSolver) {
+		solver_ptr = cache->mSolver;
+		solver_ptr->updateFinestLevel(lhs_matrix);
+	}
+	else {
+		solver_ptr = std::make_shared<simd_uaamg::PoissonSolver>(lhs_matrix);
+		if (cache) {
+			cache->mSolver = solver_ptr;
+		}
+	}
+	auto &simd_solver = *solver_ptr;
+	simd_solver.mMaxIteration = 100;
 	simd_solver.mRelativeTolerance = 5e-5;
 	simd_solver.mSmoother = simd_uaamg::PoissonSolver::SmootherOption::RedBlackGaussSeidel;
+	//L(dt) = dt / matrix_dt * L(matrix_dt)
+	const float solution_scale = matrix_dt / dt;
 
   if (enable_tension) {
     const float tension = 2*tension_coef/density;
@@ -3075,7 +3101,8 @@ void FLIP_vdb::solve_pressure_simd_uaamg(
     for (auto iter = new_pressure_leaf->beginValueOn(); iter; ++iter) {
       float old_pressure = old_pressure_axr.getValue(iter.getCoord());
       if (std::isfinite(old_pressure)) {
-        iter.setValue(old_pressure);
+        // the solve runs at matrix_dt, the result is rescaled below
+        iter.setValue(old_pressure / solution_scale);
       }
     }
   }; // end set_warm_pressure
@@ -3083,18 +3110,24 @@ void FLIP_vdb::solve_pressure_simd_uaamg(
   
 	auto state = simd_solver.solveMultigridPCG(pressure, rhsgrid);
 
-	if (state == simd_uaamg::PoissonSolver::SUCCESS) {
-		curr_pressure.swap(pressure);
-	}
-  else{
+	if (state != simd_uaamg::PoissonSolver::SUCCESS) {
     std::cout<<"MGPCG failed, begin pure MG solver\n";
     lhs_matrix->mDofLeafManager->foreach(set_warm_pressure);
     // lhs_matrix->setGridToConstant(pressure, 0.f);
     simd_solver.mMaxIteration = 100;
     simd_solver.mSmoother = simd_uaamg::PoissonSolver::SmootherOption::RedBlackGaussSeidel;
     simd_solver.solvePureMultigrid(pressure, rhsgrid);
-    curr_pressure.swap(pressure);
   }
+  if (solution_scale != 1.0f) {
+    lhs_matrix->mDofLeafManager->foreach(
+        [&](openvdb::Int32Tree::LeafNodeType &leaf, openvdb::Index leafpos) {
+          auto *pressure_leaf = pressure->tree().probeLeaf(leaf.origin());
+          for (auto iter = pressure_leaf->beginValueOn(); iter; ++iter) {
+            iter.setValue(iter.getValue() * solution_scale);
+          }
+        });
+  }
+  curr_pressure.swap(pressure);
 
 	rhsgrid->setName("RHS");
 }
@@ -7,6 +7,10 @@
 #include <zeno/VDBGrid.h>
 
 
+namespace simd_uaamg {
+struct PoissonHierarchyCache;
+}
+
 static inline float frand(unsigned int i) {
 	unsigned int value = (i ^ 61) ^ (i >> 16);
 	value *= 9;
@@ -157,7 +161,8 @@ struct FLIP_vdb {
       openvdb::Vec3fGrid::Ptr &face_weight, packed_FloatGrid3 &velocity,
       openvdb::Vec3fGrid::Ptr &solid_velocity,
       float density, float tension_coef, bool enable_tension,
-      float dt, float dx);
+      float dt, float dx,
+      simd_uaamg::PoissonHierarchyCache *cache = nullptr);
 
   static void apply_pressure_gradient(
       openvdb::FloatGrid::Ptr &liquid_sdf, openvdb::FloatGrid::Ptr &solid_sdf,
@@ -20,6 +20,7 @@ struct CutCellWeightEval : zeno::INode {
     auto solid_sdf = get_input("SolidSDF")->as<VDBFloatGrid>();
     FLIP_vdb::calculate_face_weights(face_weight->m_grid, liquid_sdf->m_grid,
                                      solid_sdf->m_grid);
+    face_weight->invalidatePackedGrid();
   }
 };
 
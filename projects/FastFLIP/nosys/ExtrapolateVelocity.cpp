@@ -17,15 +17,12 @@ struct Vec3FieldExtrapolate : zeno::INode {
         int n = get_param<int>("NumIterates");
         auto velocity = get_input("Field")->as<VDBFloat3Grid>();
         auto liquidsdf = get_input("LiquidSDF")->as<VDBFloatGrid>();
-#if 0
-        vdb_velocity_extrapolator::union_extrapolate(n,
-		                            velocity->v[0],
-		                            velocity->v[1],
-		                            velocity->v[2],
-	  	                            &(liquidsdf->m_grid->tree()));
-#endif
-        
-        vdb_velocity_extrapolator::extrapolate(n, velocity->m_grid);
+        // extrapolate the three channels of the packed copy so the next
+        // solver node (usually the pressure solve) reuses it without from_vec3
+        auto &packed = velocity->acquirePackedGrid();
+        vdb_velocity_extrapolator::union_extrapolate(n, packed.v[0], packed.v[1], packed.v[2],
+                                                     &(liquidsdf->m_grid->tree()));
+        velocity->syncPackedToGrid();
     }
 };
 
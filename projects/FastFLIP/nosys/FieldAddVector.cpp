@@ -22,13 +22,12 @@ struct FieldAddVector : zeno::INode {
         get_input("invec3")->as<zeno::NumericObject>()->get<zeno::vec3f>();
     auto velocity = get_input("Velocity")->as<VDBFloat3Grid>();
 
-    packed_FloatGrid3 packed_velocity;
-    packed_velocity.from_vec3(velocity->m_grid);
+    auto &packed_velocity = velocity->acquirePackedGrid();
     
     FLIP_vdb::field_add_vector( packed_velocity,
                                 ivec3[0], ivec3[1], ivec3[2], 1.0);
     
-    packed_velocity.to_vec3(velocity->m_grid);
+    velocity->syncPackedToGrid();
   }
 };
 
@@ -22,9 +22,8 @@ struct FLIP_P2G : zeno::INode {
     auto PostP2GVelGrid = get_input("PostP2GVelocity")->as<VDBFloat3Grid>();
     auto LiquidSDFGrid = get_input("LiquidSDF")->as<VDBFloatGrid>();
 
-    packed_FloatGrid3 packed_VelGrid, packed_PostP2GVelGrid;
-    packed_VelGrid.from_vec3(VelGrid->m_grid);
-    packed_PostP2GVelGrid.from_vec3(PostP2GVelGrid->m_grid);
+    auto &packed_VelGrid = VelGrid->acquirePackedGrid();
+    auto &packed_PostP2GVelGrid = PostP2GVelGrid->acquirePackedGrid();
 
     FLIP_vdb::particle_to_grid_collect_style(
         packed_VelGrid, packed_PostP2GVelGrid,
@@ -36,8 +35,8 @@ struct FLIP_P2G : zeno::INode {
 		                            packed_VelGrid.v[2],
 	  	                          &(LiquidSDFGrid->m_grid->tree()));
 
-    packed_VelGrid.to_vec3(VelGrid->m_grid);
-    packed_PostP2GVelGrid.to_vec3(PostP2GVelGrid->m_grid);
+    VelGrid->syncPackedToGrid();
+    PostP2GVelGrid->syncPackedToGrid();
   }
 };
 
@@ -0,0 +1,68 @@
+#include "particle_cache.h"
+#include <zeno/ParticlesObject.h>
+#include <zeno/PrimitiveObject.h>
+#include <zeno/zeno.h>
+
+namespace zeno {
+
+struct WriteParticleCache : zeno::INode {
+  virtual void apply() override {
+    auto path = get_input2<std::string>("path");
+    particle_cache::WriteOptions options;
+    options.chunk_size = std::max(1, get_param<int>("ChunkSize"));
+    options.compression_level = get_param<int>("CompressionLevel");
+    auto quantize = get_param<std::string>("Quantize");
+    options.quantize_pos = quantize != "none";
+    options.quantize_others = quantize == "all";
+
+    if (auto p = dynamic_cast<PrimitiveObject *>(get_input("data").get())) {
+      particle_cache::write_primitive(path, *p, options);
+    } else {
+      auto data = get_input("data")->as<ParticlesObject>();
+      particle_cache::write_attributes(
+          path, data->size(),
+          {{"pos", (float const *)data->pos.data(), 3},
+           {"vel", (float const *)data->vel.data(), 3}},
+          options);
+    }
+  }
+};
+
+static int defWriteParticleCache = zeno::defNodeClass<WriteParticleCache>(
+    "WriteParticleCache", {/* inputs: */ {
+                               "data",
+                               {"writepath", "path", ""},
+                           },
+                           /* outputs: */ {},
+                           /* params: */
+                           {
+                               {"enum none pos all", "Quantize", "none"},
+                               {"int", "ChunkSize", "65536"},
+                               {"int", "CompressionLevel", "1"},
+                           },
+                           /* category: */
+                           {
+                               "FLIPSolver",
+                           }});
+
+struct ReadParticleCache : zeno::INode {
+  virtual void apply() override {
+    auto path = get_input2<std::string>("path");
+    auto prim = std::make_shared<PrimitiveObject>();
+    particle_cache::read_primitive(path, *prim);
+    set_output("prim", std::move(prim));
+  }
+};
+
+static int defReadParticleCache = zeno::defNodeClass<ReadParticleCache>(
+    "ReadParticleCache", {/* inputs: */ {
+                              {"readpath", "path", ""},
+                          },
+                          /* outputs: */ {"prim"},
+                          /* params: */ {},
+                          /* category: */
+                          {
+                              "FLIPSolver",
+                          }});
+
+} // namespace zeno
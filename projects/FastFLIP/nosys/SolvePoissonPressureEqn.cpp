@@ -1,4 +1,5 @@
 #include "FLIP_vdb.h"
+#include "simd_vdb_poisson_uaamg.h"
 #include <omp.h>
 #include <zeno/MeshObject.h>
 #include <zeno/NumericObject.h>
@@ -50,18 +51,26 @@ struct AssembleSolvePPE : zeno::INode {
         solid_velocity->m_grid, dt, dx);
 #endif
 
-    packed_FloatGrid3 packed_velocity;
-    packed_velocity.from_vec3(velocity->m_grid);
-        
+    // the velocity is only read here, no need to write it back
+    auto &packed_velocity = velocity->acquirePackedGrid();
+
+    // keep the multigrid hierarchy of this node between frames,
+    // only the coarse leaves touched by the liquid motion are rebuilt
+    if (!get_param<bool>("ReuseHierarchy")) {
+      m_hierarchy_cache.reset();
+    } else if (!m_hierarchy_cache) {
+      m_hierarchy_cache = std::make_shared<simd_uaamg::PoissonHierarchyCache>();
+    }
+
     FLIP_vdb::solve_pressure_simd_uaamg(
         liquid_sdf->m_grid, curvatureGrid, rhsgrid->m_grid,
         curr_pressure->m_grid, face_weight->m_grid,
         packed_velocity, solid_velocity->m_grid,
-        density, tension_coef, enable_tension, dt, dx);
-
-    packed_velocity.to_vec3(velocity->m_grid);
-
+        density, tension_coef, enable_tension, dt, dx,
+        m_hierarchy_cache.get());
   }
+
+  std::shared_ptr<simd_uaamg::PoissonHierarchyCache> m_hierarchy_cache;
 };
 
 static int defAssembleSolvePPE = zeno::defNodeClass<AssembleSolvePPE>(
@@ -81,6 +90,7 @@ static int defAssembleSolvePPE = zeno::defNodeClass<AssembleSolvePPE>(
                          /* params: */
                          {
                              {"float", "dx", "0.0"},
+                             {"bool", "ReuseHierarchy", "1"},
                          },
 
                          /* category: */
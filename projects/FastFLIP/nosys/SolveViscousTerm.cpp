@@ -40,9 +40,8 @@ struct SolveViscousTerm : zeno::INode {
         if (viscosity > eps) {
             auto viscosity_grid = openvdb::FloatGrid::create(viscosity);
 
-            packed_FloatGrid3 packed_velocity, packed_viscous_vel;
-            packed_velocity.from_vec3(velocity->m_grid);
-            packed_viscous_vel.from_vec3(velocity_viscous->m_grid);
+            auto &packed_velocity = velocity->acquirePackedGrid();
+            auto &packed_viscous_vel = velocity_viscous->acquirePackedGrid();
 
             FLIP_vdb::solve_viscosity(packed_velocity, packed_viscous_vel, liquid_sdf->m_grid, solid_sdf->m_grid,
                                       solid_velocity->m_grid, viscosity_grid, density, dt);
@@ -50,7 +49,7 @@ struct SolveViscousTerm : zeno::INode {
             vdb_velocity_extrapolator::union_extrapolate(n, packed_viscous_vel.v[0], packed_viscous_vel.v[1],
                                                          packed_viscous_vel.v[2], &(liquid_sdf->m_grid->tree()));
 
-            packed_viscous_vel.to_vec3(velocity_viscous->m_grid);
+            velocity_viscous->syncPackedToGrid();
         } else {
             velocity_viscous->m_grid = velocity->m_grid->deepCopy();
             velocity_viscous->setName("Velocity_Viscous");
@@ -95,9 +94,8 @@ struct SolveVariationalViscosity : zeno::INode {
         auto solid_sdf = get_input<VDBFloatGrid>("SolidSDF");
         auto solid_velocity = get_input<VDBFloat3Grid>("SolidVelocity");
 
-        packed_FloatGrid3 packed_velocity, packed_viscous_vel;
-        packed_velocity.from_vec3(velocity->m_grid);
-        packed_viscous_vel.from_vec3(velocity_viscous->m_grid);
+        auto &packed_velocity = velocity->acquirePackedGrid();
+        auto &packed_viscous_vel = velocity_viscous->acquirePackedGrid();
 
         FLIP_vdb::solve_viscosity(packed_velocity, packed_viscous_vel, liquid_sdf->m_grid, solid_sdf->m_grid,
                                   solid_velocity->m_grid, viscosity_grid->m_grid, density, dt);
@@ -105,7 +103,7 @@ struct SolveVariationalViscosity : zeno::INode {
         vdb_velocity_extrapolator::union_extrapolate(n, packed_viscous_vel.v[0], packed_viscous_vel.v[1],
                                                      packed_viscous_vel.v[2], &(liquid_sdf->m_grid->tree()));
 
-        packed_viscous_vel.to_vec3(velocity_viscous->m_grid);
+        velocity_viscous->syncPackedToGrid();
     }
 };
 
@@ -46,8 +46,7 @@ struct SubtractPressureGradient : zeno::INode {
     auto tension_coef = get_input("SurfaceTension")->as<zeno::NumericObject>()->get<float>();
     bool enable_tension = tension_coef > 0? true : false;
 
-    packed_FloatGrid3 packed_velocity;
-    packed_velocity.from_vec3(velocity->m_grid);
+    auto &packed_velocity = velocity->acquirePackedGrid();
 
     FLIP_vdb::apply_pressure_gradient(
         liquid_sdf->m_grid, solid_sdf->m_grid,
@@ -62,7 +61,7 @@ struct SubtractPressureGradient : zeno::INode {
 		                            packed_velocity.v[2],
 	  	                          &(liquid_sdf->m_grid->tree()));
 
-    packed_velocity.to_vec3(velocity->m_grid);
+    velocity->syncPackedToGrid();
   }
 };
 
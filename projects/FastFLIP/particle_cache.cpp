@@ -0,0 +1,302 @@
+#include "particle_cache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <zeno/utils/log.h>
+#include <zlib.h>
+
+namespace particle_cache {
+
+namespace {
+const char kMagic[8] = {'Z', 'F', 'P', 'C', 'A', 'C', 'H', 'E'};
+const uint32_t kVersion = 1;
+
+struct FileCloser {
+  void operator()(FILE *fp) const { fclose(fp); }
+};
+using FilePtr = std::unique_ptr<FILE, FileCloser>;
+
+template <class T> void write_pod(FILE *fp, T const &t) {
+  if (fwrite(&t, sizeof(T), 1, fp) != 1)
+    throw std::runtime_error("particle cache: write failed");
+}
+template <class T> T read_pod(FILE *fp) {
+  T t;
+  if (fread(&t, sizeof(T), 1, fp) != 1)
+    throw std::runtime_error("particle cache: unexpected end of file");
+  return t;
+}
+
+// bytes left between the read position and the end of the file
+size_t bytes_left(FILE *fp, size_t file_size) {
+  long pos = ftell(fp);
+  return pos < 0 || (size_t)pos > file_size ? 0 : file_size - pos;
+}
+
+// zlib cannot inflate a stream by more than this factor
+const size_t kMaxInflateRatio = 1032;
+
+// chunks encoded or decoded by one parallel batch, bounds the memory held
+size_t batch_chunks() {
+  return std::max(1, tbb::this_task_arena::max_concurrency()) * 4;
+}
+
+// byte planes compress much better than interleaved float bytes
+void shuffle_bytes(unsigned char *dst, unsigned char const *src, size_t n,
+                   size_t elem) {
+  for (size_t b = 0; b < elem; b++)
+    for (size_t i = 0; i < n; i++)
+      dst[b * n + i] = src[i * elem + b];
+}
+void unshuffle_bytes(unsigned char *dst, unsigned char const *src, size_t n,
+                     size_t elem) {
+  for (size_t b = 0; b < elem; b++)
+    for (size_t i = 0; i < n; i++)
+      dst[i * elem + b] = src[b * n + i];
+}
+
+std::vector<unsigned char> encode_chunk(AttrView const &attr, Encoding enc,
+                                        size_t begin, size_t n, int level) {
+  size_t dim = attr.dim;
+  size_t ncomp = n * dim;
+  float const *src = attr.data + begin * dim;
+
+  std::vector<unsigned char> planes;
+  std::vector<unsigned char> blob;
+  if (enc == Encoding::Quantized16) {
+    float bmin[3], bmax[3];
+    for (size_t d = 0; d < dim; d++) {
+      bmin[d] = std::numeric_limits<float>::max();
+      bmax[d] = std::numeric_limits<float>::lowest();
+    }
+    for (size_t i = 0; i < n; i++) {
+      for (size_t d = 0; d < dim; d++) {
+        bmin[d] = std::min(bmin[d], src[i * dim + d]);
+        bmax[d] = std::max(bmax[d], src[i * dim + d]);
+      }
+    }
+    float scale[3];
+    for (size_t d = 0; d < dim; d++) {
+      if (n == 0)
+        bmin[d] = bmax[d] = 0;
+      scale[d] = bmax[d] > bmin[d] ? 65535.f / (bmax[d] - bmin[d]) : 0.f;
+    }
+    blob.resize(2 * dim * sizeof(float));
+    std::memcpy(blob.data(), bmin, dim * sizeof(float));
+    std::memcpy(blob.data() + dim * sizeof(float), bmax, dim * sizeof(float));
+
+    std::vector<uint16_t> quant(ncomp);
+    for (size_t i = 0; i < ncomp; i++) {
+      size_t d = i % dim;
+      float q = (src[i] - bmin[d]) * scale[d] + 0.5f;
+      quant[i] = (uint16_t)std::clamp(q, 0.f, 65535.f);
+    }
+    planes.resize(ncomp * sizeof(uint16_t));
+    shuffle_bytes(planes.data(), (unsigned char const *)quant.data(), ncomp,
+                  sizeof(uint16_t));
+  } else {
+    planes.resize(ncomp * sizeof(float));
+    shuffle_bytes(planes.data(), (unsigned char const *)src, ncomp,
+                  sizeof(float));
+  }
+
+  size_t header = blob.size();
+  uLongf zsize = compressBound(planes.size());
+  blob.resize(header + zsize);
+  if (compress2(blob.data() + header, &zsize, planes.data(), planes.size(),
+                level) != Z_OK)
+    throw std::runtime_error("particle cache: compression failed");
+  blob.resize(header + zsize);
+  return blob;
+}
+
+void decode_chunk(float *dst, uint8_t dim, Encoding enc, size_t n,
+                  std::vector<unsigned char> const &blob) {
+  size_t ncomp = n * dim;
+  size_t header = enc == Encoding::Quantized16 ? 2 * dim * sizeof(float) : 0;
+  size_t elem = enc == Encoding::Quantized16 ? sizeof(uint16_t) : sizeof(float);
+  if (blob.size() < header)
+    throw std::runtime_error("particle cache: corrupted chunk");
+
+  std::vector<unsigned char> planes(ncomp * elem);
+  uLongf rawsize = planes.size();
+  if (uncompress(planes.data(), &rawsize, blob.data() + header,
+                 blob.size() - header) != Z_OK ||
+      rawsize != planes.size())
+    throw std::runtime_error("particle cache: corrupted chunk");
+
+  if (enc == Encoding::Quantized16) {
+    float bmin[3], bmax[3];
+    std::memcpy(bmin, blob.data(), dim * sizeof(float));
+    std::memcpy(bmax, blob.data() + dim * sizeof(float), dim * sizeof(float));
+    std::vector<uint16_t> quant(ncomp);
+    unshuffle_bytes((unsigned char *)quant.data(), planes.data(), ncomp,
+                    sizeof(uint16_t));
+    for (size_t i = 0; i < ncomp; i++) {
+      size_t d = i % dim;
+      dst[i] = bmin[d] + quant[i] * ((bmax[d] - bmin[d]) * (1.f / 65535.f));
+    }
+  } else {
+    unshuffle_bytes((unsigned char *)dst, planes.data(), ncomp, sizeof(float));
+  }
+}
+} // namespace
+
+void write_attributes(std::string const &path, size_t count,
+                      std::vector<AttrView> const &attrs,
+                      WriteOptions const &options) {
+  if (options.chunk_size == 0)
+    throw std::runtime_error("particle cache: chunk size must be positive");
+  std::vector<Encoding> encodings;
+  for (auto const &attr : attrs) {
+    if (attr.dim != 1 && attr.dim != 3)
+      throw std::runtime_error("particle cache: unsupported dim of attribute " +
+                               attr.name);
+    bool quantize =
+        attr.name == "pos" ? options.quantize_pos : options.quantize_others;
+    encodings.push_back(quantize ? Encoding::Quantized16 : Encoding::Float32);
+  }
+
+  FilePtr fp(fopen(path.c_str(), "wb"));
+  if (!fp)
+    throw std::runtime_error("particle cache: cannot open " + path);
+  zeno::log_info("writing {} particles to {}", count, path);
+
+  if (fwrite(kMagic, sizeof(kMagic), 1, fp.get()) != 1)
+    throw std::runtime_error("particle cache: write failed");
+  write_pod<uint32_t>(fp.get(), kVersion);
+  write_pod<uint64_t>(fp.get(), count);
+  write_pod<uint32_t>(fp.get(), options.chunk_size);
+  write_pod<uint32_t>(fp.get(), attrs.size());
+  for (size_t a = 0; a < attrs.size(); a++) {
+    write_pod<uint32_t>(fp.get(), attrs[a].name.size());
+    if (fwrite(attrs[a].name.data(), 1, attrs[a].name.size(), fp.get()) !=
+        attrs[a].name.size())
+      throw std::runtime_error("particle cache: write failed");
+    write_pod<uint8_t>(fp.get(), attrs[a].dim);
+    write_pod<uint8_t>(fp.get(), (uint8_t)encodings[a]);
+  }
+
+  size_t nchunks = (count + options.chunk_size - 1) / options.chunk_size;
+  size_t nbatch = batch_chunks();
+  std::vector<std::vector<unsigned char>> blobs(nbatch * attrs.size());
+  for (size_t first = 0; first < nchunks; first += nbatch) {
+    size_t last = std::min(nchunks, first + nbatch);
+    tbb::parallel_for((size_t)0, (last - first) * attrs.size(), [&](size_t job) {
+      size_t c = first + job / attrs.size();
+      size_t a = job % attrs.size();
+      size_t begin = c * options.chunk_size;
+      size_t n = std::min<size_t>(options.chunk_size, count - begin);
+      blobs[job] = encode_chunk(attrs[a], encodings[a], begin, n,
+                                options.compression_level);
+    });
+    for (size_t job = 0; job < (last - first) * attrs.size(); job++) {
+      write_pod<uint64_t>(fp.get(), blobs[job].size());
+      if (fwrite(blobs[job].data(), 1, blobs[job].size(), fp.get()) !=
+          blobs[job].size())
+        throw std::runtime_error("particle cache: write failed");
+    }
+  }
+}
+
+void write_primitive(std::string const &path, zeno::PrimitiveObject const &prim,
+                     WriteOptions const &options) {
+  std::vector<AttrView> attrs;
+  prim.verts.forall_attr([&](auto const &key, auto const &arr) {
+    using T = std::decay_t<decltype(arr[0])>;
+    attrs.push_back({key, (float const *)arr.data(),
+                     (uint8_t)(std::is_same_v<T, zeno::vec3f> ? 3 : 1)});
+  });
+  write_attributes(path, prim.verts.size(), attrs, options);
+}
+
+void read_primitive(std::string const &path, zeno::PrimitiveObject &prim) {
+  FilePtr fp(fopen(path.c_str(), "rb"));
+  if (!fp)
+    throw std::runtime_error("particle cache: cannot open " + path);
+  size_t file_size = 0;
+  if (fseek(fp.get(), 0, SEEK_END) == 0 && ftell(fp.get()) > 0)
+    file_size = ftell(fp.get());
+  rewind(fp.get());
+
+  char magic[sizeof(kMagic)];
+  if (fread(magic, sizeof(magic), 1, fp.get()) != 1 ||
+      std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+    throw std::runtime_error("particle cache: " + path +
+                             " is not a particle cache");
+  if (read_pod<uint32_t>(fp.get()) != kVersion)
+    throw std::runtime_error("particle cache: unsupported version of " + path);
+  size_t count = read_pod<uint64_t>(fp.get());
+  size_t chunk_size = read_pod<uint32_t>(fp.get());
+  size_t nattrs = read_pod<uint32_t>(fp.get());
+  if (chunk_size == 0)
+    throw std::runtime_error("particle cache: corrupted header of " + path);
+  // every attribute takes at least a name length, a dim and an encoding,
+  // every chunk of it at least its blob size, and no blob inflates to more
+  // than kMaxInflateRatio times its size, so check before allocating
+  size_t nchunks = count / chunk_size + (count % chunk_size != 0);
+  size_t left = bytes_left(fp.get(), file_size);
+  if ((count != 0 && nattrs == 0) ||
+      nattrs > left / (sizeof(uint32_t) + 2 * sizeof(uint8_t)) ||
+      (nattrs != 0 && nchunks > left / nattrs / sizeof(uint64_t)) ||
+      count / kMaxInflateRatio > left / sizeof(uint16_t))
+    throw std::runtime_error("particle cache: corrupted header of " + path);
+
+  prim.verts.clear_with_attr();
+  prim.verts.resize(count);
+  std::vector<float *> dsts(nattrs);
+  std::vector<uint8_t> dims(nattrs);
+  std::vector<Encoding> encodings(nattrs);
+  for (size_t a = 0; a < nattrs; a++) {
+    size_t name_size = read_pod<uint32_t>(fp.get());
+    if (name_size > bytes_left(fp.get(), file_size))
+      throw std::runtime_error("particle cache: corrupted header of " + path);
+    std::string name(name_size, '\0');
+    if (fread(name.data(), 1, name.size(), fp.get()) != name.size())
+      throw std::runtime_error("particle cache: unexpected end of file");
+    dims[a] = read_pod<uint8_t>(fp.get());
+    encodings[a] = (Encoding)read_pod<uint8_t>(fp.get());
+    if (encodings[a] != Encoding::Float32 &&
+        encodings[a] != Encoding::Quantized16)
+      throw std::runtime_error("particle cache: bad encoding of " + name);
+    if (dims[a] == 3 && name == "pos")
+      dsts[a] = (float *)prim.verts.values.data();
+    else if (dims[a] == 3)
+      dsts[a] = (float *)prim.verts.add_attr<zeno::vec3f>(name).data();
+    else if (dims[a] == 1 && name != "pos")
+      dsts[a] = prim.verts.add_attr<float>(name).data();
+    else
+      throw std::runtime_error("particle cache: bad attribute " + name);
+  }
+  size_t nbatch = batch_chunks();
+  std::vector<std::vector<unsigned char>> blobs(nbatch * nattrs);
+  for (size_t first = 0; first < nchunks; first += nbatch) {
+    size_t last = std::min(nchunks, first + nbatch);
+    size_t njobs = (last - first) * nattrs;
+    for (size_t job = 0; job < njobs; job++) {
+      size_t blob_size = read_pod<uint64_t>(fp.get());
+      if (blob_size > bytes_left(fp.get(), file_size))
+        throw std::runtime_error("particle cache: unexpected end of file");
+      blobs[job].resize(blob_size);
+      if (fread(blobs[job].data(), 1, blobs[job].size(), fp.get()) !=
+          blobs[job].size())
+        throw std::runtime_error("particle cache: unexpected end of file");
+    }
+    tbb::parallel_for((size_t)0, njobs, [&](size_t job) {
+      size_t c = first + job / nattrs;
+      size_t a = job % nattrs;
+      size_t begin = c * chunk_size;
+      size_t n = std::min(chunk_size, count - begin);
+      decode_chunk(dsts[a] + begin * dims[a], dims[a], encodings[a], n,
+                   blobs[job]);
+    });
+  }
+}
+
+} // namespace particle_cache
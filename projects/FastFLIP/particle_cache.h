@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <zeno/types/PrimitiveObject.h>
+
+// chunked particle cache, a faster and smaller replacement of bgeo for
+// dumping the FLIP particles every frame.
+//
+// file layout (little endian):
+//   "ZFPCACHE" u32 version, u64 particle count, u32 chunk size, u32 attr count
+//   per attr: u32 name length, name, u8 dim (1 or 3), u8 encoding
+//   per chunk, per attr: u64 blob size, blob
+// a blob is the zlib compressed, byte shuffled chunk of one attribute.
+// quantized attributes store their per chunk bounds (dim mins, dim maxs,
+// float32, uncompressed) in front of the compressed 16 bit values.
+// chunks are encoded in parallel and written in order, so only a bounded
+// number of chunks is held in memory at a time.
+namespace particle_cache {
+
+enum class Encoding : uint8_t {
+  Float32 = 0,
+  // 16 bit per component relative to the chunk bounds
+  Quantized16 = 1,
+};
+
+struct WriteOptions {
+  uint32_t chunk_size = 1 << 16;
+  // zlib level, 1 is usually as good as it gets for float data
+  int compression_level = 1;
+  // quantization is lossy, off unless asked for
+  bool quantize_pos = false;
+  bool quantize_others = false;
+};
+
+// writes pos and every float / vec3f vertex attribute of the primitive
+void write_primitive(std::string const &path, zeno::PrimitiveObject const &prim,
+                     WriteOptions const &options = {});
+
+// a contiguous float array with dim components per particle
+struct AttrView {
+  std::string name;
+  float const *data;
+  uint8_t dim;
+};
+
+// attrs must contain "pos", each view holds count particles
+void write_attributes(std::string const &path, size_t count,
+                      std::vector<AttrView> const &attrs,
+                      WriteOptions const &options = {});
+
+// replaces the vertices of prim by the particles in the cache
+void read_primitive(std::string const &path, zeno::PrimitiveObject &prim);
+
+} // namespace particle_cache
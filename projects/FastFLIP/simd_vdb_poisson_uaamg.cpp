@@ -1,5 +1,6 @@
 #include "simd_vdb_poisson_uaamg.h"
 
+#include <algorithm>
 #include <atomic>
 #include <immintrin.h>
 #include <unordered_map>
@@ -406,6 +407,116 @@ LaplacianWithLevel::LaplacianWithLevel(const LaplacianWithLevel& fineLevel, Lapl
     initializeFromFineLevel(fineLevel);
 }
 
+namespace {
+//a coarse voxel is a dof if any of its eight fine voxels is a dof
+void markCoarseDofLeaf(openvdb::Int32Tree::LeafNodeType& leaf, const LaplacianWithLevel& fineLevel)
+{
+    auto fineDofAxr{ fineLevel.mDofIndex->getConstUnsafeAccessor() };
+    for (auto iter = leaf.beginValueAll(); iter; ++iter) {
+        //the global coordinate in the coarse level
+        auto coarseGlobalCoord{ iter.getCoord().asVec3i() };
+        auto fineBaseCoord = coarseGlobalCoord * 2;
+
+        bool fineDofNotFound = true;
+        for (int ii = 0; ii < 2 && fineDofNotFound; ii++) {
+            for (int jj = 0; jj < 2 && fineDofNotFound; jj++) {
+                for (int kk = 0; kk < 2 && fineDofNotFound; kk++) {
+                    if (fineDofAxr.isValueOn(
+                        openvdb::Coord(fineBaseCoord).offsetBy(ii, jj, kk))) {
+                        fineDofNotFound = false;
+                    }
+                }
+            }
+        }//for all fine voxels accociated
+
+        if (fineDofNotFound) {
+            iter.setValueOff();
+        }
+        else {
+            iter.setValueOn();
+        }
+    }//end for all voxel in this leaf
+}
+
+//coarse terms of one coarse leaf, see initializeFromFineLevel for the derivation
+//the diagonal and face term leaves must exist in the coarse level
+void setCoarseLeafTerms(const openvdb::Int32Tree::LeafNodeType& leaf, const LaplacianWithLevel& fineLevel, LaplacianWithLevel& coarseLevel)
+{
+    auto xAxr{ fineLevel.mXEntry->getConstUnsafeAccessor() };
+    auto yAxr{ fineLevel.mYEntry->getConstUnsafeAccessor() };
+    auto zAxr{ fineLevel.mZEntry->getConstUnsafeAccessor() };
+    auto diagAxr{ fineLevel.mDiagonal->getConstUnsafeAccessor() };
+    auto fineDofAxr{ fineLevel.mDofIndex->getConstUnsafeAccessor() };
+
+    auto* diagLeaf = coarseLevel.mDiagonal->tree().probeLeaf(leaf.origin());
+    auto* xLeaf = coarseLevel.mXEntry->tree().probeLeaf(leaf.origin());
+    auto* yLeaf = coarseLevel.mYEntry->tree().probeLeaf(leaf.origin());
+    auto* zLeaf = coarseLevel.mZEntry->tree().probeLeaf(leaf.origin());
+
+    for (auto iter = leaf.cbeginValueOn(); iter; ++iter) {
+        //each voxel only record the flux of its and its below dof
+        float diag = 0, x = 0, y = 0, z = 0;
+        //the global coordinate in the coarse level
+        auto coarseGlobalCoord{ iter.getCoord().asVec3i() };
+        auto fineBaseCoord = openvdb::Coord(coarseGlobalCoord * 2);
+
+        //loop over the 8 fine cells 
+        for (int ii = 0; ii < 2; ii++) {
+            for (int jj = 0; jj < 2; jj++) {
+                for (int kk = 0; kk < 2; kk++) {
+                    const auto fineCoord = fineBaseCoord.offsetBy(ii, jj, kk);
+
+                    //contribution to diag
+                    if (fineDofAxr.isValueOn(fineCoord)) {
+                        diag += diagAxr.getValue(fineCoord);
+
+                        //three face terms
+                        if (fineDofAxr.isValueOn(fineCoord.offsetBy(-1, 0, 0))) {
+                            if (ii == 0) {
+                                //contribute to the neg x term
+                                x += xAxr.getValue(fineCoord);
+                            }
+                            else {
+                                //this face will decrease two fine dofs
+                                //diagonal terms
+                                diag += 2 * xAxr.getValue(fineCoord);
+                            }
+                        }//end if x- neib on
+
+                        if (fineDofAxr.isValueOn(fineCoord.offsetBy(0, -1, 0))) {
+                            if (jj == 0) {
+                                y += yAxr.getValue(fineCoord);
+                            }
+                            else {
+                                diag += 2 * yAxr.getValue(fineCoord);
+                            }
+                        }//end if y- neib on
+
+                        if (fineDofAxr.isValueOn(fineCoord.offsetBy(0, 0, -1))) {
+                            if (kk == 0) {
+                                z += zAxr.getValue(fineCoord);
+                            }
+                            else {
+                                diag += 2 * zAxr.getValue(fineCoord);
+                            }
+                        }//end if z- neib on
+                    }//end if this voxel is on
+                }//end fine kk
+            }//end fine jj
+        }//end fine ii
+
+        //coefficient R accounts for 1/8
+        //Then there is an additional 1/2
+        auto offset = iter.offset();
+        const float factor = 0.5f * (1.0f / 8.0f);
+        diagLeaf->setValueOnly(offset, diag * factor);
+        xLeaf->setValueOnly(offset, x * factor);
+        yLeaf->setValueOnly(offset, y * factor);
+        zLeaf->setValueOnly(offset, z * factor);
+    }//end loop over all coarse dofs
+}
+}//end namespace
+
 void LaplacianWithLevel::initializeFromFineLevel(const LaplacianWithLevel& fineLevel)
 {
     mDt = fineLevel.mDt;
@@ -436,31 +547,7 @@ void LaplacianWithLevel::initializeFromFineLevel(const LaplacianWithLevel& fineL
     //piecewise constant interpolation and restriction function
     //coarse voxel =8 fine voxels
     mDofLeafManager->foreach([&](openvdb::Int32Tree::LeafNodeType& leaf, openvdb::Index) {
-        auto fineDofAxr{ fineLevel.mDofIndex->getConstUnsafeAccessor() };
-        for (auto iter = leaf.beginValueAll(); iter; ++iter) {
-            //the global coordinate in the coarse level
-            auto coarseGlobalCoord{ iter.getCoord().asVec3i() };
-            auto fineBaseCoord = coarseGlobalCoord * 2;
-
-            bool fineDofNotFound = true;
-            for (int ii = 0; ii < 2 && fineDofNotFound; ii++) {
-                for (int jj = 0; jj < 2 && fineDofNotFound; jj++) {
-                    for (int kk = 0; kk < 2 && fineDofNotFound; kk++) {
-                        if (fineDofAxr.isValueOn(
-                            openvdb::Coord(fineBaseCoord).offsetBy(ii, jj, kk))) {
-                            fineDofNotFound = false;
-                        }
-                    }
-                }
-            }//for all fine voxels accociated
-
-            if (fineDofNotFound) {
-                iter.setValueOff();
-            }
-            else {
-                iter.setValueOn();
-            }
-        }//end for all voxel in this leaf
+        markCoarseDofLeaf(leaf, fineLevel);
         });
     setDofIndex(mDofIndex);
 
@@ -539,86 +626,139 @@ void LaplacianWithLevel::initializeFromFineLevel(const LaplacianWithLevel& fineL
 
 
     auto setCoarseLevelTerms = [&](openvdb::Int32Tree::LeafNodeType& leaf, openvdb::Index) {
-        auto xAxr{ fineLevel.mXEntry->getConstUnsafeAccessor() };
-        auto yAxr{ fineLevel.mYEntry->getConstUnsafeAccessor() };
-        auto zAxr{ fineLevel.mZEntry->getConstUnsafeAccessor() };
-        auto diagAxr{ fineLevel.mDiagonal->getConstUnsafeAccessor() };
-        auto fineDofAxr{ fineLevel.mDofIndex->getConstUnsafeAccessor() };
+        setCoarseLeafTerms(leaf, fineLevel, *this);
+    };//end set terms
 
-        auto* diagLeaf = mDiagonal->tree().probeLeaf(leaf.origin());
-        auto* xLeaf = mXEntry->tree().probeLeaf(leaf.origin());
-        auto* yLeaf = mYEntry->tree().probeLeaf(leaf.origin());
-        auto* zLeaf = mZEntry->tree().probeLeaf(leaf.origin());
+    mDofLeafManager->foreach(setCoarseLevelTerms);
 
-        for (auto iter = leaf.cbeginValueOn(); iter; ++iter) {
-            //each voxel only record the flux of its and its below dof
-            float diag = 0, x = 0, y = 0, z = 0;
-            //the global coordinate in the coarse level
-            auto coarseGlobalCoord{ iter.getCoord().asVec3i() };
-            auto fineBaseCoord = openvdb::Coord(coarseGlobalCoord * 2);
-
-            //loop over the 8 fine cells 
-            for (int ii = 0; ii < 2; ii++) {
-                for (int jj = 0; jj < 2; jj++) {
-                    for (int kk = 0; kk < 2; kk++) {
-                        const auto fineCoord = fineBaseCoord.offsetBy(ii, jj, kk);
-
-                        //contribution to diag
-                        if (fineDofAxr.isValueOn(fineCoord)) {
-                            diag += diagAxr.getValue(fineCoord);
-
-                            //three face terms
-                            if (fineDofAxr.isValueOn(fineCoord.offsetBy(-1, 0, 0))) {
-                                if (ii == 0) {
-                                    //contribute to the neg x term
-                                    x += xAxr.getValue(fineCoord);
-                                }
-                                else {
-                                    //this face will decrease two fine dofs
-                                    //diagonal terms
-                                    diag += 2 * xAxr.getValue(fineCoord);
-                                }
-                            }//end if x- neib on
+    trimDefaultNodes();
+    initializeApplyOperator();
+}
 
-                            if (fineDofAxr.isValueOn(fineCoord.offsetBy(0, -1, 0))) {
-                                if (jj == 0) {
-                                    y += yAxr.getValue(fineCoord);
-                                }
-                                else {
-                                    diag += 2 * yAxr.getValue(fineCoord);
-                                }
-                            }//end if y- neib on
+void LaplacianWithLevel::refreshFromFineLevel(const LaplacianWithLevel& fineLevel,
+    const std::vector<openvdb::Coord>& changedFineLeaves,
+    std::vector<openvdb::Coord>& outChangedLeaves)
+{
+    //a fine leaf at o covers the coarse voxels [o/2, o/2+3], the coarse terms
+    //also look one fine voxel down, so coarse voxels up to o/2+4 may change
+    auto leafOrigin = [](const openvdb::Coord& c) {
+        return openvdb::Coord(c.x() & ~7, c.y() & ~7, c.z() & ~7);
+    };
+    outChangedLeaves.clear();
+    for (const auto& fineOrigin : changedFineLeaves) {
+        auto lo = openvdb::Coord(fineOrigin.asVec3i() / 2);
+        auto hi = lo.offsetBy(4);
+        for (int ii = 0; ii < 2; ii++) {
+            for (int jj = 0; jj < 2; jj++) {
+                for (int kk = 0; kk < 2; kk++) {
+                    outChangedLeaves.push_back(leafOrigin(openvdb::Coord(
+                        ii ? hi.x() : lo.x(), jj ? hi.y() : lo.y(), kk ? hi.z() : lo.z())));
+                }
+            }
+        }
+    }
+    std::sort(outChangedLeaves.begin(), outChangedLeaves.end());
+    outChangedLeaves.erase(std::unique(outChangedLeaves.begin(), outChangedLeaves.end()), outChangedLeaves.end());
+
+    //topology changes are serial, the per leaf work is parallel
+    size_t nLeaf = outChangedLeaves.size();
+    std::vector<openvdb::Int32Tree::LeafNodeType*> dofLeaves(nLeaf);
+    std::vector<openvdb::FloatTree::LeafNodeType*> diagLeaves(nLeaf), xLeaves(nLeaf), yLeaves(nLeaf), zLeaves(nLeaf);
+    for (size_t i = 0; i < nLeaf; i++) {
+        dofLeaves[i] = mDofIndex->tree().touchLeaf(outChangedLeaves[i]);
+        diagLeaves[i] = mDiagonal->tree().touchLeaf(outChangedLeaves[i]);
+        xLeaves[i] = mXEntry->tree().touchLeaf(outChangedLeaves[i]);
+        yLeaves[i] = mYEntry->tree().touchLeaf(outChangedLeaves[i]);
+        zLeaves[i] = mZEntry->tree().touchLeaf(outChangedLeaves[i]);
+    }
 
-                            if (fineDofAxr.isValueOn(fineCoord.offsetBy(0, 0, -1))) {
-                                if (kk == 0) {
-                                    z += zAxr.getValue(fineCoord);
-                                }
-                                else {
-                                    diag += 2 * zAxr.getValue(fineCoord);
-                                }
-                            }//end if z- neib on
-                        }//end if this voxel is on
-                    }//end fine kk
-                }//end fine jj
-            }//end fine ii
-
-            //coefficient R accounts for 1/8
-            //Then there is an additional 1/2
-            auto offset = iter.offset();
-            const float factor = 0.5f * (1.0f / 8.0f);
-            diagLeaf->setValueOnly(offset, diag * factor);
-            xLeaf->setValueOnly(offset, x * factor);
-            yLeaf->setValueOnly(offset, y * factor);
-            zLeaf->setValueOnly(offset, z * factor);
-        }//end loop over all coarse dofs
-    };//end set terms
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, nLeaf), [&](const tbb::blocked_range<size_t>& r) {
+        for (size_t i = r.begin(); i != r.end(); ++i) {
+            markCoarseDofLeaf(*dofLeaves[i], fineLevel);
+            //same state as the topology copy in initializeFromFineLevel
+            diagLeaves[i]->fill(mDiagonal->background(), false);
+            xLeaves[i]->fill(mXEntry->background(), false);
+            yLeaves[i]->fill(mYEntry->background(), false);
+            zLeaves[i]->fill(mZEntry->background(), false);
+            diagLeaves[i]->setValueMask(dofLeaves[i]->getValueMask());
+            xLeaves[i]->setValueMask(dofLeaves[i]->getValueMask());
+            yLeaves[i]->setValueMask(dofLeaves[i]->getValueMask());
+            zLeaves[i]->setValueMask(dofLeaves[i]->getValueMask());
+            setCoarseLeafTerms(*dofLeaves[i], fineLevel, *this);
+        }
+        });
 
-    mDofLeafManager->foreach(setCoarseLevelTerms);
+    //drop leaves that no longer hold any dof
+    for (size_t i = 0; i < nLeaf; i++) {
+        if (dofLeaves[i]->isEmpty()) {
+            delete mDofIndex->tree().stealNode<openvdb::Int32Tree::LeafNodeType>(outChangedLeaves[i], -1, false);
+            delete mDiagonal->tree().stealNode<openvdb::FloatTree::LeafNodeType>(outChangedLeaves[i], mDiagonal->background(), false);
+            delete mXEntry->tree().stealNode<openvdb::FloatTree::LeafNodeType>(outChangedLeaves[i], mXEntry->background(), false);
+            delete mYEntry->tree().stealNode<openvdb::FloatTree::LeafNodeType>(outChangedLeaves[i], mYEntry->background(), false);
+            delete mZEntry->tree().stealNode<openvdb::FloatTree::LeafNodeType>(outChangedLeaves[i], mZEntry->background(), false);
+        }
+    }
 
+    mDofLeafManager = std::make_unique<openvdb::tree::LeafManager<openvdb::Int32Tree>>(mDofIndex->tree());
+    setDofIndex(mDofIndex);
     trimDefaultNodes();
     initializeApplyOperator();
 }
 
+void LaplacianWithLevel::changedLeaves(const LaplacianWithLevel& oldLevel, const LaplacianWithLevel& newLevel,
+    std::vector<openvdb::Coord>& outChangedLeaves)
+{
+    std::vector<openvdb::Coord> origins;
+    origins.reserve(oldLevel.mDofIndex->tree().leafCount() + newLevel.mDofIndex->tree().leafCount());
+    for (auto leaf = oldLevel.mDofIndex->tree().cbeginLeaf(); leaf; ++leaf) {
+        origins.push_back(leaf->origin());
+    }
+    for (auto leaf = newLevel.mDofIndex->tree().cbeginLeaf(); leaf; ++leaf) {
+        origins.push_back(leaf->origin());
+    }
+    std::sort(origins.begin(), origins.end());
+    origins.erase(std::unique(origins.begin(), origins.end()), origins.end());
+
+    std::vector<char> isChanged(origins.size(), 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, origins.size()), [&](const tbb::blocked_range<size_t>& r) {
+        openvdb::FloatGrid::ConstUnsafeAccessor oldAxr[4] = {
+            oldLevel.mDiagonal->getConstUnsafeAccessor(), oldLevel.mXEntry->getConstUnsafeAccessor(),
+            oldLevel.mYEntry->getConstUnsafeAccessor(), oldLevel.mZEntry->getConstUnsafeAccessor() };
+        openvdb::FloatGrid::ConstUnsafeAccessor newAxr[4] = {
+            newLevel.mDiagonal->getConstUnsafeAccessor(), newLevel.mXEntry->getConstUnsafeAccessor(),
+            newLevel.mYEntry->getConstUnsafeAccessor(), newLevel.mZEntry->getConstUnsafeAccessor() };
+        for (size_t i = r.begin(); i != r.end(); ++i) {
+            auto* oldLeaf = oldLevel.mDofIndex->tree().probeConstLeaf(origins[i]);
+            auto* newLeaf = newLevel.mDofIndex->tree().probeConstLeaf(origins[i]);
+            bool oldEmpty = !oldLeaf || oldLeaf->isEmpty();
+            bool newEmpty = !newLeaf || newLeaf->isEmpty();
+            if (oldEmpty && newEmpty) {
+                continue;
+            }
+            if (oldEmpty != newEmpty || oldLeaf->getValueMask() != newLeaf->getValueMask()) {
+                isChanged[i] = 1;
+                continue;
+            }
+            for (auto iter = newLeaf->cbeginValueOn(); iter && !isChanged[i]; ++iter) {
+                const auto globalCoord = iter.getCoord();
+                for (int c = 0; c < 4; c++) {
+                    if (oldAxr[c].getValue(globalCoord) != newAxr[c].getValue(globalCoord)) {
+                        isChanged[i] = 1;
+                        break;
+                    }
+                }
+            }
+        }
+        });
+
+    outChangedLeaves.clear();
+    for (size_t i = 0; i < origins.size(); i++) {
+        if (isChanged[i]) {
+            outChangedLeaves.push_back(origins[i]);
+        }
+    }
+}
+
 namespace {
 struct BuildFinestMatrix {
     BuildFinestMatrix(
@@ -816,7 +956,7 @@ void LaplacianWithLevel::setDofIndex(openvdb::Int32Grid::Ptr in_out_dofidx)
     dofLeafMan.foreach(set_dof_id);
 
     //return the total number of degree of freedom
-    mNumDof = *dofEndInEachLeaf.crbegin();
+    mNumDof = dofEndInEachLeaf.empty() ? 0 : *dofEndInEachLeaf.crbegin();
 }
 
 
@@ -1962,8 +2102,7 @@ void LaplacianWithLevel::trimDefaultNodes(
 void PoissonSolver::constructMultigridHierarchy()
 {
     
-    int maxCoarsestDOF = 4000;
-    while (mMultigridHierarchy.back()->mNumDof > maxCoarsestDOF) {
+    while (mMultigridHierarchy.back()->mNumDof > sMaxCoarsestDOF) {
         //CSim::TimerMan::timer("Step/SIMD/levels/lv" + std::to_string(mMultigridHierarchy.size())).start();
         LaplacianWithLevel::Ptr coarserLevel = std::make_shared<LaplacianWithLevel>(
             *mMultigridHierarchy.back(), LaplacianWithLevel::Coarsening()
@@ -1990,6 +2129,64 @@ void PoissonSolver::constructMultigridHierarchy()
     printf("levels: %zd Dof:%d\n", mMultigridHierarchy.size(), mMultigridHierarchy[0]->mNumDof);
 }
 
+void PoissonSolver::updateFinestLevel(LaplacianWithLevel::Ptr in_finest_level_matrix)
+{
+    auto oldFinest = mMultigridHierarchy[0];
+    bool rebuild = mMultigridHierarchy.size() < 2 ||
+        in_finest_level_matrix->mNumDof <= sMaxCoarsestDOF ||
+        in_finest_level_matrix->mDt != oldFinest->mDt ||
+        in_finest_level_matrix->mDxThisLevel != oldFinest->mDxThisLevel;
+
+    std::vector<openvdb::Coord> changed;
+    if (!rebuild) {
+        LaplacianWithLevel::changedLeaves(*oldFinest, *in_finest_level_matrix, changed);
+        //refreshing most of the leaves is slower than building from scratch
+        rebuild = changed.size() * 2 > in_finest_level_matrix->mDofIndex->tree().leafCount();
+    }
+
+    if (rebuild) {
+        mMultigridHierarchy.clear();
+        mMuCycleLHSs.clear();
+        mMuCycleRHSs.clear();
+        mMuCycleTemps.clear();
+        mMultigridHierarchy.push_back(in_finest_level_matrix);
+        constructMultigridHierarchy();
+        return;
+    }
+
+    auto resetScratchpad = [&](int level) {
+        mMuCycleLHSs[level] = mMultigridHierarchy[level]->getZeroVectorGrid();
+        mMuCycleRHSs[level] = mMuCycleLHSs[level]->deepCopy();
+        mMuCycleTemps[level] = mMuCycleLHSs[level]->deepCopy();
+    };
+
+    mMultigridHierarchy[0] = in_finest_level_matrix;
+    resetScratchpad(0);
+    bool coarsestChanged = false;
+    for (int level = 1; level < mMultigridHierarchy.size() && !changed.empty(); level++) {
+        std::vector<openvdb::Coord> coarseChanged;
+        mMultigridHierarchy[level]->refreshFromFineLevel(*mMultigridHierarchy[level - 1], changed, coarseChanged);
+        resetScratchpad(level);
+        changed.swap(coarseChanged);
+        coarsestChanged = (level + 1 == mMultigridHierarchy.size());
+    }
+
+    //the coarsest level may have grown beyond the direct solver size
+    while (mMultigridHierarchy.back()->mNumDof > sMaxCoarsestDOF) {
+        mMultigridHierarchy.push_back(std::make_shared<LaplacianWithLevel>(
+            *mMultigridHierarchy.back(), LaplacianWithLevel::Coarsening()));
+        mMuCycleLHSs.push_back(mMultigridHierarchy.back()->getZeroVectorGrid());
+        mMuCycleRHSs.push_back(mMuCycleLHSs.back()->deepCopy());
+        mMuCycleTemps.push_back(mMuCycleLHSs.back()->deepCopy());
+        coarsestChanged = true;
+    }
+
+    if (coarsestChanged) {
+        constructCoarsestLevelExactSolver();
+    }
+    printf("levels: %zd Dof:%d (refreshed)\n", mMultigridHierarchy.size(), mMultigridHierarchy[0]->mNumDof);
+}
+
 template<int mu_time, bool skip_first_iter>
 void PoissonSolver::muCyclePreconditioner(const openvdb::FloatGrid::Ptr in_out_lhs, const openvdb::FloatGrid::Ptr in_rhs, const int level, int n)
 {
@@ -88,6 +88,17 @@ struct LaplacianWithLevel {
 
     void initializeFromFineLevel(const LaplacianWithLevel& child);
 
+    //refresh this coarse level in place after the fine level changed inside
+    //the given fine leaves, only the coarse leaves covering them are rebuilt
+    //the origins of those coarse leaves are returned for the next level
+    void refreshFromFineLevel(const LaplacianWithLevel& child,
+        const std::vector<openvdb::Coord>& in_changed_fine_leaves,
+        std::vector<openvdb::Coord>& out_changed_leaves);
+
+    //origins of the dof leaves whose dof layout or coefficients differ between two levels
+    static void changedLeaves(const LaplacianWithLevel& in_old, const LaplacianWithLevel& in_new,
+        std::vector<openvdb::Coord>& out_changed_leaves);
+
     void initializeFinest(openvdb::FloatGrid::Ptr in_liquid_phi,
         openvdb::Vec3fGrid::Ptr in_face_weights);
 
@@ -169,6 +180,11 @@ public:
         mSmoother = SmootherOption::ScheduledRelaxedJacobi;
     }
 
+    //replace the finest level by a new matrix and refresh the coarse levels
+    //only where the dof layout or coefficients changed
+    //falls back to building the hierarchy from scratch when most leaves changed
+    void updateFinestLevel(LaplacianWithLevel::Ptr in_finest_level_matrix);
+
     SuccessType solveMultigridPCG(openvdb::FloatGrid::Ptr in_out_presssure, openvdb::FloatGrid::Ptr in_rhs);
     SuccessType solvePureMultigrid(openvdb::FloatGrid::Ptr in_out_presssure, openvdb::FloatGrid::Ptr in_rhs);
 
@@ -179,6 +195,8 @@ public:
     std::vector<LaplacianWithLevel::Ptr> mMultigridHierarchy;
 
 private:
+    static const int sMaxCoarsestDOF = 4000;
+
     //In the preconditioner version, the parent level Poisson matrix is effectively multiplied by 0.5
     //Therefore the propagated back error correction is about twice as large as 
     //the one obtained by solving the matrix built upon Galerkin coarsening principle
@@ -215,6 +233,15 @@ private:
     std::vector<openvdb::FloatGrid::Ptr> mMuCycleRHSs;
     std::vector<openvdb::FloatGrid::Ptr> mMuCycleTemps;
 };
+
+//the multigrid hierarchy kept alive between the pressure solves of a simulation
+//matrices are always built with the dt of the first solve (mRefDt), since
+//L(dt) = dt / mRefDt * L(mRefDt) the solution is rescaled by mRefDt / dt
+struct PoissonHierarchyCache {
+    std::shared_ptr<PoissonSolver> mSolver;
+    float mRefDt = 0;
+    float mDx = 0;
+};
 }//end namespace simd_uaamg
 
 
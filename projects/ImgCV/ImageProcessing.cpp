@@ -9,9 +9,12 @@
 #include <zeno/utils/scope_exit.h>
 #include <stdexcept>
 #include <zeno/utils/image_proc.h>
+#include <climits>
 #include <cmath>
 #include <zeno/utils/log.h>
 #include <opencv2/opencv.hpp>
+#include "imgcv.h"
+#include "imgtile.h"
 
 namespace zeno {
 
@@ -262,65 +265,33 @@ void rotateimage(std::shared_ptr<PrimitiveObject> src, std::shared_ptr<Primitive
     dst->verts.resize(rotatedWidth * rotatedHeight);
     dst->userData().set2("w", rotatedWidth);
     dst->userData().set2("h", rotatedHeight);
-    if(src->verts.has_attr("alpha")){
-        dst->verts.add_attr<float>("alpha");
-        if(balpha){
-            for(int i = 0;i<dst->size();i++){
-                dst->verts.attr<float>("alpha")[i] = 0;
-            }
-        }
-        else{
-            for(int i = 0;i<dst->size();i++){
-                dst->verts.attr<float>("alpha")[i] = 1;
-            }
-        }
-        for (int y = 0; y < rotatedHeight; ++y) {
-            for (int x = 0; x < rotatedWidth; ++x) {
 
-                int srcX = static_cast<int>((x - rotatedWidth / 2) * cos(-radians) - (y - rotatedHeight / 2) * sin(-radians) + centerX);
-                int srcY = static_cast<int>((x - rotatedWidth / 2) * sin(-radians) + (y - rotatedHeight / 2) * cos(-radians) + centerY);
-
-                if (srcX >= 0 && srcX < width && srcY >= 0 && srcY < height) {
-                    dst->verts[y * rotatedWidth + x] = src->verts[srcY * width + srcX] ;
-                    dst->verts.attr<float>("alpha")[y * rotatedWidth + x] = src->verts.attr<float>("alpha")[srcY * width + srcX];
-                }
-            }
-        }
-    }
-    else{
-        dst->verts.add_attr<float>("alpha");
-        if(balpha){
-            for(int i = 0;i<dst->size();i++){
-                dst->verts.attr<float>("alpha")[i] = 0;
-            }
-        }
-        else{
-            for(int i = 0;i<dst->size();i++){
-                dst->verts.attr<float>("alpha")[i] = 1;
-            }
-        }
-        for (int y = 0; y < rotatedHeight; ++y) {
-            for (int x = 0; x < rotatedWidth; ++x) {
-                int srcX = static_cast<int>((x - rotatedWidth / 2) * cos(-radians) - (y - rotatedHeight / 2) * sin(-radians) + centerX);
-                int srcY = static_cast<int>((x - rotatedWidth / 2) * sin(-radians) + (y - rotatedHeight / 2) * cos(-radians) + centerY);
-
-                if (srcX >= 0 && srcX < width && srcY >= 0 && srcY < height) {
-                    dst->verts[y * rotatedWidth + x] = src->verts[srcY * width + srcX] ;
-                    dst->verts.attr<float>("alpha")[y * rotatedWidth + x] = 1;
-                }
-            }
-        }
-    }
+    // nearest source pixel of every target pixel, outside ones are left alone by the remap
+    if (width > SHRT_MAX || height > SHRT_MAX)
+        throw zeno::makeError("ImageRotate: image is too large to remap");
+    cv::Mat map(rotatedHeight, rotatedWidth, CV_16SC2);
+    double c = cos(-radians), s = sin(-radians);
     for (int y = 0; y < rotatedHeight; ++y) {
         for (int x = 0; x < rotatedWidth; ++x) {
-            int srcX = static_cast<int>((x - rotatedWidth / 2) * cos(-radians) - (y - rotatedHeight / 2) * sin(-radians) + centerX);
-            int srcY = static_cast<int>((x - rotatedWidth / 2) * sin(-radians) + (y - rotatedHeight / 2) * cos(-radians) + centerY);
-
-            if (srcX >= 0 && srcX < width && srcY >= 0 && srcY < height) {
-                dst->verts[y * rotatedWidth + x] = src->verts[srcY * width + srcX] ;
-            }
+            int srcX = static_cast<int>((x - rotatedWidth / 2) * c - (y - rotatedHeight / 2) * s + centerX);
+            int srcY = static_cast<int>((x - rotatedWidth / 2) * s + (y - rotatedHeight / 2) * c + centerY);
+            bool inside = srcX >= 0 && srcX < width && srcY >= 0 && srcY < height;
+            map.at<cv::Vec2s>(y, x) = inside ? cv::Vec2s(srcX, srcY) : cv::Vec2s(-1, -1);
         }
     }
+    auto remap = [&] (cv::Mat const &from, cv::Mat to) {
+        cv::remap(from, to, map, cv::noArray(), cv::INTER_NEAREST, cv::BORDER_TRANSPARENT);
+    };
+
+    remap(imgcvView(src.get()), imgcvView(dst.get()));
+    dst->verts.add_attr<float>("alpha");
+    cv::Mat alpha = imgcvView(dst.get(), "alpha");
+    alpha.setTo(balpha ? 0 : 1);
+    if (src->verts.has_attr("alpha")) {
+        remap(imgcvView(src.get(), "alpha"), alpha);
+    } else if (balpha) {
+        remap(cv::Mat(height, width, CV_32FC1, cv::Scalar(1)), alpha);
+    }
 }
 struct ImageRotate: INode {//TODO::transform and rorate
     void apply() override {
@@ -358,34 +329,16 @@ struct ImageFlip: INode {
         auto fliphori = get_input2<bool>("Flip Horizontally");
         auto flipvert = get_input2<bool>("Flip Vertically");
         auto image = get_input<PrimitiveObject>("image");
-        auto &ud = image->userData();
-        int w = ud.get2<int>("w");
-        int h = ud.get2<int>("h");
-        if(fliphori&&flipvert){
-            image_flip_horizontal(image->verts.data(), w, h);
-            image_flip_vertical(image->verts.data(), w, h);
+        if (fliphori || flipvert) {
+            // flipped in place, both views share the image size
+            int code = fliphori && flipvert ? -1 : fliphori ? 1 : 0;
+            cv::Mat imagecv = imgcvView(image.get());
+            cv::flip(imagecv, imagecv, code);
             if (image->verts.has_attr("alpha")) {
-                auto alpha = image->verts.attr<float>("alpha");
-                image_flip_horizontal(alpha.data(), w, h);
-                image_flip_vertical(alpha.data(), w, h);
+                cv::Mat alphacv = imgcvView(image.get(), "alpha");
+                cv::flip(alphacv, alphacv, code);
             }
         }
-        else if(fliphori&&!flipvert){
-            image_flip_horizontal(image->verts.data(), w, h);
-            if (image->verts.has_attr("alpha")) {
-                auto alpha = image->verts.attr<float>("alpha");
-                image_flip_horizontal(alpha.data(), w, h);
-            }
-        }
-        else if(!fliphori&&flipvert){
-            image_flip_vertical(image->verts.data(), w, h);
-            if (image->verts.has_attr("alpha")) {
-                auto alpha = image->verts.attr<float>("alpha");
-                image_flip_vertical(alpha.data(), w, h);
-            }
-        }
-        else if(!fliphori&&!flipvert){
-        }
         set_output("image", image);
     }
 };
@@ -660,14 +613,8 @@ struct ImageBlur : INode {
             gaussBlur(image->verts, img_out->verts, w, h, sigmaX, 3);
         }
         else{//CV BLUR
-            cv::Mat imagecvin(h, w, CV_32FC3);
-            cv::Mat imagecvout(h, w, CV_32FC3);
-            for (auto a = 0; a < image->verts.size(); a++){
-                int i = a / w;
-                int j = a % w;
-                vec3f rgb = image->verts[i * w + j];
-                imagecvin.at<cv::Vec3f>(i, j) = {rgb[0], rgb[1], rgb[2]};
-            }
+            cv::Mat imagecvin = imgcvView(image.get());
+            cv::Mat imagecvout = imgcvView(img_out.get());
             if(kernelSize%2==0){
                 kernelSize += 1;
             }
@@ -691,12 +638,6 @@ struct ImageBlur : INode {
             else{
                 zeno::log_error("ImageBlur: Blur type does not exist");
             }
-            for (auto a = 0; a < image->verts.size(); a++){
-                int i = a / w;
-                int j = a % w;
-                cv::Vec3f rgb = imagecvout.at<cv::Vec3f>(i, j);
-                img_out->verts[i * w + j] = {rgb[0], rgb[1], rgb[2]};
-            }
         }
         set_output("image", img_out);
     }
@@ -1029,25 +970,9 @@ struct ImageDilate: INode {
         int strength = get_input2<int>("strength");
         int kheight = get_input2<int>("kernel_height");
         int kwidth = get_input2<int>("kernel_width");
-        auto &ud = image->userData();
-        int w = ud.get2<int>("w");
-        int h = ud.get2<int>("h");
-        cv::Mat imagecvin(h, w, CV_32FC3);
-        cv::Mat imagecvout(h, w, CV_32FC3);
-        for (int i = 0; i < h; i++) {
-            for (int j = 0; j < w; j++) {
-                vec3f rgb = image->verts[i * w + j];
-                imagecvin.at<cv::Vec3f>(i, j) = {rgb[0], rgb[1], rgb[2]};
-            }
-        }
-        const int kernelSize = 3;
-        dilateImage(imagecvin, imagecvout, kheight, kwidth, strength);
-        for (int i = 0; i < h; i++) {
-            for (int j = 0; j < w; j++) {
-                cv::Vec3f rgb = imagecvout.at<cv::Vec3f>(i, j);
-                image->verts[i * w + j] = {rgb[0], rgb[1], rgb[2]};
-            }
-        }
+        // filtered in place, morphology ops support it
+        cv::Mat imagecv = imgcvView(image.get());
+        dilateImage(imagecv, imagecv, kheight, kwidth, strength);
         set_output("image", image);
     }
 };
@@ -1109,27 +1034,12 @@ struct ImageErode: INode {
         int strength = get_input2<int>("strength");
         int kheight = get_input2<int>("kernel_height");
         int kwidth = get_input2<int>("kernel_width");
-        auto &ud = image->userData();
-        int w = ud.get2<int>("w");
-        int h = ud.get2<int>("h");
-        cv::Mat imagecvin(h, w, CV_32FC3);
-        cv::Mat imagecvout(h, w, CV_32FC3);
-        for (int i = 0; i < h; i++) {
-            for (int j = 0; j < w; j++) {
-                vec3f rgb = image->verts[i * w + j];
-                imagecvin.at<cv::Vec3f>(i, j) = {rgb[0], rgb[1], rgb[2]};
-            }
-        }
+        // filtered in place, morphology ops support it
+        cv::Mat imagecv = imgcvView(image.get());
 
         cv::Mat kernel = getStructuringElement(cv::MORPH_RECT, cv::Size(kheight, kwidth));
-        cv::erode(imagecvin, imagecvout, kernel,cv::Point(-1, -1), strength);
+        cv::erode(imagecv, imagecv, kernel,cv::Point(-1, -1), strength);
 
-        for (int i = 0; i < h; i++) {
-            for (int j = 0; j < w; j++) {
-                cv::Vec3f rgb = imagecvout.at<cv::Vec3f>(i, j);
-                image->verts[i * w + j] = {rgb[0], rgb[1], rgb[2]};
-            }
-        }
         set_output("image", image);
     }
 };
@@ -1827,5 +1737,234 @@ ZENDEFNODE(ImageQuantization, {
     {"image"},
 });
 
+// tiled image chain, ops are queued and run fused over tiles when materialized
+static std::shared_ptr<TiledImageObject> tiledWithOp(INode *node, std::shared_ptr<ImageTileOp> op) {
+    auto tiled = std::make_shared<TiledImageObject>(*node->get_input<TiledImageObject>("tiled"));
+    tiled->ops.push_back(std::move(op));
+    return tiled;
+}
+
+struct ImageTiled : INode {
+    virtual void apply() override {
+        auto image = get_input<PrimitiveObject>("image");
+        auto &ud = image->userData();
+        auto tiled = std::make_shared<TiledImageObject>();
+        tiled->w = ud.get2<int>("w");
+        tiled->h = ud.get2<int>("h");
+        if ((size_t)tiled->w * tiled->h != image->verts.size())
+            throw zeno::makeError("ImageTiled: w * h does not match the image size");
+        tiled->source = std::make_shared<std::vector<vec3f> const>(image->verts.values);
+        set_output("tiled", std::move(tiled));
+    }
+};
+
+ZENDEFNODE(ImageTiled, {
+    {
+        {"image"},
+    },
+    {
+        {"tiled"},
+    },
+    {},
+    {"image"},
+});
+
+struct ImageTiledEditHSV : INode {
+    virtual void apply() override {
+        float Hi = get_input2<float>("H");
+        float Si = get_input2<float>("S");
+        float Vi = get_input2<float>("V");
+        auto op = std::make_shared<ImageTileOp>();
+        op->pixelFn = [=] (vec3f *pixels, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                float H = 0, S = 0, V = 0;
+                zeno::RGBtoHSV(pixels[i][0], pixels[i][1], pixels[i][2], H, S, V);
+                H = fmod(H + Hi, 360.0);
+                S = S * Si;
+                V = V * Vi;
+                zeno::HSVtoRGB(H, S, V, pixels[i][0], pixels[i][1], pixels[i][2]);
+            }
+        };
+        set_output("tiled", tiledWithOp(this, std::move(op)));
+    }
+};
+
+ZENDEFNODE(ImageTiledEditHSV, {
+    {
+        {"tiled"},
+        {"float", "H", "0"},
+        {"float", "S", "1"},
+        {"float", "V", "1"},
+    },
+    {
+        {"tiled"},
+    },
+    {},
+    {"image"},
+});
+
+struct ImageTiledEditContrast : INode {
+    virtual void apply() override {
+        float ContrastRatio = get_input2<float>("ContrastRatio");
+        float ContrastCenter = get_input2<float>("ContrastCenter");
+        auto op = std::make_shared<ImageTileOp>();
+        op->pixelFn = [=] (vec3f *pixels, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                pixels[i] = pixels[i] + (pixels[i] - ContrastCenter) * (ContrastRatio - 1);
+            }
+        };
+        set_output("tiled", tiledWithOp(this, std::move(op)));
+    }
+};
+
+ZENDEFNODE(ImageTiledEditContrast, {
+    {
+        {"tiled"},
+        {"float", "ContrastRatio", "1"},
+        {"float", "ContrastCenter", "0.5"},
+    },
+    {
+        {"tiled"},
+    },
+    {},
+    {"image"},
+});
+
+struct ImageTiledEditInvert : INode {
+    virtual void apply() override {
+        auto op = std::make_shared<ImageTileOp>();
+        op->pixelFn = [] (vec3f *pixels, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                pixels[i] = 1 - pixels[i];
+            }
+        };
+        set_output("tiled", tiledWithOp(this, std::move(op)));
+    }
+};
+
+ZENDEFNODE(ImageTiledEditInvert, {
+    {
+        {"tiled"},
+    },
+    {
+        {"tiled"},
+    },
+    {},
+    {"image"},
+});
+
+struct ImageTiledRemap : INode {
+    virtual void apply() override {
+        float inMin = get_input2<float>("inMin");
+        float inMax = get_input2<float>("inMax");
+        float outMin = get_input2<float>("outMin");
+        float outMax = get_input2<float>("outMax");
+        float gamma = get_input2<float>("gamma");
+        bool clamp = get_input2<bool>("clamp");
+        float scale = inMax != inMin ? 1.0f / (inMax - inMin) : 0.0f;
+        float invGamma = gamma > 0 ? 1.0f / gamma : 1.0f;
+        auto op = std::make_shared<ImageTileOp>();
+        op->pixelFn = [=] (vec3f *pixels, size_t n) {
+            for (size_t i = 0; i < n; i++) {
+                for (int c = 0; c < 3; c++) {
+                    float v = (pixels[i][c] - inMin) * scale;
+                    if (clamp) v = std::clamp(v, 0.0f, 1.0f);
+                    if (invGamma != 1.0f) v = std::pow(std::max(v, 0.0f), invGamma);
+                    pixels[i][c] = outMin + v * (outMax - outMin);
+                }
+            }
+        };
+        set_output("tiled", tiledWithOp(this, std::move(op)));
+    }
+};
+
+ZENDEFNODE(ImageTiledRemap, {
+    {
+        {"tiled"},
+        {"float", "inMin", "0"},
+        {"float", "inMax", "1"},
+        {"float", "outMin", "0"},
+        {"float", "outMax", "1"},
+        {"float", "gamma", "1"},
+        {"bool", "clamp", "1"},
+    },
+    {
+        {"tiled"},
+    },
+    {},
+    {"image"},
+});
+
+struct ImageTiledBlur : INode {
+    virtual void apply() override {
+        float sigma = std::max(get_input2<float>("GaussianSigma"), 1e-3f);
+        int r = std::max(1, (int)std::ceil(3 * sigma));
+        std::vector<float> weights(2 * r + 1);
+        float sum = 0;
+        for (int k = -r; k <= r; k++) {
+            weights[k + r] = std::exp(-0.5f * k * k / (sigma * sigma));
+            sum += weights[k + r];
+        }
+        for (auto &wt: weights) wt /= sum;
+
+        // separable gaussian, the halo covers the kernel radius
+        auto op = std::make_shared<ImageTileOp>();
+        op->halo = r;
+        op->tileFn = [weights = std::move(weights), r] (ImageTile const &in, ImageTile &out) {
+            thread_local std::vector<vec3f> tmp;
+            tmp.resize((size_t)out.w * in.h);
+            for (int y = 0; y < in.h; y++) {
+                vec3f const *src = in.pixels.data() + (size_t)y * in.w;
+                vec3f *dst = tmp.data() + (size_t)y * out.w;
+                for (int x = 0; x < out.w; x++) {
+                    vec3f acc(0);
+                    for (int k = 0; k <= 2 * r; k++) acc += src[x + k] * weights[k];
+                    dst[x] = acc;
+                }
+            }
+            for (int y = 0; y < out.h; y++) {
+                vec3f *dst = out.pixels.data() + (size_t)y * out.w;
+                std::fill(dst, dst + out.w, vec3f(0));
+                for (int k = 0; k <= 2 * r; k++) {
+                    vec3f const *src = tmp.data() + (size_t)(y + k) * out.w;
+                    for (int x = 0; x < out.w; x++) dst[x] += src[x] * weights[k];
+                }
+            }
+        };
+        set_output("tiled", tiledWithOp(this, std::move(op)));
+    }
+};
+
+ZENDEFNODE(ImageTiledBlur, {
+    {
+        {"tiled"},
+        {"float", "GaussianSigma", "3"},
+    },
+    {
+        {"tiled"},
+    },
+    {},
+    {"image"},
+});
+
+struct ImageTiledMaterialize : INode {
+    virtual void apply() override {
+        auto tiled = get_input<TiledImageObject>("tiled");
+        set_output("image", tiled->materialize(get_input2<int>("tileSize")));
+    }
+};
+
+ZENDEFNODE(ImageTiledMaterialize, {
+    {
+        {"tiled"},
+        {"int", "tileSize", "256"},
+    },
+    {
+        {"image"},
+    },
+    {},
+    {"image"},
+});
+
 }
 }
\ No newline at end of file
@@ -96,41 +96,22 @@ struct ImageEdgeDetect : INode {
             set_output("image", image);
         }*/
         if (mode == "Sobel") {
-            cv::Mat imagecvin(h, w, CV_32F);
-#pragma omp parallel for
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    vec3f rgb = image->verts[i * w + j];
-                    var = rgb[0] * 0.299 + rgb[1] * 0.587 + rgb[2] *0.114;//TODO:: detect rgb three channel?
-                    imagecvin.at<float>(i, j) = var;
-                }
-            }
+            cv::Mat imagecvin;
+            cv::transform(imgcvView(image.get()), imagecvin, cv::Matx13f(0.299f, 0.587f, 0.114f));
             cv::Mat gradX, gradY;
             //cv::Sobel(imagecvin, gradX, CV_32F, 1, 0, kernelSize,scale,delta,borderType);
             cv::Sobel(imagecvin, gradX, CV_32F, 1, 0, kernelSize);
             cv::Sobel(imagecvin, gradY, CV_32F, 0, 1, kernelSize);
-#pragma omp parallel for
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    float magnitude = abs(gradX.at<float>(i, j)) + abs(gradY.at<float>(i, j));//manhattan distance？ not euclidean distance
-                    image->verts[i * w + j] = {magnitude, magnitude, magnitude};
-                }
-            }
+            cv::Mat magnitude = cv::abs(gradX) + cv::abs(gradY);//manhattan distance？ not euclidean distance
+            imgcvAssign(image.get(), magnitude);
             set_output("image", image);
         }
         else if (mode == "Roberts") {
-            cv::Mat imagecvin(h, w, CV_32F);
+            cv::Mat imagecvin;
             cv::Mat imagecvout(h, w, CV_32F);
             cv::Mat robertsX, robertsY;
             cv::Mat magnitude;
-#pragma omp parallel for
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    vec3f rgb = image->verts[i * w + j];
-                    var = (rgb[0] * 0.299 + rgb[1] * 0.587 + rgb[2] *0.114);
-                    imagecvin.at<float>(i, j) = var;
-                }
-            }
+            cv::transform(imgcvView(image.get()), imagecvin, cv::Matx13f(0.299f, 0.587f, 0.114f));
             cv::Mat kernelX = (cv::Mat_<float>(2, 2) << 1, 0, 0, -1);
             cv::filter2D(imagecvin, robertsX, -1, kernelX);
 
@@ -138,12 +119,7 @@ struct ImageEdgeDetect : INode {
             cv::filter2D(imagecvin, robertsY, -1, kernelY);
 
             cv::magnitude(robertsX, robertsY, imagecvout);
-#pragma omp parallel for
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    image->verts[i * w + j] = vec3f(imagecvout.at<float>(i, j));
-                }
-            }
+            imgcvAssign(image.get(), imagecvout);
             set_output("image", image);
         }
         /*if (mode == "roberts_threshold") {
@@ -173,18 +149,11 @@ struct ImageEdgeDetect : INode {
             set_output("image", image);
         }*/
         else if (mode == "Prewitt") {
-            cv::Mat imagecvin(h, w, CV_32F);
+            cv::Mat imagecvin;
             cv::Mat imagecvout(h, w, CV_32F);
             cv::Mat edges;
             cv::Mat prewittX, prewittY;
-#pragma omp parallel for
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    vec3f rgb = image->verts[i * w + j];
-                    var =  (rgb[0] * 0.299 + rgb[1] * 0.587 + rgb[2] *0.114);
-                    imagecvin.at<float>(i, j) = var;
-                }
-            }
+            cv::transform(imgcvView(image.get()), imagecvin, cv::Matx13f(0.299f, 0.587f, 0.114f));
             cv::Mat kernelX = (cv::Mat_<float>(3, 3) << -1, 0, 1, -1, 0, 1, -1, 0, 1);
             cv::filter2D(imagecvin, prewittX, -1, kernelX);
 
@@ -192,12 +161,7 @@ struct ImageEdgeDetect : INode {
             cv::filter2D(imagecvin, prewittY, -1, kernelY);
 
             cv::magnitude(prewittX, prewittY, imagecvout);
-#pragma omp parallel for
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    image->verts[i * w + j] = vec3f(imagecvout.at<float>(i, j));
-                }
-            }
+            imgcvAssign(image.get(), imagecvout);
             set_output("image", image);
         }
         /*if (mode == "Canny") {//TODO：： Canny opencv only accept 8bit image
@@ -327,28 +291,10 @@ struct ImageStitching : INode {
         auto &ud2 = image2->userData();
         int w2 = ud2.get2<int>("w");
         int h2 = ud2.get2<int>("h");
-        cv::Mat imagecvin1(h1, w1, CV_8UC3);
-        cv::Mat imagecvin2(h2, w2, CV_8UC3);
         cv::Mat descriptors1, descriptors2;
         std::vector<cv::KeyPoint> ikeypoints;
-        for (int i = 0; i < h1; i++) {
-            for (int j = 0; j < w1; j++) {
-                vec3f rgb1 = image1->verts[i * w1 + j];
-                cv::Vec3b& pixel = imagecvin1.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb1[0] * 255;
-                pixel[1] = rgb1[1] * 255;
-                pixel[2] = rgb1[2] * 255;
-            }
-        }
-        for (int i = 0; i < h2; i++) {
-            for (int j = 0; j < w2; j++) {
-                vec3f rgb2 = image2->verts[i * w2 + j];
-                cv::Vec3b& pixel = imagecvin2.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb2[0] * 255;
-                pixel[1] = rgb2[1] * 255;
-                pixel[2] = rgb2[2] * 255;
-            }
-        }
+        cv::Mat imagecvin1 = imgcvToU8(image1.get());
+        cv::Mat imagecvin2 = imgcvToU8(image2.get());
         std::vector<cv::Mat> images;
         images.push_back(imagecvin1);
         images.push_back(imagecvin2);
@@ -356,19 +302,7 @@ struct ImageStitching : INode {
         cv::Mat result;
         cv::Stitcher::Status status = stitcher->stitch(images, result);
         if (status == cv::Stitcher::OK) {
-            int w = result.cols;
-            int h = result.rows;
-            image1->verts.resize(w*h);
-            ud1.set2("w",w);
-            ud1.set2("h",h);
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    cv::Vec3b pixel = result.at<cv::Vec3b>(i, j);
-                    image1->verts[i * w + j][0] = static_cast<float>(pixel[0])/255;
-                    image1->verts[i * w + j][1] = static_cast<float>(pixel[1])/255;
-                    image1->verts[i * w + j][2] = static_cast<float>(pixel[2])/255;
-                }
-            }
+            imgcvAssign(image1.get(), result);
         } else {
             zeno::log_info("stitching failed");
         }
@@ -404,20 +338,11 @@ struct ImageFeatureDetectORB : INode {
         auto &pos = image->verts.attr<vec3f>("pos");
         cv::Ptr<cv::ORB> orb = cv::ORB::create(nFeatures, scaleFactor, 8, edgeThreshold, 0, 2,
                                                cv::ORB::HARRIS_SCORE, 31, patchSize);
-        cv::Mat imagecvin(h, w, CV_8UC3);
         cv::Mat imagecvgray(h, w, CV_8U);
         cv::Mat imagecvout(h, w, CV_8UC3);
         std::vector<cv::KeyPoint> ikeypoints;
 
-        for (int i = 0; i < h; i++) {
-            for (int j = 0; j < w; j++) {
-                vec3f rgb = image->verts[i * w + j];
-                cv::Vec3b& pixel = imagecvin.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb[0] * 255;
-                pixel[1] = rgb[1] * 255;
-                pixel[2] = rgb[2] * 255;
-            }
-        }
+        cv::Mat imagecvin = imgcvToU8(image.get());
         cv::cvtColor(imagecvin, imagecvgray, cv::COLOR_RGB2GRAY);
         cv::Mat idescriptor;
         orb->detectAndCompute(imagecvgray, cv::noArray(), ikeypoints, idescriptor);
@@ -445,14 +370,7 @@ struct ImageFeatureDetectORB : INode {
             cv::drawKeypoints(imagecvin, ikeypoints, imagecvout, cv::Scalar(255, 0, 0),
                               cv::DrawMatchesFlags::DRAW_RICH_KEYPOINTS);
             // | cv::DrawMatchesFlags::DRAW_OVER_OUTIMG
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    cv::Vec3b pixel = imagecvout.at<cv::Vec3b>(i, j);
-                    image->verts[i * w + j][0] = zeno::min(static_cast<float>(pixel[0])/255,1.0f);
-                    image->verts[i * w + j][1] = zeno::min(static_cast<float>(pixel[1])/255,1.0f);
-                    image->verts[i * w + j][2] = zeno::min(static_cast<float>(pixel[2])/255,1.0f);
-                }
-            }
+            imgcvAssign(image.get(), imagecvout);
         }
         set_output("image", image);
     }
@@ -491,20 +409,11 @@ struct ImageFeatureDetectSIFT : INode {
         cv::Ptr<cv::SIFT> sift = cv::SIFT::create(nFeatures, nOctaveLayers,
                                                   contrastThreshold, edgeThreshold,sigma);
 
-        cv::Mat imagecvin(h, w, CV_8UC3);
         cv::Mat imagecvgray(h, w, CV_8U);
         cv::Mat idescriptor;
         cv::Mat imagecvout(h, w, CV_8UC3);
         std::vector<cv::KeyPoint> ikeypoints;
-        for (int i = 0; i < h; i++) {
-            for (int j = 0; j < w; j++) {
-                vec3f rgb = image->verts[i * w + j];
-                cv::Vec3b& pixel = imagecvin.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb[0] * 255;
-                pixel[1] = rgb[1] * 255;
-                pixel[2] = rgb[2] * 255;
-            }
-        }
+        cv::Mat imagecvin = imgcvToU8(image.get());
         cv::cvtColor(imagecvin, imagecvgray, cv::COLOR_RGB2GRAY);
         sift->detectAndCompute(imagecvgray, cv::noArray(), ikeypoints, idescriptor);
         if (ikeypoints.size() == 0) {
@@ -531,14 +440,7 @@ struct ImageFeatureDetectSIFT : INode {
             kp[i] = {x, y};
         }
         if (visualize) {
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w; j++) {
-                    cv::Vec3b pixel = imagecvout.at<cv::Vec3b>(i, j);
-                    image->verts[i * w + j][0] = zeno::min(static_cast<float>(pixel[0])/255,1.0f);
-                    image->verts[i * w + j][1] = zeno::min(static_cast<float>(pixel[1])/255,1.0f);
-                    image->verts[i * w + j][2] = zeno::min(static_cast<float>(pixel[2])/255,1.0f);
-                }
-            }
+            imgcvAssign(image.get(), imagecvout);
         }
         set_output("image", image);
     }
@@ -591,26 +493,8 @@ struct ImageFeatureMatch : INode {
         ud3.set2("isImage", 1);
         image3->verts = image2->verts;
 
-        cv::Mat imagecvin1(h1, w1, CV_8UC3);
-        cv::Mat imagecvin2(h2, w2, CV_8UC3);
-        for (int i = 0; i < h1; i++) {
-            for (int j = 0; j < w1; j++) {
-                vec3f rgb = image1->verts[i * w1 + j];
-                cv::Vec3b& pixel = imagecvin1.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb[0] * 255;
-                pixel[1] = rgb[1] * 255;
-                pixel[2] = rgb[2] * 255;
-            }
-        }
-        for (int i = 0; i < h2; i++) {
-            for (int j = 0; j < w2; j++) {
-                vec3f rgb = image2->verts[i * w2 + j];
-                cv::Vec3b& pixel = imagecvin2.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb[0] * 255;
-                pixel[1] = rgb[1] * 255;
-                pixel[2] = rgb[2] * 255;
-            }
-        }
+        cv::Mat imagecvin1 = imgcvToU8(image1.get());
+        cv::Mat imagecvin2 = imgcvToU8(image2.get());
 
         cv::Ptr<cv::Stitcher> stitcher = cv::Stitcher::create();
         std::vector<cv::Mat> images;
@@ -878,22 +762,8 @@ struct ImageFeatureMatch : INode {
             int h = h1;
             int w = w1+w2;
             cv::Mat V(h,w,CV_8UC3);
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w1; j++) {
-                    vec3f rgb = image1->verts[i * w1 + j];
-                    cv::Vec3b& pixel = V.at<cv::Vec3b>(i, j);
-                    pixel[0] = rgb[0] * 255;
-                    pixel[1] = rgb[1] * 255;
-                    pixel[2] = rgb[2] * 255;
-                }
-                for (int j = w1; j < w; j++) {
-                    vec3f rgb = image2->verts[i * w2 + j - w1];
-                    cv::Vec3b& pixel = V.at<cv::Vec3b>(i, j);
-                    pixel[0] = rgb[0] * 255;
-                    pixel[1] = rgb[1] * 255;
-                    pixel[2] = rgb[2] * 255;
-                }
-            }
+            imgcvView(image1.get()).rowRange(0, h).convertTo(V.colRange(0, w1), CV_8UC3, 255);
+            imgcvView(image2.get()).rowRange(0, h).convertTo(V.colRange(w1, w), CV_8UC3, 255);
             cv::Scalar lineColor(255, 0, 255);
 #pragma omp parallel for
             for (size_t i = 0; i < points1.size(); i++) {
@@ -901,17 +771,7 @@ struct ImageFeatureMatch : INode {
                 cv::Point2f pt2 = points2[i] + cv::Point2f(w1, 0);
                 cv::line(V, pt1, pt2, lineColor, 2);
             }
-            cv::Size vs = V.size();
-            image3->verts.resize(vs.width * vs.height);
-            ud3.set2("w", vs.width);
-            ud3.set2("h", vs.height);
-#pragma omp parallel for
-            for (int i = 0; i < vs.width * vs.height; i++) {
-                cv::Vec3b pixel = V.at<cv::Vec3b>(i);
-                image3->verts[i][0] = zeno::min(static_cast<float>(pixel[0])/255,1.0f);
-                image3->verts[i][1] = zeno::min(static_cast<float>(pixel[1])/255,1.0f);
-                image3->verts[i][2] = zeno::min(static_cast<float>(pixel[2])/255,1.0f);
-            }
+            imgcvAssign(image3.get(), V);
         }
         if(stitch){
             cv::Mat result;
@@ -920,19 +780,7 @@ struct ImageFeatureMatch : INode {
             image3->verts.resize(vs.width * vs.height);
 
             if (status == cv::Stitcher::OK) {
-                int w = result.cols;
-                int h = result.rows;
-                image3->verts.resize(w*h);
-                ud3.set2("w",w);
-                ud3.set2("h",h);
-                for (int i = 0; i < h; i++) {
-                    for (int j = 0; j < w; j++) {
-                        cv::Vec3b pixel = result.at<cv::Vec3b>(i, j);
-                        image3->verts[i * w + j][0] = static_cast<float>(pixel[0])/255;
-                        image3->verts[i * w + j][1] = static_cast<float>(pixel[1])/255;
-                        image3->verts[i * w + j][2] = static_cast<float>(pixel[2])/255;
-                    }
-                }
+                imgcvAssign(image3.get(), result);
             }
             else {
                 zeno::log_info("stitching failed");
@@ -1001,26 +849,8 @@ struct Image3DAnalyze : INode {
 
         image3->verts = image2->verts;
 
-        cv::Mat imagecvin1(h1, w1, CV_8UC3);
-        cv::Mat imagecvin2(h2, w2, CV_8UC3);
-        for (int i = 0; i < h1; i++) {
-            for (int j = 0; j < w1; j++) {
-                vec3f rgb = image1->verts[i * w1 + j];
-                cv::Vec3b& pixel = imagecvin1.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb[0] * 255;
-                pixel[1] = rgb[1] * 255;
-                pixel[2] = rgb[2] * 255;
-            }
-        }
-        for (int i = 0; i < h2; i++) {
-            for (int j = 0; j < w2; j++) {
-                vec3f rgb = image2->verts[i * w2 + j];
-                cv::Vec3b& pixel = imagecvin2.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb[0] * 255;
-                pixel[1] = rgb[1] * 255;
-                pixel[2] = rgb[2] * 255;
-            }
-        }
+        cv::Mat imagecvin1 = imgcvToU8(image1.get());
+        cv::Mat imagecvin2 = imgcvToU8(image2.get());
 
 //cameraMatrix
         float fx = w1;   // image.width;
@@ -1243,22 +1073,8 @@ struct Image3DAnalyze : INode {
             int h = h1;
             int w = w1+w2;
             cv::Mat V(h,w,CV_8UC3);
-            for (int i = 0; i < h; i++) {
-                for (int j = 0; j < w1; j++) {
-                    vec3f rgb = image1->verts[i * w1 + j];
-                    cv::Vec3b& pixel = V.at<cv::Vec3b>(i, j);
-                    pixel[0] = rgb[0] * 255;
-                    pixel[1] = rgb[1] * 255;
-                    pixel[2] = rgb[2] * 255;
-                }
-                for (int j = w1; j < w; j++) {
-                    vec3f rgb = image2->verts[i * w2 + j - w1];
-                    cv::Vec3b& pixel = V.at<cv::Vec3b>(i, j);
-                    pixel[0] = rgb[0] * 255;
-                    pixel[1] = rgb[1] * 255;
-                    pixel[2] = rgb[2] * 255;
-                }
-            }
+            imgcvView(image1.get()).rowRange(0, h).convertTo(V.colRange(0, w1), CV_8UC3, 255);
+            imgcvView(image2.get()).rowRange(0, h).convertTo(V.colRange(w1, w), CV_8UC3, 255);
             cv::Scalar lineColor(0, 255, 255);
 #pragma omp parallel for
             for (size_t i = 0; i < image1Points.size(); i++) {
@@ -1266,17 +1082,7 @@ struct Image3DAnalyze : INode {
                 cv::Point2f pt2 = image2Points[i] + cv::Point2f(w1, 0);
                 cv::line(V, pt1, pt2, lineColor, 2);
             }
-            cv::Size vs = V.size();
-            image3->verts.resize(vs.width * vs.height);
-            ud3.set2("w", vs.width);
-            ud3.set2("h", vs.height);
-#pragma omp parallel for
-            for (int i = 0; i < vs.width * vs.height; i++) {
-                cv::Vec3b pixel = V.at<cv::Vec3b>(i);
-                image3->verts[i][0] = zeno::min(static_cast<float>(pixel[0])/255,1.0f);
-                image3->verts[i][1] = zeno::min(static_cast<float>(pixel[1])/255,1.0f);
-                image3->verts[i][2] = zeno::min(static_cast<float>(pixel[2])/255,1.0f);
-            }
+            imgcvAssign(image3.get(), V);
         }
         set_output("image", image3);
     }
@@ -1347,26 +1153,8 @@ struct EstimateCameraMatrix : INode {
         int w2 = ud2.get2<int>("w");
         int h2 = ud2.get2<int>("h");
 
-        cv::Mat imagecvin1(h1, w1, CV_8UC3);
-        cv::Mat imagecvin2(h2, w2, CV_8UC3);
-        for (int i = 0; i < h1; i++) {
-            for (int j = 0; j < w1; j++) {
-                vec3f rgb1 = image1->verts[i * w1 + j];
-                cv::Vec3b& pixel = imagecvin1.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb1[0] * 255;
-                pixel[1] = rgb1[1] * 255;
-                pixel[2] = rgb1[2] * 255;
-            }
-        }
-        for (int i = 0; i < h2; i++) {
-            for (int j = 0; j < w2; j++) {
-                vec3f rgb2 = image2->verts[i * w2 + j];
-                cv::Vec3b& pixel = imagecvin2.at<cv::Vec3b>(i, j);
-                pixel[0] = rgb2[0] * 255;
-                pixel[1] = rgb2[1] * 255;
-                pixel[2] = rgb2[2] * 255;
-            }
-        }
+        cv::Mat imagecvin1 = imgcvToU8(image1.get());
+        cv::Mat imagecvin2 = imgcvToU8(image2.get());
 
         std::vector<cv::Point2f> image1Points,image2Points;
         std::vector<cv::Point3f> objectPoints;
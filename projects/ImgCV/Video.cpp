@@ -8,6 +8,7 @@
 #include <opencv2/videoio.hpp>
 #include <filesystem>
 #include <opencv2/opencv.hpp>
+#include "imgcv.h"
 
 using namespace cv;
 
@@ -33,11 +34,11 @@ struct ReadImageFromVideo : INode {
         image->userData().set2("w", w);
         image->userData().set2("h", h);
 //        zeno::log_info("w:{},h:{}",w,h);
-        for (int i = 0; i < h; i++) {
-            for (int j = 0; j < w; j++) {
-                cv::Vec3f rgb = frameimage.at<cv::Vec3b>(i, j);
-                image->verts[(h - i - 1) * w + j] = {rgb[2] / 255, rgb[1] / 255, rgb[0] / 255};
-            }
+        if (success) {
+            // bottom-up rgb like the other image readers
+            cv::flip(frameimage, frameimage, 0);
+            cv::cvtColor(frameimage, frameimage, cv::COLOR_BGR2RGB);
+            imgcvAssign(image.get(), frameimage);
         }
         set_output("image", image);
     }
@@ -1,7 +1,11 @@
 #ifndef ZENO_IMGCV_H
 #define ZENO_IMGCV_H
 #include <opencv2/core/utility.hpp>
+#include <opencv2/core.hpp>
 #include "zeno/core/IObject.h"
+#include "zeno/types/PrimitiveObject.h"
+#include "zeno/types/UserData.h"
+#include "zeno/utils/Error.h"
 
 namespace zeno {
     struct CVImageObject : IObjectClone<CVImageObject> {
@@ -23,5 +27,57 @@ namespace zeno {
         }
         std::variant<cv::Mat> m;
     };
+
+    static_assert(sizeof(vec3f) == 3 * sizeof(float), "vec3f must be laid out as CV_32FC3");
+
+    // cv::Mat headers over the pixels of an image primitive, nothing is copied:
+    // filters write straight into the primitive when given a view of the right
+    // size and type, and a view is only valid until the array is resized
+    inline cv::Mat imgcvView(std::vector<vec3f> &pixels, int w, int h) {
+        if (w < 0 || h < 0 || (size_t)w * h != pixels.size())
+            throw makeError("imgcvView: w * h does not match the image size");
+        return cv::Mat(h, w, CV_32FC3, pixels.data());
+    }
+
+    inline cv::Mat imgcvView(std::vector<float> &pixels, int w, int h) {
+        if (w < 0 || h < 0 || (size_t)w * h != pixels.size())
+            throw makeError("imgcvView: w * h does not match the attribute size");
+        return cv::Mat(h, w, CV_32FC1, pixels.data());
+    }
+
+    inline cv::Mat imgcvView(PrimitiveObject *image) {
+        auto &ud = image->userData();
+        return imgcvView(image->verts.values, ud.get2<int>("w"), ud.get2<int>("h"));
+    }
+
+    inline cv::Mat imgcvView(PrimitiveObject *image, std::string const &attr) {
+        auto &ud = image->userData();
+        return imgcvView(image->verts.attr<float>(attr), ud.get2<int>("w"), ud.get2<int>("h"));
+    }
+
+    // 8 bit copy of the image for the OpenCV algorithms that need it
+    inline cv::Mat imgcvToU8(PrimitiveObject *image) {
+        cv::Mat res;
+        imgcvView(image).convertTo(res, CV_8UC3, 255);
+        return res;
+    }
+
+    // resizes the image to src and converts src into it, 8 bit sources are
+    // scaled to [0, 1] and single channel ones are broadcast to rgb
+    inline void imgcvAssign(PrimitiveObject *image, cv::Mat const &src) {
+        image->verts.resize(src.rows * src.cols);
+        image->userData().set2("w", src.cols);
+        image->userData().set2("h", src.rows);
+        cv::Mat dst = imgcvView(image);
+        double scale = src.depth() == CV_8U ? 1.0 / 255 : 1.0;
+        if (src.channels() == 1) {
+            cv::Mat gray;
+            src.convertTo(gray, CV_32F, scale);
+            cv::merge(std::vector<cv::Mat>{gray, gray, gray}, dst);
+        } else {
+            src.convertTo(dst, CV_32FC3, scale);
+        }
+        CV_Assert(dst.data == (uchar *)image->verts.data());
+    }
 }
 #endif //ZENO_IMGCV_H
@@ -0,0 +1,107 @@
+#ifndef ZENO_IMGTILE_H
+#define ZENO_IMGTILE_H
+#include "zeno/core/IObject.h"
+#include "zeno/types/PrimitiveObject.h"
+#include "zeno/types/UserData.h"
+#include "zeno/para/parallel_for.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace zeno {
+    // a rectangle of pixels in image coordinates, may reach outside the image
+    struct ImageTile {
+        int x0 = 0, y0 = 0, w = 0, h = 0;
+        std::vector<vec3f> pixels;
+
+        void reset(int x0_, int y0_, int w_, int h_) {
+            x0 = x0_, y0 = y0_, w = w_, h = h_;
+            pixels.resize((size_t)w * h);
+        }
+
+        vec3f *row(int y) { return pixels.data() + (size_t)(y - y0) * w; }
+        vec3f const *row(int y) const { return pixels.data() + (size_t)(y - y0) * w; }
+
+        // pixels outside of the imgw x imgh image repeat the nearest edge pixel
+        void clampToImage(int imgw, int imgh) {
+            int xb = std::max(x0, 0), xe = std::min(x0 + w, imgw);
+            int yb = std::max(y0, 0), ye = std::min(y0 + h, imgh);
+            if (xb >= xe || yb >= ye) return;
+            for (int y = yb; y < ye; y++) {
+                vec3f *r = row(y);
+                std::fill(r, r + (xb - x0), r[xb - x0]);
+                std::fill(r + (xe - x0), r + w, r[xe - 1 - x0]);
+            }
+            for (int y = y0; y < yb; y++) std::copy(row(yb), row(yb) + w, row(y));
+            for (int y = ye; y < y0 + h; y++) std::copy(row(ye - 1), row(ye - 1) + w, row(y));
+        }
+    };
+
+    // one step of a tiled image chain: either a per-pixel op working in place,
+    // or a neighbourhood op reading halo pixels on each side of its output
+    struct ImageTileOp {
+        int halo = 0;
+        std::function<void(vec3f *pixels, size_t n)> pixelFn;
+        // out is already sized to in shrunk by halo on each side
+        std::function<void(ImageTile const &in, ImageTile &out)> tileFn;
+    };
+
+    // lazily evaluated image: a source image and the ops queued on it, nothing
+    // is computed until materialize() runs the whole chain fused, tile by tile,
+    // so only the source and the result are ever held at full resolution.
+    // the source pixels are a snapshot shared by the whole chain, so editing
+    // the input image afterwards does not change the tiles
+    struct TiledImageObject : IObjectClone<TiledImageObject> {
+        std::shared_ptr<std::vector<vec3f> const> source;
+        int w = 0, h = 0;
+        std::vector<std::shared_ptr<ImageTileOp const>> ops;
+
+        int halo() const {
+            int res = 0;
+            for (auto const &op: ops) res += op->halo;
+            return res;
+        }
+
+        std::shared_ptr<PrimitiveObject> materialize(int tileSize = 256) const {
+            auto img = std::make_shared<PrimitiveObject>();
+            img->verts.resize((size_t)w * h);
+            img->userData().set2("isImage", 1);
+            img->userData().set2("w", w);
+            img->userData().set2("h", h);
+            tileSize = std::max(tileSize, 8);
+            int ntx = (w + tileSize - 1) / tileSize;
+            int nty = (h + tileSize - 1) / tileSize;
+            int totalHalo = halo();
+            auto const &src = *source;
+            parallel_for((size_t)ntx * nty, [&] (size_t t) {
+                thread_local ImageTile a, b;
+                int tx = (t % ntx) * tileSize, ty = (t / ntx) * tileSize;
+                int tw = std::min(tileSize, w - tx), th = std::min(tileSize, h - ty);
+                a.reset(tx - totalHalo, ty - totalHalo, tw + 2 * totalHalo, th + 2 * totalHalo);
+                for (int y = a.y0; y < a.y0 + a.h; y++) {
+                    vec3f const *s = src.data() + (size_t)std::clamp(y, 0, h - 1) * w;
+                    vec3f *r = a.row(y);
+                    for (int x = a.x0; x < a.x0 + a.w; x++)
+                        r[x - a.x0] = s[std::clamp(x, 0, w - 1)];
+                }
+                for (auto const &op: ops) {
+                    if (op->pixelFn) {
+                        op->pixelFn(a.pixels.data(), a.pixels.size());
+                    } else {
+                        b.reset(a.x0 + op->halo, a.y0 + op->halo, a.w - 2 * op->halo, a.h - 2 * op->halo);
+                        op->tileFn(a, b);
+                        b.clampToImage(w, h);
+                        std::swap(a, b);
+                    }
+                }
+                for (int y = ty; y < ty + th; y++) {
+                    vec3f const *r = a.row(y) + (tx - a.x0);
+                    std::copy(r, r + tw, img->verts.data() + (size_t)y * w + tx);
+                }
+            });
+            return img;
+        }
+    };
+}
+#endif //ZENO_IMGTILE_H
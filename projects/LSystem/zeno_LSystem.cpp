@@ -3,7 +3,10 @@
 #include "zeno/types/PrimitiveObject.h"
 
 #include "LSystem/R3Mesh.h"
+#include "LSystem/lplus.h"
 
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -237,50 +240,265 @@ namespace zeno
             },
         });
 
-    struct ProceduralTree : zeno::INode
+    // the state of LSystem/turtle.cpp, without the mesh it draws into
+    struct LSysTurtle
     {
-        virtual void apply() override
-        {
-            auto generator = get_input<zeno::LSysGenerator>("generator");
-            auto code = generator->getCode();
-            auto isPlus = generator->isPlus();
-            R3Mesh mesh;
-            mesh.Tree(code, isPlus);
+        zeno::vec3d position{0, 0, 0};
+        zeno::vec3d direction{0, 1, 0}; // default direction is towards Y, stomach is faced -Z
+        zeno::vec3d right{1, 0, 0};
+        float thickness{1};
+        float reduction{.95};
+    };
 
-            auto prim = std::make_shared<zeno::PrimitiveObject>();
-            auto &pos = prim->add_attr<zeno::vec3f>("pos");
-            auto &uv = prim->add_attr<zeno::vec3f>("uv");
-            auto &nrm = prim->add_attr<zeno::vec3f>("nrm");
+    // a branch cylinder (slices > 0) or a leaf placed by the turtle, and
+    // where its vertices and triangles go in the output primitive
+    struct LSysShape
+    {
+        zeno::vec3d position;
+        zeno::vec3d direction;
+        zeno::vec3d scale;
+        float reduction; // top radius of a cylinder
+        float bend;      // tip z of a leaf
+        int slices;
+        int vertBase;
+        int triBase;
+    };
+
+    // a cylinder is two rings, its sides and two fans, a leaf is one fan
+    static int lsysShapeVerts(const LSysShape &shape) { return shape.slices ? 2 * shape.slices : 8; }
+    static int lsysShapeTris(const LSysShape &shape) { return shape.slices ? 4 * shape.slices - 4 : 6; }
 
-            std::unordered_map<R3MeshVertex *, int> m;
+    // R3Vector::Rotate: counterclockwise around axis (looking at axis end-on)
+    static zeno::vec3d lsysRotate(const zeno::vec3d &v, const zeno::vec3d &axis, double theta)
+    {
+        const double cos_theta = std::cos(theta);
+        return v * cos_theta + axis * (zeno::dot(v, axis) * (1.0 - cos_theta)) - zeno::cross(v, axis) * std::sin(theta);
+    }
 
-            prim->resize(mesh.NVertices());
-            //#pragma omp parallel for
-            for (int i = 0; i < mesh.NVertices(); ++i)
+    static zeno::vec3d lsysNormalize(const zeno::vec3d &v)
+    {
+        double length = zeno::length(v);
+        return length == 0.0 ? v : v / length;
+    }
+
+    // runs the turtle over an expanded L-system string, like LPlusSystem::run
+    // and TurtleSystem, but only records the shapes: nothing is allocated per
+    // vertex, and the vertex and triangle ranges of every shape are known
+    // before any geometry is made
+    static std::vector<LSysShape> lsysInterpret(const std::string &data, float defaultCoefficient,
+                                                float thickness, bool isPlus)
+    {
+        std::vector<LSysShape> shapes;
+        std::vector<LSysTurtle> stack;
+        LSysTurtle turtle;
+        turtle.thickness = thickness;
+        int nverts = 0, ntris = 0;
+
+        auto turnRight = [&](float angle) {
+            angle = angle * M_PI / 180;
+            auto axis = zeno::cross(turtle.direction, turtle.right);
+            turtle.direction = lsysNormalize(lsysRotate(turtle.direction, axis, angle));
+            turtle.right = lsysNormalize(lsysRotate(turtle.right, axis, angle));
+        };
+        auto pitchUp = [&](float angle) {
+            angle = angle * M_PI / 180;
+            turtle.direction = lsysNormalize(lsysRotate(turtle.direction, turtle.right, angle));
+        };
+        auto rollRight = [&](float angle) {
+            angle = angle * M_PI / 180;
+            turtle.right = lsysNormalize(lsysRotate(turtle.right, turtle.direction, angle));
+        };
+        auto move = [&](float distance) {
+            turtle.position += distance * lsysNormalize(turtle.direction);
+        };
+        auto draw = [&](float param) {
+            int slices = turtle.thickness < .2 ? 20
+                       : turtle.thickness < .4 ? 40
+                       : turtle.thickness < .6 ? 60
+                       : turtle.thickness < .8 ? 80 : 100;
+            float radius = param * turtle.thickness;
+            shapes.push_back({turtle.position, turtle.direction, {radius, param, radius},
+                              turtle.reduction, 0, slices, nverts, ntris});
+            nverts += lsysShapeVerts(shapes.back());
+            ntris += lsysShapeTris(shapes.back());
+        };
+        auto drawLeaf = [&](float param) {
+            float z = zeno::dot(turtle.direction, zeno::vec3d(0, 1, 0)) / 4.0; // bend towards earth
+            if (z == 0) z = (rand() % 20 - 10) / 100.0; // some random bend if non
+            shapes.push_back({turtle.position, turtle.direction, {param, param, param},
+                              0, z, 0, nverts, ntris});
+            nverts += lsysShapeVerts(shapes.back());
+            ntris += lsysShapeTris(shapes.back());
+        };
+
+        auto run = [&](const char command, const float param) {
+            float num = param;
+            if (num == 1)
+                num *= defaultCoefficient;
+            switch (command)
             {
-                const auto &v{mesh.Vertex(i)};
+                case '+': turnRight(-num); break;
+                case '-': turnRight(num); break;
+                case '&': pitchUp(-num); break;
+                case '^': pitchUp(num); break;
+                case '<':
+                    if (isPlus) turtle.thickness += turtle.thickness * num / 100;
+                    else rollRight(-num);
+                    break;
+                case '\\': rollRight(-num); break;
+                case '>':
+                    if (isPlus) turtle.thickness -= turtle.thickness * num / 100;
+                    else rollRight(num);
+                    break;
+                case '/': rollRight(num); break;
+                case '%': if (isPlus) turtle.reduction = param / 100; break;
+                case '=': if (isPlus) turtle.thickness = param / 100; break;
+                case '|': turnRight(M_PI); break;
+                case '*': if (isPlus) drawLeaf(param); break;
+                case 'F':
+                case 'f':
+                    draw(param);
+                    move(param);
+                    break;
+                case 'G': if (isPlus) move(param); break;
+                case 'g': move(param); break;
+                case '[': stack.push_back(turtle); break;
+                case ']':
+                    turtle = stack.back();
+                    stack.pop_back();
+                    break;
+                default:;
+            }
+        };
 
-                const auto &p{v->position};
-                pos[i] = zeno::vec3f(p.X(), p.Y(), p.Z());
+        // LSystem::draw: a command, optionally followed by (param)
+        for (size_t i = 0; i < data.size(); ++i)
+        {
+            char command = data[i];
+            float param = 1;
+            if (i + 1 < data.size() && data[i + 1] == '(')
+            {
+                size_t end = data.find(')', i + 2);
+                if (end == std::string::npos)
+                    break;
+                param = atof(data.substr(i + 2, end - i - 2).c_str());
+                i = end;
+            }
+            run(command, param);
+        }
+        return shapes;
+    }
 
-                const auto &t{v->texcoords};
-                uv[i] = zeno::vec3f(t.X(), t.Y(), 0.0);
+    // writes every shape into its own range of the primitive, in parallel;
+    // shapes share no vertices, so each one also gets its vertex normals,
+    // the area weighted average of its face normals as R3MeshVertex::UpdateNormal asks
+    static void lsysEmit(zeno::PrimitiveObject *prim, const std::vector<LSysShape> &shapes)
+    {
+        int nverts = 0, ntris = 0;
+        if (!shapes.empty())
+        {
+            const auto &last = shapes.back();
+            nverts = last.vertBase + lsysShapeVerts(last);
+            ntris = last.triBase + lsysShapeTris(last);
+        }
+        auto &pos = prim->add_attr<zeno::vec3f>("pos");
+        auto &uv = prim->add_attr<zeno::vec3f>("uv");
+        auto &nrm = prim->add_attr<zeno::vec3f>("nrm");
+        prim->resize(nverts);
+        prim->tris.resize(ntris);
 
-                const auto &n{v->normal};
-                nrm[i] = zeno::vec3f(n.X(), n.Y(), n.Z());
+#pragma omp parallel for
+        for (int s = 0; s < (int)shapes.size(); ++s)
+        {
+            const auto &shape = shapes[s];
+            const zeno::vec3d up(0, 1, 0);
+            auto axis = lsysNormalize(zeno::cross(up, shape.direction)); // the axis to rotate on
+            double rotateAngle = 0;
+            if (!(std::fabs(axis[0]) < .001 && std::fabs(axis[1]) < .001 && std::fabs(axis[2]) < .001))
+                rotateAngle = std::acos(zeno::dot(up, shape.direction) / zeno::length(shape.direction));
+            auto place = [&](int i, zeno::vec3d p, float u, float v) {
+                p *= shape.scale;
+                if (std::fabs(rotateAngle) > .001)
+                    p = lsysRotate(p, axis, rotateAngle);
+                p += shape.position;
+                pos[shape.vertBase + i] = zeno::vec3f(p[0], p[1], p[2]);
+                uv[shape.vertBase + i] = zeno::vec3f(u, v, 0);
+                nrm[shape.vertBase + i] = zeno::vec3f(0);
+            };
+            auto tri = [&, t = shape.triBase](int a, int b, int c) mutable {
+                prim->tris[t++] = zeno::vec3i(shape.vertBase + a, shape.vertBase + b, shape.vertBase + c);
+            };
+
+            if (shape.slices)
+            {
+                // R3Mesh::Cylinder: top and bottom rings interleaved, then the
+                // sides, then both caps as triangle fans
+                int slices = shape.slices, size = 2 * slices;
+                for (int i = 0; i < slices; i++)
+                {
+                    float theta = ((float)i) * (2.0 * M_PI / slices);
+                    place(2 * i, {shape.reduction * std::cos(theta), 1, shape.reduction * std::sin(theta)},
+                          i * 2 / (float)slices, 1);
+                    place(2 * i + 1, {std::cos(theta), 0, std::sin(theta)}, i * 2 / (float)slices, 0);
+                }
+                for (int i = 0; i < size; i += 2)
+                {
+                    tri(i, i + 1, (i + 2) % size);
+                    tri(i + 1, (i + 3) % size, (i + 2) % size);
+                }
+                for (int i = 1; i < slices - 1; i++)
+                    tri(0, 2 * i, 2 * i + 2);
+                for (int i = 1; i < slices - 1; i++)
+                    tri(1, 2 * i + 1, 2 * i + 3);
+            }
+            else
+            {
+                // R3Mesh::Leaf
+                float z = shape.bend;
+                place(0, {0, .01, 0}, .5, .01);
+                place(1, {.2, .1, 0}, .7, .1);
+                place(2, {.25, .3, 0}, .75, .3);
+                place(3, {.2, .6, z / 2}, .7, .6);
+                place(4, {0, 1 - z, z}, .5, 1);
+                place(5, {-.2, .6, z / 2}, .3, .6);
+                place(6, {-.25, .3, 0}, .25, .3);
+                place(7, {-.2, .1, 0}, .3, .1);
+                for (int i = 1; i < 7; i++)
+                    tri(0, i, i + 1);
+            }
 
-                m[mesh.Vertex(i)] = i;
+            for (int t = shape.triBase; t < shape.triBase + lsysShapeTris(shape); ++t)
+            {
+                auto f = prim->tris[t];
+                auto n = zeno::cross(pos[f[1]] - pos[f[0]], pos[f[2]] - pos[f[0]]);
+                nrm[f[0]] += n;
+                nrm[f[1]] += n;
+                nrm[f[2]] += n;
             }
-            prim->tris.resize(mesh.NFaces());
-#pragma omp parallel for
-            for (int i = 0; i < mesh.NFaces(); ++i)
+            for (int i = shape.vertBase; i < shape.vertBase + lsysShapeVerts(shape); ++i)
             {
-                const auto &f{mesh.Face(i)};
-                auto t0 = m[f->vertices[0]];
-                auto t1 = m[f->vertices[1]];
-                auto t2 = m[f->vertices[2]];
-                prim->tris[i] = zeno::vec3i(t0, t1, t2);
+                float len = zeno::length(nrm[i]);
+                nrm[i] = len > 0 ? nrm[i] / len : zeno::vec3f(0, 1, 0);
             }
+        }
+    }
+
+    struct ProceduralTree : zeno::INode
+    {
+        virtual void apply() override
+        {
+            auto generator = get_input<zeno::LSysGenerator>("generator");
+            auto code = generator->getCode();
+            auto isPlus = generator->isPlus();
+
+            // LSystem only rewrites the string, the mesh it is given stays empty
+            R3Mesh mesh;
+            LPlusSystem lsystem(&mesh);
+            auto data = lsystem.generateFromCode(code, isPlus);
+            auto shapes = lsysInterpret(data, generator->_defaultCoefficient, generator->_thickness / 100.0f, isPlus);
+
+            auto prim = std::make_shared<zeno::PrimitiveObject>();
+            lsysEmit(prim.get(), shapes);
             set_output("prim", std::move(prim));
         }
     };
@@ -7,9 +7,13 @@
 //#include <opensubdiv/far/stencilTableFactory.h>
 //#include <opensubdiv/osd/cpuEvaluator.h>
 //#include <opensubdiv/osd/cpuVertexBuffer.h>
+#include <algorithm>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <memory>
 #include <opensubdiv/far/primvarRefiner.h>
+#include <opensubdiv/far/stencilTableFactory.h>
 #include <opensubdiv/far/topologyDescriptor.h>
 
 namespace zeno {
@@ -129,9 +133,302 @@ static vec3f v2to3(vec2f const &v) {
 }
 } // namespace
 
+// Instantiate a Far::TopologyRefiner from the descriptor and refine it uniformly up to 'maxlevel'
+static std::unique_ptr<Far::TopologyRefiner> osdCreateRefiner(Far::TopologyDescriptor const &desc, int maxlevel,
+                                                              bool hasLoopUVs) {
+    Sdc::SchemeType refinetfactype = OpenSubdiv::Sdc::SCHEME_CATMARK;
+    Sdc::Options refineofactptions;
+    refineofactptions.SetVtxBoundaryInterpolation(Sdc::Options::VTX_BOUNDARY_EDGE_ONLY);
+    using Factory = Far::TopologyRefinerFactory<Far::TopologyDescriptor>;
+    std::unique_ptr<Far::TopologyRefiner> refiner(
+        Factory::Create(desc, Factory::Options(refinetfactype, refineofactptions)));
+    if (!refiner)
+        throw makeError("refiner is null (factory creation failed)");
+
+    // Uniformly refine the topology up to 'maxlevel'
+    // note: fullTopologyInLastLevel must be true to work with face-varying data
+    {
+        Far::TopologyRefiner::UniformOptions refineOptions(maxlevel);
+        refineOptions.fullTopologyInLastLevel = hasLoopUVs;
+        refiner->RefineUniform(refineOptions);
+    }
+    return refiner;
+}
+
+// Interpolates the vertices, their attributes and the uvs level by level, leaving only the finest level in prim
+static void osdRefinePrimvars(PrimitiveObject *prim, Far::TopologyRefiner const *refiner, int maxlevel,
+                              bool hasLoopUVs) {
+    //// Allocate a buffer for vertex primvar data. The buffer length is set to
+    //// be the sum of all children vertices up to the highest level of refinement.
+    //std::vector<Vertex> vbuffer(refiner->GetNumVerticesTotal());
+    ////int nCoarseVerts = prim->verts.size();
+    ////prim->verts.resize(refiner->GetNumVerticesTotal());
+    ////Vertex * verts = reinterpret_cast<Vertex *>(prim->verts.data());
+    //Vertex * verts = vbuffer.data();
+
+    int nCoarseVerts = prim->verts.size();
+    int nFineVerts = refiner->GetLevel(maxlevel).GetNumVertices();
+    int nTotalVerts = refiner->GetNumVerticesTotal();
+    int nTempVerts = nTotalVerts - nCoarseVerts - nFineVerts;
+    prim->verts.resize(nCoarseVerts + nTempVerts);
+
+    AttrVector<vec2f> fine_uvs;
+    int nCoarseFVars{}, nFineFVars{}, nTotalFVars{}, nTempFVars{};
+    if (hasLoopUVs) {
+        //for (int chi = 0; chi < channels.size(); chi++) {
+        nCoarseFVars = prim->uvs.size(); //channels[0].numValues;
+        nFineFVars = refiner->GetLevel(maxlevel).GetNumFVarValues();
+        nTotalFVars = refiner->GetNumFVarValuesTotal();
+        nTempFVars = nTotalFVars - nCoarseFVars - nFineFVars;
+        prim->uvs.resize(nCoarseFVars + nTempFVars);
+        fine_uvs.resize(nFineFVars);
+        //}
+        //prim->loops.resize
+    }
+
+    //std::vector<Vertex> coarsePosBuffer(nCoarseVerts);
+    //std::vector<Vertex> coarseClrBuffer(nCoarseVerts);
+
+    // Initialize coarse mesh positions
+    //{
+    //auto &posarr = prim->verts.values;
+    //auto &clrarr = prim->verts.add_attr<vec3f>("clr");
+    //for (int i=0; i<nCoarseVerts; ++i) {
+    //coarsePosBuffer[i].SetPoint(posarr[i][0], posarr[i][1], posarr[i][2]);
+    //coarseClrBuffer[i].SetPoint(clrarr[i][0], clrarr[i][1], clrarr[i][2]);
+    //}
+    //}
+    //AttrVector<vec3f> temp_verts(nTempVerts);
+    AttrVector<vec3f> fine_verts(nFineVerts);
+
+    //auto srcPos = reinterpret_cast<Vertex *>(prim->verts.data());
+    //auto dstPos = srcPos + 1;
+    //auto coarseClrBuffer = reinterpret_cast<Vertex const *>(prim->verts.attr<vec3f>("clr").data());
+
+    //std::map<std::string, std::pair<void *, void *>> srcDstAttrs;
+    //prim->verts.foreach_attr([&] (auto const &key, auto &arr) {
+    //using T = std::decay_t<decltype(arr[0])>;
+    //[>auto &temp_arr = <]temp_verts.add_attr<T>(key);
+    ////srcDstAttrs[key] = {
+    ////reinterpret_cast<void *>(arr.data()),
+    ////reinterpret_cast<void *>(temp_arr.data()),
+    ////};
+    //});
+
+    //std::vector<Vertex> tempPosBuffer(nTempVerts);
+    //std::vector<Vertex> finePosBuffer(nFineVerts);
+
+    //std::vector<Vertex> tempClrBuffer(nTempVerts);
+    //std::vector<Vertex> fineClrBuffer(nFineVerts);
+
+    // Interpolate vertex primvar data
+    Far::PrimvarRefiner primvarRefiner(*refiner);
+
+    //Vertex * src = verts;
+    //Vertex * srcPos = &coarsePosBuffer[0];
+    //Vertex * dstPos = &tempPosBuffer[0];
+
+    //Vertex * srcClr = &coarseClrBuffer[0];
+    //Vertex * dstClr = &tempClrBuffer[0];
+
+    size_t srcposoffs = 0;
+    size_t dstposoffs = nCoarseVerts;
+
+    size_t srcfvaroffs{};
+    size_t dstfvaroffs{};
+    if (hasLoopUVs) {
+        dstfvaroffs = nCoarseFVars;
+        //srcfvaroffs.resize(channels.size());
+        //dstfvaroffs.resize(channels.size());
+        //for (int i = 0; i < channels.size(); i++) {
+        //dstfvaroffs[i] += channels[i].numValues;
+        //}
+    }
+
+    for (int level = 1; level < maxlevel; ++level) {
+        //Vertex * dst = src + refiner->GetLevel(level-1).GetNumVertices();
+        //primvarRefiner.Interpolate(level, src, dst);
+        //src = dst;
+        auto *srcPos = convvertexptr(prim->verts.data() + srcposoffs);
+        auto *dstPos = convvertexptr(prim->verts.data() + dstposoffs);
+        primvarRefiner.Interpolate(level, srcPos, dstPos);
+        prim->verts.foreach_attr([&](auto const &key, auto &arr) {
+            auto *srcClr = convvertexptr(arr.data() + srcposoffs);
+            auto *dstClr = convvertexptr(arr.data() + dstposoffs);
+            primvarRefiner.InterpolateVarying(level, srcClr, dstClr);
+        });
+        if (hasLoopUVs) {
+            //for (int chi = 0; chi < channels.size(); chi++) {
+            //prim->loops.attr_visit(chanveckeys[chi], [&] (auto &chva) {
+            auto *srcFVarColor = convvertexptr(prim->uvs.data() + srcfvaroffs);
+            auto *dstFVarColor = convvertexptr(prim->uvs.data() + dstfvaroffs);
+            primvarRefiner.InterpolateFaceVarying(level, srcFVarColor, dstFVarColor);
+            auto numfvars = refiner->GetLevel(level).GetNumFVarValues();
+            srcfvaroffs = dstfvaroffs;
+            dstfvaroffs += numfvars;
+            //});
+            //}
+        }
+        //for (auto const &[key, arr]: srcDstAttrs) {
+        //}
+        auto numverts = refiner->GetLevel(level).GetNumVertices();
+        srcposoffs = dstposoffs;
+        dstposoffs += numverts;
+
+        //srcPos = dstPos, dstPos += numverts;
+        //srcClr = dstClr, dstClr += numverts;
+    }
+
+    // Interpolate the last level into the separate buffers for our final data:
+    //primvarRefiner.Interpolate(       maxlevel, srcPos, finePosBuffer);
+    //primvarRefiner.InterpolateVarying(maxlevel, srcClr, fineClrBuffer);
+    {
+        auto *srcPos = convvertexptr(prim->verts.data() + srcposoffs);
+        auto *dstPos = convvertexptr(fine_verts.data());
+        primvarRefiner.Interpolate(maxlevel, srcPos, dstPos);
+        prim->verts.foreach_attr([&](auto const &key, auto &arr) {
+            using T = std::decay_t<decltype(arr[0])>;
+            auto &fine_arr = fine_verts.add_attr<T>(key);
+            auto *srcClr = convvertexptr(arr.data() + srcposoffs);
+            auto *dstClr = convvertexptr(fine_arr.data());
+            primvarRefiner.InterpolateVarying(maxlevel, srcClr, dstClr);
+        });
+        if (hasLoopUVs) {
+            //primvarRefiner.InterpolateFaceVarying(maxlevel, srcFVarColor, dstFVarColor, channelColor);
+            //for (int chi = 0; chi < channels.size(); chi++) {
+            //prim->loops.attr_visit(chanveckeys[chi], [&] (auto &chva) {
+            auto *srcFVarColor = convvertexptr(prim->uvs.data() + srcfvaroffs);
+            auto *dstFVarColor = convvertexptr(fine_uvs.data());
+            primvarRefiner.InterpolateFaceVarying(maxlevel, srcFVarColor, dstFVarColor);
+            //});
+            //}
+        }
+    }
+
+    std::swap(prim->verts, fine_verts);
+    fine_verts.clear();
+    fine_verts.shrink_to_fit();
+    assert(prim->verts.size() == nFineVerts);
+
+    std::swap(prim->uvs, fine_uvs);
+    fine_uvs.clear();
+    fine_uvs.shrink_to_fit();
+    assert(prim->uvs.size() == nFineFVars);
+}
+
+// Vertex and face-varying indices of the finest level faces, 4 per face
+static void osdFineFaces(Far::TopologyLevel const &level, bool hasLoopUVs, std::vector<int> &faceVerts,
+                         std::vector<int> &faceFVars) {
+    int nfaces = level.GetNumFaces();
+    faceVerts.resize(nfaces * 4);
+    faceFVars.resize(hasLoopUVs ? nfaces * 4 : 0);
+    for (int face = 0; face < nfaces; ++face) {
+        // all refined Catmark faces should be quads
+        Far::ConstIndexArray fverts = level.GetFaceVertices(face);
+        assert(fverts.size() == 4);
+        std::copy(fverts.begin(), fverts.end(), faceVerts.data() + face * 4);
+        if (hasLoopUVs) {
+            Far::ConstIndexArray fvars = level.GetFaceFVarValues(face);
+            assert(fvars.size() == 4);
+            std::copy(fvars.begin(), fvars.end(), faceFVars.data() + face * 4);
+        }
+    }
+}
+
+// FNV-1a of everything in the descriptor that decides the refined topology
+static uint64_t osdTopologyKey(Far::TopologyDescriptor const &desc, int maxlevel, bool hasLoopUVs, size_t numUVs) {
+    uint64_t h = 14695981039346656037ull;
+    auto fnv1a = [&](void const *data, size_t size) {
+        auto p = static_cast<unsigned char const *>(data);
+        for (size_t i = 0; i < size; i++) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    size_t numIndices = 0;
+    for (int i = 0; i < desc.numFaces; i++)
+        numIndices += desc.numVertsPerFace[i];
+    int64_t sizes[] = {desc.numVertices, desc.numFaces, desc.numCreases, maxlevel, hasLoopUVs, (int64_t)numUVs};
+    fnv1a(sizes, sizeof(sizes));
+    fnv1a(desc.numVertsPerFace, desc.numFaces * sizeof(int));
+    fnv1a(desc.vertIndicesPerFace, numIndices * sizeof(int));
+    if (desc.numCreases) {
+        fnv1a(desc.creaseVertexIndexPairs, desc.numCreases * 2 * sizeof(int));
+        fnv1a(desc.creaseWeights, desc.numCreases * sizeof(float));
+    }
+    for (int i = 0; i < desc.numFVarChannels; i++)
+        fnv1a(desc.fvarChannels[i].valueIndices, desc.fvarChannels[i].numValues * sizeof(int));
+    return h;
+}
+
+// dst[i] is the weighted sum of the src elements of stencil i, the stencils
+// are independent so they are evaluated in parallel
+template <class T>
+static void osdApplyStencils(Far::StencilTable const &stencils, T const *src, T *dst) {
+    auto const &sizes = stencils.GetSizes();
+    auto const &offsets = stencils.GetOffsets();
+    auto const &indices = stencils.GetControlIndices();
+    auto const &weights = stencils.GetWeights();
+#pragma omp parallel for
+    for (int i = 0; i < (int)sizes.size(); i++) {
+        T sum(0);
+        for (int j = offsets[i]; j < offsets[i] + sizes[i]; j++)
+            sum += weights[j] * src[indices[j]];
+        dst[i] = sum;
+    }
+}
+
+// Stencils taking the coarse vertices, attributes and uvs of one topology
+// straight to the finest level, plus the refined faces. OSDPrimSubdiv keeps
+// one, so frames where only the points move don't refine the mesh again.
+struct OSDSubdivCache {
+    uint64_t key = 0;
+    std::unique_ptr<Far::StencilTable const> vertexStencils;
+    std::unique_ptr<Far::StencilTable const> varyingStencils;
+    std::unique_ptr<Far::StencilTable const> fvarStencils;
+    std::vector<int> faceVerts;
+    std::vector<int> faceFVars;
+
+    void build(Far::TopologyRefiner const &refiner, int maxlevel, bool hasLoopUVs) {
+        auto create = [&](Far::StencilTableFactory::Mode mode) {
+            Far::StencilTableFactory::Options options;
+            options.interpolationMode = mode;
+            options.generateOffsets = true;
+            options.generateIntermediateLevels = false;
+            options.maxLevel = maxlevel;
+            return std::unique_ptr<Far::StencilTable const>(Far::StencilTableFactory::Create(refiner, options));
+        };
+        vertexStencils = create(Far::StencilTableFactory::INTERPOLATE_VERTEX);
+        varyingStencils = create(Far::StencilTableFactory::INTERPOLATE_VARYING);
+        fvarStencils = hasLoopUVs ? create(Far::StencilTableFactory::INTERPOLATE_FACE_VARYING) : nullptr;
+        osdFineFaces(refiner.GetLevel(maxlevel), hasLoopUVs, faceVerts, faceFVars);
+    }
+
+    // same result as osdRefinePrimvars, in one pass from the coarse level
+    void apply(PrimitiveObject *prim, bool hasLoopUVs) const {
+        AttrVector<vec3f> fine_verts(vertexStencils->GetNumStencils());
+        osdApplyStencils(*vertexStencils, prim->verts.data(), fine_verts.data());
+        prim->verts.foreach_attr([&](auto const &key, auto &arr) {
+            using T = std::decay_t<decltype(arr[0])>;
+            auto &fine_arr = fine_verts.add_attr<T>(key);
+            osdApplyStencils(*varyingStencils, arr.data(), fine_arr.data());
+        });
+        std::swap(prim->verts, fine_verts);
+
+        AttrVector<vec2f> fine_uvs;
+        if (hasLoopUVs) {
+            fine_uvs.resize(fvarStencils->GetNumStencils());
+            osdApplyStencils(*fvarStencils, prim->uvs.data(), fine_uvs.data());
+        }
+        std::swap(prim->uvs, fine_uvs);
+    }
+};
+
+
 //------------------------------------------------------------------------------
 static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCreaseAttr = {}, bool triangulate = false,
-                          bool asQuadFaces = false, bool hasLoopUVs = true, bool copyFaceAttrs = true) {
+                          bool asQuadFaces = false, bool hasLoopUVs = true, bool copyFaceAttrs = true,
+                          OSDSubdivCache *cache = nullptr) {
     const int maxlevel = levels;
     if (maxlevel <= 0 || !prim->verts.size())
         return;
@@ -305,6 +602,9 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
         offsetred += primpolyreduced;
     }
 
+    // the crease pairs and weights point into prim->lines, hash them before it is cleared
+    uint64_t topologyKey = cache ? osdTopologyKey(desc, maxlevel, hasLoopUVs, prim->uvs.size()) : 0;
+
     prim->points.clear();
     prim->lines.clear();
     prim->tris.clear();
@@ -312,208 +612,24 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
     prim->polys.clear();
     prim->loops.clear();
 
-    Sdc::SchemeType refinetfactype = OpenSubdiv::Sdc::SCHEME_CATMARK;
-    Sdc::Options refineofactptions;
-    refineofactptions.SetVtxBoundaryInterpolation(Sdc::Options::VTX_BOUNDARY_EDGE_ONLY);
-    // Instantiate a Far::TopologyRefiner from the descriptor
-    using Factory = Far::TopologyRefinerFactory<Far::TopologyDescriptor>;
-    std::unique_ptr<Far::TopologyRefiner> refiner(
-        Factory::Create(desc, Factory::Options(refinetfactype, refineofactptions)));
-    if (!refiner)
-        throw makeError("refiner is null (factory creation failed)");
-
-    // Uniformly refine the topology up to 'maxlevel'
-    // note: fullTopologyInLastLevel must be true to work with face-varying data
-    {
-        Far::TopologyRefiner::UniformOptions refineOptions(maxlevel);
-        refineOptions.fullTopologyInLastLevel = hasLoopUVs;
-        refiner->RefineUniform(refineOptions);
-    }
-
-    //// Allocate a buffer for vertex primvar data. The buffer length is set to
-    //// be the sum of all children vertices up to the highest level of refinement.
-    //std::vector<Vertex> vbuffer(refiner->GetNumVerticesTotal());
-    ////int nCoarseVerts = prim->verts.size();
-    ////prim->verts.resize(refiner->GetNumVerticesTotal());
-    ////Vertex * verts = reinterpret_cast<Vertex *>(prim->verts.data());
-    //Vertex * verts = vbuffer.data();
-
-    int nCoarseVerts = prim->verts.size();
-    int nFineVerts = refiner->GetLevel(maxlevel).GetNumVertices();
-    int nTotalVerts = refiner->GetNumVerticesTotal();
-    int nTempVerts = nTotalVerts - nCoarseVerts - nFineVerts;
-    prim->verts.resize(nCoarseVerts + nTempVerts);
-
-    AttrVector<vec2f> fine_uvs;
-    int nCoarseFVars{}, nFineFVars{}, nTotalFVars{}, nTempFVars{};
-    if (hasLoopUVs) {
-        //for (int chi = 0; chi < channels.size(); chi++) {
-        nCoarseFVars = prim->uvs.size(); //channels[0].numValues;
-        nFineFVars = refiner->GetLevel(maxlevel).GetNumFVarValues();
-        nTotalFVars = refiner->GetNumFVarValuesTotal();
-        nTempFVars = nTotalFVars - nCoarseFVars - nFineFVars;
-        prim->uvs.resize(nCoarseFVars + nTempFVars);
-        fine_uvs.resize(nFineFVars);
-        //}
-        //prim->loops.resize
-    }
-
-    //std::vector<Vertex> coarsePosBuffer(nCoarseVerts);
-    //std::vector<Vertex> coarseClrBuffer(nCoarseVerts);
-
-    // Initialize coarse mesh positions
-    //{
-    //auto &posarr = prim->verts.values;
-    //auto &clrarr = prim->verts.add_attr<vec3f>("clr");
-    //for (int i=0; i<nCoarseVerts; ++i) {
-    //coarsePosBuffer[i].SetPoint(posarr[i][0], posarr[i][1], posarr[i][2]);
-    //coarseClrBuffer[i].SetPoint(clrarr[i][0], clrarr[i][1], clrarr[i][2]);
-    //}
-    //}
-    //AttrVector<vec3f> temp_verts(nTempVerts);
-    AttrVector<vec3f> fine_verts(nFineVerts);
-
-    //auto srcPos = reinterpret_cast<Vertex *>(prim->verts.data());
-    //auto dstPos = srcPos + 1;
-    //auto coarseClrBuffer = reinterpret_cast<Vertex const *>(prim->verts.attr<vec3f>("clr").data());
-
-    //std::map<std::string, std::pair<void *, void *>> srcDstAttrs;
-    //prim->verts.foreach_attr([&] (auto const &key, auto &arr) {
-    //using T = std::decay_t<decltype(arr[0])>;
-    //[>auto &temp_arr = <]temp_verts.add_attr<T>(key);
-    ////srcDstAttrs[key] = {
-    ////reinterpret_cast<void *>(arr.data()),
-    ////reinterpret_cast<void *>(temp_arr.data()),
-    ////};
-    //});
-
-    //std::vector<Vertex> tempPosBuffer(nTempVerts);
-    //std::vector<Vertex> finePosBuffer(nFineVerts);
-
-    //std::vector<Vertex> tempClrBuffer(nTempVerts);
-    //std::vector<Vertex> fineClrBuffer(nFineVerts);
-
-    // Interpolate vertex primvar data
-    Far::PrimvarRefiner primvarRefiner(*refiner);
-
-    //Vertex * src = verts;
-    //Vertex * srcPos = &coarsePosBuffer[0];
-    //Vertex * dstPos = &tempPosBuffer[0];
-
-    //Vertex * srcClr = &coarseClrBuffer[0];
-    //Vertex * dstClr = &tempClrBuffer[0];
-
-    size_t srcposoffs = 0;
-    size_t dstposoffs = nCoarseVerts;
-
-    size_t srcfvaroffs{};
-    size_t dstfvaroffs{};
-    if (hasLoopUVs) {
-        dstfvaroffs = nCoarseFVars;
-        //srcfvaroffs.resize(channels.size());
-        //dstfvaroffs.resize(channels.size());
-        //for (int i = 0; i < channels.size(); i++) {
-        //dstfvaroffs[i] += channels[i].numValues;
-        //}
-    }
-
-    for (int level = 1; level < maxlevel; ++level) {
-        //Vertex * dst = src + refiner->GetLevel(level-1).GetNumVertices();
-        //primvarRefiner.Interpolate(level, src, dst);
-        //src = dst;
-        auto *srcPos = convvertexptr(prim->verts.data() + srcposoffs);
-        auto *dstPos = convvertexptr(prim->verts.data() + dstposoffs);
-        primvarRefiner.Interpolate(level, srcPos, dstPos);
-        prim->verts.foreach_attr([&](auto const &key, auto &arr) {
-            auto *srcClr = convvertexptr(arr.data() + srcposoffs);
-            auto *dstClr = convvertexptr(arr.data() + dstposoffs);
-            primvarRefiner.InterpolateVarying(level, srcClr, dstClr);
-        });
-        if (hasLoopUVs) {
-            //for (int chi = 0; chi < channels.size(); chi++) {
-            //prim->loops.attr_visit(chanveckeys[chi], [&] (auto &chva) {
-            auto *srcFVarColor = convvertexptr(prim->uvs.data() + srcfvaroffs);
-            auto *dstFVarColor = convvertexptr(prim->uvs.data() + dstfvaroffs);
-            primvarRefiner.InterpolateFaceVarying(level, srcFVarColor, dstFVarColor);
-            auto numfvars = refiner->GetLevel(level).GetNumFVarValues();
-            srcfvaroffs = dstfvaroffs;
-            dstfvaroffs += numfvars;
-            //});
-            //}
-        }
-        //for (auto const &[key, arr]: srcDstAttrs) {
-        //}
-        auto numverts = refiner->GetLevel(level).GetNumVertices();
-        srcposoffs = dstposoffs;
-        dstposoffs += numverts;
-
-        //srcPos = dstPos, dstPos += numverts;
-        //srcClr = dstClr, dstClr += numverts;
-    }
-
-    // Interpolate the last level into the separate buffers for our final data:
-    //primvarRefiner.Interpolate(       maxlevel, srcPos, finePosBuffer);
-    //primvarRefiner.InterpolateVarying(maxlevel, srcClr, fineClrBuffer);
-    {
-        auto *srcPos = convvertexptr(prim->verts.data() + srcposoffs);
-        auto *dstPos = convvertexptr(fine_verts.data());
-        primvarRefiner.Interpolate(maxlevel, srcPos, dstPos);
-        prim->verts.foreach_attr([&](auto const &key, auto &arr) {
-            using T = std::decay_t<decltype(arr[0])>;
-            auto &fine_arr = fine_verts.add_attr<T>(key);
-            auto *srcClr = convvertexptr(arr.data() + srcposoffs);
-            auto *dstClr = convvertexptr(fine_arr.data());
-            primvarRefiner.InterpolateVarying(maxlevel, srcClr, dstClr);
-        });
-        if (hasLoopUVs) {
-            //primvarRefiner.InterpolateFaceVarying(maxlevel, srcFVarColor, dstFVarColor, channelColor);
-            //for (int chi = 0; chi < channels.size(); chi++) {
-            //prim->loops.attr_visit(chanveckeys[chi], [&] (auto &chva) {
-            auto *srcFVarColor = convvertexptr(prim->uvs.data() + srcfvaroffs);
-            auto *dstFVarColor = convvertexptr(fine_uvs.data());
-            primvarRefiner.InterpolateFaceVarying(maxlevel, srcFVarColor, dstFVarColor);
-            //});
-            //}
+    std::vector<int> localFaceVerts, localFaceFVars;
+    if (cache) {
+        if (!cache->vertexStencils || cache->key != topologyKey) {
+            cache->build(*osdCreateRefiner(desc, maxlevel, hasLoopUVs), maxlevel, hasLoopUVs);
+            cache->key = topologyKey;
         }
+        cache->apply(prim, hasLoopUVs);
+    } else {
+        auto refiner = osdCreateRefiner(desc, maxlevel, hasLoopUVs);
+        osdRefinePrimvars(prim, refiner.get(), maxlevel, hasLoopUVs);
+        osdFineFaces(refiner->GetLevel(maxlevel), hasLoopUVs, localFaceVerts, localFaceFVars);
     }
+    std::vector<int> const &faceVerts = cache ? cache->faceVerts : localFaceVerts;
+    std::vector<int> const &faceFVars = cache ? cache->faceFVars : localFaceFVars;
 
     { // Output OBJ of the highest level refined -----------
 
-        Far::TopologyLevel const &refLastLevel = refiner->GetLevel(maxlevel);
-
-        int nverts = refLastLevel.GetNumVertices();
-        int nfaces = refLastLevel.GetNumFaces();
-
-        //std::vector<int> nfvverts;
-        int nfvars{};
-        if (hasLoopUVs) {
-            //nfvverts.resize(channels.size());
-            //for (int i = 0; i < channels.size(); i++) {
-            //nfvverts[i] = refLastLevel.GetNumFVarValues(i);
-            //}
-            nfvars = refLastLevel.GetNumFVarValues();
-        }
-
-        // Print vertex positions
-        //int firstOfLastVerts = refiner->GetNumVerticesTotal() - nverts;
-        //assert(firstOfLastVerts == nCoarseVerts);
-        //prim->verts->erase(prim->verts.begin(), prim->verts.begin() + firstOfLastVerts);
-
-        std::swap(prim->verts, fine_verts);
-        fine_verts.clear();
-        fine_verts.shrink_to_fit();
-        assert(prim->verts.size() == nverts);
-        //prim->verts.resize(nverts);
-        //for (int vert = 0; vert < nverts; ++vert) {
-        //float const * pos = finePosBuffer[vert].GetPoint();
-        ////printf("v %f %f %f\n", pos[0], pos[1], pos[2]);
-        //prim->verts[vert] = {pos[0], pos[1], pos[2]};
-        //}
-
-        std::swap(prim->uvs, fine_uvs);
-        fine_uvs.clear();
-        fine_uvs.shrink_to_fit();
-        assert(prim->uvs.size() == nfvars);
+        int nfaces = faceVerts.size() / 4;
 
         //{
         //auto &clrarr = prim->verts.add_attr<vec3f>("clr");
@@ -532,10 +648,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
             prim->tris.resize(nfaces * 2);
             for (int face = 0; face < nfaces; ++face) {
 
-                Far::ConstIndexArray fverts = refLastLevel.GetFaceVertices(face);
-
-                // all refined Catmark faces should be quads
-                assert(fverts.size() == 4);
+                int const *fverts = faceVerts.data() + face * 4;
 
                 auto &reftri1 = prim->tris[face * 2];
                 auto &reftri2 = prim->tris[face * 2 + 1];
@@ -558,8 +671,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
                 auto &uv1 = prim->tris.add_attr<vec3f>("uv1");
                 auto &uv2 = prim->tris.add_attr<vec3f>("uv2");
                 for (int face = 0; face < nfaces; ++face) {
-                    Far::ConstIndexArray fvars = refLastLevel.GetFaceFVarValues(face);
-                    assert(fvars.size() == 4);
+                    int const *fvars = faceFVars.data() + face * 4;
                     uv0[face * 2] = v2to3(prim->uvs[fvars[0]]);
                     uv1[face * 2] = v2to3(prim->uvs[fvars[1]]);
                     uv2[face * 2] = v2to3(prim->uvs[fvars[2]]);
@@ -593,10 +705,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
             prim->quads.resize(nfaces);
             for (int face = 0; face < nfaces; ++face) {
 
-                Far::ConstIndexArray fverts = refLastLevel.GetFaceVertices(face);
-
-                // all refined Catmark faces should be quads
-                assert(fverts.size() == 4);
+                int const *fverts = faceVerts.data() + face * 4;
 
                 auto &refquad = prim->quads[face];
                 refquad[0] = fverts[0];
@@ -617,8 +726,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
                 auto &uv2 = prim->quads.add_attr<vec3f>("uv2");
                 auto &uv3 = prim->quads.add_attr<vec3f>("uv3");
                 for (int face = 0; face < nfaces; ++face) {
-                    Far::ConstIndexArray fvars = refLastLevel.GetFaceFVarValues(face);
-                    assert(fvars.size() == 4);
+                    int const *fvars = faceFVars.data() + face * 4;
                     uv0[face] = v2to3(prim->uvs[fvars[0]]);
                     uv1[face] = v2to3(prim->uvs[fvars[1]]);
                     uv2[face] = v2to3(prim->uvs[fvars[2]]);
@@ -662,10 +770,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
 
             for (int face = 0; face < nfaces; ++face) {
 
-                Far::ConstIndexArray fverts = refLastLevel.GetFaceVertices(face);
-
-                // all refined Catmark faces should be quads
-                assert(fverts.size() == 4);
+                int const *fverts = faceVerts.data() + face * 4;
 
                 prim->loops[face * 4 + 0] = fverts[0];
                 prim->loops[face * 4 + 1] = fverts[1];
@@ -679,8 +784,7 @@ static void osdPrimSubdiv(PrimitiveObject *prim, int levels, std::string edgeCre
                 loop_uvs.resize(nfaces * 4);
 
                 for (int face = 0; face < nfaces; ++face) {
-                    Far::ConstIndexArray fvars = refLastLevel.GetFaceFVarValues(face);
-                    assert(fvars.size() == 4);
+                    int const *fvars = faceFVars.data() + face * 4;
                     loop_uvs[face * 4 + 0] = fvars[0];
                     loop_uvs[face * 4 + 1] = fvars[1];
                     loop_uvs[face * 4 + 2] = fvars[2];
@@ -724,10 +828,18 @@ struct OSDPrimSubdiv : INode {
         bool asQuadFaces = get_input2<bool>("asQuadFaces");
         bool hasLoopUVs = get_input2<bool>("hasLoopUVs");
         bool copyFaceAttrs = get_input2<bool>("copyFaceAttrs");
+        if (!get_input2<bool>("cacheTopology"))
+            cache.reset();
+        else if (!cache)
+            cache = std::make_unique<OSDSubdivCache>();
         if (levels)
-            osdPrimSubdiv(prim.get(), levels, edgeCreaseAttr, triangulate, asQuadFaces, hasLoopUVs, copyFaceAttrs);
+            osdPrimSubdiv(prim.get(), levels, edgeCreaseAttr, triangulate, asQuadFaces, hasLoopUVs, copyFaceAttrs,
+                          cache.get());
         set_output("prim", std::move(prim));
     }
+
+    // refined topology of the last input, reused while only its points move
+    std::unique_ptr<OSDSubdivCache> cache;
 };
 ZENO_DEFNODE(OSDPrimSubdiv)
 ({
@@ -740,6 +852,7 @@ ZENO_DEFNODE(OSDPrimSubdiv)
         {"bool", "hasLoopUVs", "1"},
         {"bool", "copyFaceAttrs", "1"},
         {"bool", "delayTillIpc", "0"},
+        {"bool", "cacheTopology", "1"},
     },
     {
         "prim",
@@ -1,5 +1,14 @@
+#include <atomic>
+#include <filesystem>
 #include <memory>
+#include <random>
+#include <thread>
 #include <vector>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 // zeno basics
 #include <zeno/ListObject.h>
@@ -10,6 +19,7 @@
 #include <zeno/utils/UserData.h>
 #include <zeno/zeno.h>
 #include <zeno/utils/fileio.h>
+#include <zeno/para/parallel_for.h>
 
 #include "RigidTest.h"
 
@@ -181,6 +191,206 @@ struct VHACDParameters
     VHACDParameters(void)
     {
         m_run = true;
+        // TODO: get more parameters from INode, currently it is only for testing.
+        m_paramsVHACD.m_resolution = 100000; // Maximum number of voxels generated during the voxelization stage (default=100,000, range=10,000-16,000,000)
+        m_paramsVHACD.m_depth = 20; // Maximum number of clipping stages. During each split stage, parts with a concavity higher than the user defined threshold are clipped according the "best" clipping plane (default=20, range=1-32)
+        m_paramsVHACD.m_concavity = 0.001; // Maximum allowed concavity (default=0.0025, range=0.0-1.0)
+        m_paramsVHACD.m_planeDownsampling = 4; // Controls the granularity of the search for the "best" clipping plane (default=4, range=1-16)
+        m_paramsVHACD.m_convexhullDownsampling  = 4; // Controls the precision of the convex-hull generation process during the clipping plane selection stage (default=4, range=1-16)
+        m_paramsVHACD.m_alpha = 0.05; // Controls the bias toward clipping along symmetry planes (default=0.05, range=0.0-1.0)
+        m_paramsVHACD.m_beta = 0.05; // Controls the bias toward clipping along revolution axes (default=0.05, range=0.0-1.0)
+        m_paramsVHACD.m_gamma = 0.0005; // Controls the maximum allowed concavity during the merge stage (default=0.00125, range=0.0-1.0)
+        m_paramsVHACD.m_pca = 0; // Enable/disable normalizing the mesh before applying the convex decomposition (default=0, range={0,1})
+        m_paramsVHACD.m_mode = 0; // 0: voxel-based approximate convex decomposition, 1: tetrahedron-based approximate convex decomposition (default=0, range={0,1})
+        m_paramsVHACD.m_maxNumVerticesPerCH = 64; // Controls the maximum number of triangles per convex-hull (default=64, range=4-1024)
+        m_paramsVHACD.m_minVolumePerCH = 0.0001; // Controls the adaptive sampling of the generated convex-hulls (default=0.0001, range=0.0-0.01)
+        m_paramsVHACD.m_convexhullApproximation = true; // Enable/disable approximation when computing convex-hulls (default=1, range={0,1})
+        // OpenCL is not available on headless machines, and several decompositions
+        // running at once on the cpu pool scale better than one on the gpu
+        m_paramsVHACD.m_oclAcceleration = false; // Enable/disable OpenCL acceleration (default=0, range={0,1})
+    }
+};
+
+static std::vector<std::shared_ptr<zeno::PrimitiveObject>> vhacdDecompose(
+    zeno::PrimitiveObject const &prim, VHACD::IVHACD::Parameters const &params) {
+    auto const &pos = prim.verts.values;
+    std::vector<std::shared_ptr<zeno::PrimitiveObject>> hulls;
+    if (pos.empty() || prim.tris.size() == 0)
+        return hulls;
+
+    std::vector<float> points;
+    std::vector<int> triangles;
+    points.reserve(pos.size() * 3);
+    triangles.reserve(prim.tris.size() * 3);
+
+    for (size_t i = 0; i < pos.size(); i++){
+        points.push_back(pos[i][0]);
+        points.push_back(pos[i][1]);
+        points.push_back(pos[i][2]);
+    }
+
+    for (size_t i = 0; i < prim.tris.size(); i++){
+        triangles.push_back(prim.tris[i][0]);
+        triangles.push_back(prim.tris[i][1]);
+        triangles.push_back(prim.tris[i][2]);
+    }
+
+    VHACD::IVHACD* interfaceVHACD = VHACD::CreateVHACD();
+    bool res = interfaceVHACD->Compute(&points[0], 3, (unsigned int)points.size() / 3,
+                                       &triangles[0], 3, (unsigned int)triangles.size() / 3, params);
+
+    unsigned int nConvexHulls = interfaceVHACD->GetNConvexHulls();
+    //std::cout<< "Generate output:" << nConvexHulls << " convex-hulls" << std::endl;
+    printf("Generate output: %d convex-hulls \n", nConvexHulls);
+
+    bool good_ch_flag = true;
+    VHACD::IVHACD::ConvexHull ch;
+    for (size_t c = 0; c < nConvexHulls; c++) {
+        interfaceVHACD->GetConvexHull(c, ch);
+        size_t nPoints = ch.m_nPoints;
+        size_t nTriangles = ch.m_nTriangles;
+
+        auto outprim = std::make_shared<zeno::PrimitiveObject>();
+        outprim->resize(nPoints);
+        outprim->tris.resize(nTriangles);
+
+        auto &outpos = outprim->add_attr<zeno::vec3f>("pos");
+
+        if (nPoints > 0) {
+            for (size_t i = 0; i < nPoints; i ++) {
+                size_t ind = i * 3;
+                outpos[i] = zeno::vec3f(ch.m_points[ind], ch.m_points[ind + 1], ch.m_points[ind + 2]);
+            }
+        }
+        else{
+            good_ch_flag = false;
+        }
+        if (nTriangles > 0)
+        {
+            for (size_t i = 0; i < nTriangles; i++) {
+                size_t ind = i * 3;
+                outprim->tris[i] = zeno::vec3i(ch.m_triangles[ind], ch.m_triangles[ind + 1],ch.m_triangles[ind + 2]);
+            }
+        }
+        else{
+            good_ch_flag = false;
+        }
+
+        if(good_ch_flag) {
+            hulls.push_back(std::move(outprim));
+        }
+    }
+
+    interfaceVHACD->Clean();
+    interfaceVHACD->Release();
+    return hulls;
+}
+
+/*
+ *  On-disk cache of convex decompositions, keyed by a hash of the input
+ *  mesh and the VHACD parameters. One file per mesh: <hash>.hulls
+ */
+struct ConvexHullCache {
+    static constexpr uint32_t kMagic = 0x4c4c5548; // "HULL"
+
+    static uint64_t fnv1a(uint64_t h, void const *data, size_t size) {
+        auto p = static_cast<unsigned char const *>(data);
+        for (size_t i = 0; i < size; i++) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    static std::string key(zeno::PrimitiveObject const &prim, VHACD::IVHACD::Parameters const &params) {
+        uint64_t h = 14695981039346656037ull;
+        h = fnv1a(h, prim.verts.values.data(), prim.verts.size() * sizeof(zeno::vec3f));
+        h = fnv1a(h, prim.tris.values.data(), prim.tris.size() * sizeof(zeno::vec3i));
+        // only the parameters that change the result, the callbacks are pointers
+        double fparams[] = {params.m_concavity, params.m_alpha, params.m_beta, params.m_gamma,
+                            params.m_minVolumePerCH};
+        int iparams[] = {(int)params.m_resolution, (int)params.m_depth, (int)params.m_planeDownsampling,
+                         (int)params.m_convexhullDownsampling, (int)params.m_pca, (int)params.m_mode,
+                         (int)params.m_maxNumVerticesPerCH, (int)params.m_convexhullApproximation};
+        h = fnv1a(h, fparams, sizeof(fparams));
+        h = fnv1a(h, iparams, sizeof(iparams));
+        char buf[17];
+        snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+        return buf;
+    }
+
+    static bool load(std::string const &path, std::vector<std::shared_ptr<zeno::PrimitiveObject>> &hulls) {
+        FILE *fp = fopen(path.c_str(), "rb");
+        if (!fp)
+            return false;
+        bool ok = true;
+        uint32_t header[2];
+        ok = fread(header, sizeof(header), 1, fp) == 1 && header[0] == kMagic;
+        for (uint32_t c = 0; ok && c < header[1]; c++) {
+            uint32_t sizes[2];
+            ok = fread(sizes, sizeof(sizes), 1, fp) == 1;
+            if (!ok)
+                break;
+            auto outprim = std::make_shared<zeno::PrimitiveObject>();
+            outprim->resize(sizes[0]);
+            outprim->tris.resize(sizes[1]);
+            ok = fread(outprim->verts.values.data(), sizeof(zeno::vec3f), sizes[0], fp) == sizes[0] &&
+                 fread(outprim->tris.values.data(), sizeof(zeno::vec3i), sizes[1], fp) == sizes[1];
+            hulls.push_back(std::move(outprim));
+        }
+        fclose(fp);
+        if (!ok)
+            hulls.clear();
+        return ok;
+    }
+
+    static void save(std::string const &path, std::vector<std::shared_ptr<zeno::PrimitiveObject>> const &hulls) {
+        // write aside and rename, so a concurrent reader never sees half a file
+        // the name must be unique across threads and zeno processes sharing the cache
+        static std::atomic<uint32_t> counter{std::random_device{}()};
+#ifdef _WIN32
+        auto pid = _getpid();
+#else
+        auto pid = getpid();
+#endif
+        auto tmpPath = path + ".tmp" + std::to_string(pid) + "-" +
+                       std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + "-" +
+                       std::to_string(counter.fetch_add(1));
+        FILE *fp = fopen(tmpPath.c_str(), "wb");
+        if (!fp) {
+            zeno::log_warn("cannot write convex hull cache {}", path);
+            return;
+        }
+        uint32_t header[2] = {kMagic, (uint32_t)hulls.size()};
+        bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+        for (auto const &hull : hulls) {
+            uint32_t sizes[2] = {(uint32_t)hull->verts.size(), (uint32_t)hull->tris.size()};
+            ok = ok && fwrite(sizes, sizeof(sizes), 1, fp) == 1 &&
+                 fwrite(hull->verts.values.data(), sizeof(zeno::vec3f), sizes[0], fp) == sizes[0] &&
+                 fwrite(hull->tris.values.data(), sizeof(zeno::vec3i), sizes[1], fp) == sizes[1];
+        }
+        fclose(fp);
+        std::error_code ec;
+        if (ok)
+            std::filesystem::rename(tmpPath, path, ec);
+        if (!ok || ec) {
+            zeno::log_warn("cannot write convex hull cache {}", path);
+            std::filesystem::remove(tmpPath, ec);
+        }
+    }
+
+    // decompose, or load the hulls computed by a previous run for the same input
+    static std::vector<std::shared_ptr<zeno::PrimitiveObject>> decompose(
+        zeno::PrimitiveObject const &prim, VHACD::IVHACD::Parameters const &params, std::string const &cacheDir) {
+        if (cacheDir.empty())
+            return vhacdDecompose(prim, params);
+        auto path = (std::filesystem::path(cacheDir) / (key(prim, params) + ".hulls")).string();
+        std::vector<std::shared_ptr<zeno::PrimitiveObject>> hulls;
+        if (load(path, hulls))
+            return hulls;
+        hulls = vhacdDecompose(prim, params);
+        save(path, hulls);
+        return hulls;
     }
 };
 
@@ -192,107 +402,55 @@ struct PrimitiveConvexDecompositionV : zeno::INode {
     // 该算法优先处理形状的内部，而不是边缘，从而在保留形状主要特性的同时，还能控制结果凸体的数量。这是一种生成高质量凸体集的有效方法。
     virtual void apply() override {
         auto prim = get_input<zeno::PrimitiveObject>("prim");
-        auto &pos = prim->attr<zeno::vec3f>("pos");
-
-        //auto resolution = get_input2<int>("resolution");
-
-
-        std::vector<float> points;
-        std::vector<int> triangles;
-
-        for (size_t i = 0; i < pos.size(); i++){
-            points.push_back(pos[i][0]);
-            points.push_back(pos[i][1]);
-            points.push_back(pos[i][2]);
-        }
-
-        for (size_t i = 0; i < prim->tris.size(); i++){
-            triangles.push_back(prim->tris[i][0]);
-            triangles.push_back(prim->tris[i][1]);
-            triangles.push_back(prim->tris[i][2]);
-        }
+        auto cacheDir = get_input2<std::string>("cacheDir");
+        if (!cacheDir.empty())
+            std::filesystem::create_directories(cacheDir);
 
         VHACDParameters params;
-        // TODO: get more parameters from INode, currently it is only for testing.
-        params.m_paramsVHACD.m_resolution = 100000; // Maximum number of voxels generated during the voxelization stage (default=100,000, range=10,000-16,000,000)
-        params.m_paramsVHACD.m_depth = 20; // Maximum number of clipping stages. During each split stage, parts with a concavity higher than the user defined threshold are clipped according the "best" clipping plane (default=20, range=1-32)
-        params.m_paramsVHACD.m_concavity = 0.001; // Maximum allowed concavity (default=0.0025, range=0.0-1.0)
-        params.m_paramsVHACD.m_planeDownsampling = 4; // Controls the granularity of the search for the "best" clipping plane (default=4, range=1-16)
-        params.m_paramsVHACD.m_convexhullDownsampling  = 4; // Controls the precision of the convex-hull generation process during the clipping plane selection stage (default=4, range=1-16)
-        params.m_paramsVHACD.m_alpha = 0.05; // Controls the bias toward clipping along symmetry planes (default=0.05, range=0.0-1.0)
-        params.m_paramsVHACD.m_beta = 0.05; // Controls the bias toward clipping along revolution axes (default=0.05, range=0.0-1.0)
-        params.m_paramsVHACD.m_gamma = 0.0005; // Controls the maximum allowed concavity during the merge stage (default=0.00125, range=0.0-1.0)
-        params.m_paramsVHACD.m_pca = 0; // Enable/disable normalizing the mesh before applying the convex decomposition (default=0, range={0,1})
-        params.m_paramsVHACD.m_mode = 0; // 0: voxel-based approximate convex decomposition, 1: tetrahedron-based approximate convex decomposition (default=0, range={0,1})
-        params.m_paramsVHACD.m_maxNumVerticesPerCH = 64; // Controls the maximum number of triangles per convex-hull (default=64, range=4-1024)
-        params.m_paramsVHACD.m_minVolumePerCH = 0.0001; // Controls the adaptive sampling of the generated convex-hulls (default=0.0001, range=0.0-0.01)
-        params.m_paramsVHACD.m_convexhullApproximation = true; // Enable/disable approximation when computing convex-hulls (default=1, range={0,1})
-        params.m_paramsVHACD.m_oclAcceleration = true; // Enable/disable OpenCL acceleration (default=0, range={0,1})
-
-
-        VHACD::IVHACD* interfaceVHACD = VHACD::CreateVHACD();
-        bool res = interfaceVHACD->Compute(&points[0], 3, (unsigned int)points.size() / 3,
-                                           &triangles[0], 3, (unsigned int)triangles.size() / 3, params.m_paramsVHACD);
-
-
-        // save output
         auto listPrim = std::make_shared<zeno::ListObject>();
-        listPrim->arr.clear();
-
-
-        unsigned int nConvexHulls = interfaceVHACD->GetNConvexHulls();
-        //std::cout<< "Generate output:" << nConvexHulls << " convex-hulls" << std::endl;
-        printf("Generate output: %d convex-hulls \n", nConvexHulls);
+        for (auto &hull : ConvexHullCache::decompose(*prim, params.m_paramsVHACD, cacheDir))
+            listPrim->arr.push_back(std::move(hull));
 
-        bool good_ch_flag = true;
-        VHACD::IVHACD::ConvexHull ch;
-        size_t vertexOffset = 0; // triangle index start from 1
-        for (size_t c = 0; c < nConvexHulls; c++) {
-            interfaceVHACD->GetConvexHull(c, ch);
-            size_t nPoints = ch.m_nPoints;
-            size_t nTriangles = ch.m_nTriangles;
+        set_output("listPrim", std::move(listPrim));
+    }
+};
 
-            auto outprim = std::make_shared<zeno::PrimitiveObject>();
-            outprim->resize(nPoints);
-            outprim->tris.resize(nTriangles);
+ZENDEFNODE(PrimitiveConvexDecompositionV, {
+    {"prim", {"readpath", "cacheDir", ""}},
+    {"listPrim"},
+    {},
+    {"Bullet"},
+});
 
-            auto &outpos = outprim->add_attr<zeno::vec3f>("pos");
+// decompose many pieces (e.g. fracture chunks) at once on the thread pool,
+// outputs one list of hulls per input primitive
+struct PrimitiveConvexDecompositionVBatch : zeno::INode {
+    virtual void apply() override {
+        auto prims = get_input<zeno::ListObject>("primList")->get<zeno::PrimitiveObject>();
+        auto cacheDir = get_input2<std::string>("cacheDir");
+        if (!cacheDir.empty())
+            std::filesystem::create_directories(cacheDir);
 
-            if (nPoints > 0) {
-                for (size_t i = 0; i < nPoints; i ++) {
-                    size_t ind = i * 3;
-                    outpos[i] = zeno::vec3f(ch.m_points[ind], ch.m_points[ind + 1], ch.m_points[ind + 2]);
-                }
-            }
-            else{
-                good_ch_flag = false;
-            }
-            if (nTriangles > 0)
-            {
-                for (size_t i = 0; i < nTriangles; i++) {
-                    size_t ind = i * 3;
-                    outprim->tris[i] = zeno::vec3i(ch.m_triangles[ind], ch.m_triangles[ind + 1],ch.m_triangles[ind + 2]);
-                }
-            }
-            else{
-                good_ch_flag = false;
-            }
+        VHACDParameters params;
+        std::vector<std::vector<std::shared_ptr<zeno::PrimitiveObject>>> results(prims.size());
+        zeno::parallel_for(prims.size(), [&](size_t i) {
+            results[i] = ConvexHullCache::decompose(*prims[i], params.m_paramsVHACD, cacheDir);
+        });
 
-            if(good_ch_flag) {
-                listPrim->arr.push_back(std::move(outprim));
-            }
+        auto listList = std::make_shared<zeno::ListObject>();
+        for (auto &hulls : results) {
+            auto listPrim = std::make_shared<zeno::ListObject>();
+            for (auto &hull : hulls)
+                listPrim->arr.push_back(std::move(hull));
+            listList->arr.push_back(std::move(listPrim));
         }
-
-        interfaceVHACD->Clean();
-        interfaceVHACD->Release();
-
-        set_output("listPrim", std::move(listPrim));
+        set_output("listList", std::move(listList));
     }
 };
 
-ZENDEFNODE(PrimitiveConvexDecompositionV, {
-    {"prim"},
-    {"listPrim"},
+ZENDEFNODE(PrimitiveConvexDecompositionVBatch, {
+    {"primList", {"readpath", "cacheDir", ""}},
+    {"listList"},
     {},
     {"Bullet"},
 });
@@ -1722,6 +1880,38 @@ ZENDEFNODE(BulletWorldSetObjList, {
                                       {"Bullet"},
                                   });
 
+struct BulletWorldGetBodyStates : zeno::INode {
+    virtual void apply() override {
+        auto world = get_input<BulletWorld>("world");
+        auto prim = std::make_shared<zeno::PrimitiveObject>();
+        world->getBodyStates(*prim);
+        set_output("prim", std::move(prim));
+    }
+};
+
+ZENDEFNODE(BulletWorldGetBodyStates, {
+                                         {"world"},
+                                         {"prim"},
+                                         {},
+                                         {"Bullet"},
+                                     });
+
+struct BulletWorldSetBodyStates : zeno::INode {
+    virtual void apply() override {
+        auto world = get_input<BulletWorld>("world");
+        auto prim = get_input<zeno::PrimitiveObject>("prim");
+        world->setBodyStates(*prim, get_input2<bool>("kinematicOnly"));
+        set_output("world", get_input("world"));
+    }
+};
+
+ZENDEFNODE(BulletWorldSetBodyStates, {
+                                         {"world", "prim", {"bool", "kinematicOnly", "1"}},
+                                         {"world"},
+                                         {},
+                                         {"Bullet"},
+                                     });
+
 struct BulletWorldAddConstraint : zeno::INode {
     virtual void apply() override {
         auto world = get_input<BulletWorld>("world");
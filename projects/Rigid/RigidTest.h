@@ -1,5 +1,7 @@
 #include <zeno/utils/logger.h>
 #include <zeno/zeno.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/para/parallel_for.h>
 
 // bullet basics
 #include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
@@ -600,6 +602,86 @@ struct BulletWorld : zeno::IObject {
             printf("world pos object %d = %f,%f,%f\n", j, float(trans.getOrigin().getX()), float(trans.getOrigin().getY()), float(trans.getOrigin().getZ()));
         }*/
     }
+
+    // bulk state access, point i of the primitive is the i-th collision object
+    // of dynamicsWorld. attributes: pos, rot (quaternion xyzw), vel, angVel
+    void getBodyStates(zeno::PrimitiveObject &prim) const {
+        auto const &colObjs = dynamicsWorld->getCollisionObjectArray();
+        size_t n = colObjs.size();
+        prim.verts.resize(n);
+        auto &pos = prim.verts.values;
+        auto &rot = prim.verts.add_attr<zeno::vec4f>("rot");
+        auto &vel = prim.verts.add_attr<zeno::vec3f>("vel");
+        auto &angVel = prim.verts.add_attr<zeno::vec3f>("angVel");
+        zeno::parallel_for(n, [&](size_t i) {
+            btCollisionObject const *obj = colObjs[i];
+            btRigidBody const *body = btRigidBody::upcast(obj);
+            btTransform trans;
+            if (body && body->getMotionState()) {
+                body->getMotionState()->getWorldTransform(trans);
+            } else {
+                trans = obj->getWorldTransform();
+            }
+            pos[i] = zeno::vec3f(zeno::other_to_vec<3>(trans.getOrigin()));
+            rot[i] = zeno::vec4f(zeno::other_to_vec<4>(trans.getRotation()));
+            if (body) {
+                vel[i] = zeno::vec3f(zeno::other_to_vec<3>(body->getLinearVelocity()));
+                angVel[i] = zeno::vec3f(zeno::other_to_vec<3>(body->getAngularVelocity()));
+            } else {
+                vel[i] = zeno::vec3f(0);
+                angVel[i] = zeno::vec3f(0);
+            }
+        });
+    }
+
+    // bulk setter for kinematic drivers, the inverse of getBodyStates.
+    // rot, vel and angVel are optional; an int attribute "bodyIndex" selects
+    // which collision object each point drives (must be unique), otherwise
+    // point i drives object i. with kinematicOnly, dynamic bodies are skipped
+    void setBodyStates(zeno::PrimitiveObject const &prim, bool kinematicOnly) {
+        auto &colObjs = dynamicsWorld->getCollisionObjectArray();
+        size_t nobjs = colObjs.size();
+        auto const &pos = prim.verts.values;
+        auto const *rot = prim.verts.has_attr("rot") ? &prim.verts.attr<zeno::vec4f>("rot") : nullptr;
+        auto const *vel = prim.verts.has_attr("vel") ? &prim.verts.attr<zeno::vec3f>("vel") : nullptr;
+        auto const *angVel = prim.verts.has_attr("angVel") ? &prim.verts.attr<zeno::vec3f>("angVel") : nullptr;
+        auto const *bodyIndex = prim.verts.has_attr("bodyIndex") ? &prim.verts.attr<int>("bodyIndex") : nullptr;
+        if (!bodyIndex && prim.verts.size() > nobjs)
+            throw std::runtime_error("more points than bodies in the world and no bodyIndex given");
+
+        zeno::parallel_for(prim.verts.size(), [&](size_t i) {
+            size_t objIndex = bodyIndex ? (size_t)(*bodyIndex)[i] : i;
+            if (objIndex >= nobjs)
+                return;
+            btCollisionObject *obj = colObjs[objIndex];
+            btRigidBody *body = btRigidBody::upcast(obj);
+            if (kinematicOnly && !obj->isKinematicObject())
+                return;
+
+            btTransform trans;
+            trans.setOrigin(zeno::vec_to_other<btVector3>(pos[i]));
+            if (rot) {
+                auto q = (*rot)[i];
+                trans.setRotation(btQuaternion(q[0], q[1], q[2], q[3]));
+            } else {
+                trans.setBasis(obj->getWorldTransform().getBasis());
+            }
+            if (body) {
+                // kinematic bodies are driven through the motion state
+                if (body->getMotionState())
+                    body->getMotionState()->setWorldTransform(trans);
+                if (!body->isKinematicObject())
+                    body->setCenterOfMassTransform(trans);
+                if (vel)
+                    body->setLinearVelocity(zeno::vec_to_other<btVector3>((*vel)[i]));
+                if (angVel)
+                    body->setAngularVelocity(zeno::vec_to_other<btVector3>((*angVel)[i]));
+                body->activate();
+            } else {
+                obj->setWorldTransform(trans);
+            }
+        });
+    }
 };
 
 struct MultiBodyJointFeedback : zeno::IObject {
@@ -14,6 +14,12 @@
 
 #include <igl/lbs_matrix.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <utility>
+
 #include "skinning_iobject.h"
 
 namespace{
@@ -68,6 +74,79 @@ ZENDEFNODE(BlendPoses, {
     {"Skinning"},
 });
 
+// the global rotation and translation of each bone, either given directly
+// or by forward kinematics of the local ones along restBones
+static void skinning_transforms(zeno::INode const *node, size_t nm_handles, RotationList &Qs, std::vector<Eigen::Vector3d> &Ts) {
+    auto Qs_ = node->get_input<zeno::ListObject>("Qs")->get<NumericObject>();
+    auto Ts_ = node->get_input<zeno::ListObject>("Ts")->get<NumericObject>();
+    if(Qs_.size() < nm_handles || Ts_.size() < nm_handles)
+        throw std::runtime_error("NOT ENOUGH BONE TRANSFORMATIONS: " + std::to_string(Qs_.size()) + " Qs AND "
+            + std::to_string(Ts_.size()) + " Ts FOR " + std::to_string(nm_handles) + " BONES");
+
+    auto do_FK = node->get_param<int>("FK");
+    if(!do_FK){
+        std::cout << "GLOBAL TRANSFORMATION BLENDING" << std::endl;
+        std::cout << "NM_HANDLES : " << nm_handles << std::endl;
+        for(size_t i = 0;i < nm_handles;++i){
+            if(std::isnan(zeno::length(Ts_[i]->get<zeno::vec3f>())) || std::isnan(zeno::length(Qs_[i]->get<zeno::vec4f>()))){
+                std::cout << "NAN RIGGING AFFINE TRANSFORMATION DETECTED" << std::endl;
+                std::cout << "T<" << i << "> : " << Eigen::Vector3d(Ts_[i]->get<zeno::vec3f>()[0],
+                    Ts_[i]->get<zeno::vec3f>()[1],
+                    Ts_[i]->get<zeno::vec3f>()[2]).transpose() << std::endl;
+
+                std::cout << "Q<" << i << "> : " << Eigen::Vector4d(Qs_[i]->get<zeno::vec4f>()[0],
+                    Qs_[i]->get<zeno::vec4f>()[1],
+                    Qs_[i]->get<zeno::vec4f>()[2],
+                    Qs_[i]->get<zeno::vec4f>()[3]).transpose() << std::endl;
+
+                throw std::runtime_error("NAN RIGGING AFFINE TRANSFORMATION DETECTED");
+            }
+
+            Ts.emplace_back(Ts_[i]->get<zeno::vec3f>()[0],
+                Ts_[i]->get<zeno::vec3f>()[1],
+                Ts_[i]->get<zeno::vec3f>()[2]);
+            Qs.emplace_back(Qs_[i]->get<zeno::vec4f>()[3],
+                Qs_[i]->get<zeno::vec4f>()[0],
+                Qs_[i]->get<zeno::vec4f>()[1],
+                Qs_[i]->get<zeno::vec4f>()[2]);
+        }
+    }else{
+        if(!node->has_input("restBones")){
+            throw std::runtime_error("INPUT JOINTS INFOR FOR FORWARD KINEMATICS");
+        }
+        auto bones = node->get_input<PrimitiveObject>("restBones");
+        std::vector<Eigen::Vector3d> LFT;
+        RotationList LFQ;
+        for(size_t i = 0;i < nm_handles;++i){
+            LFT.emplace_back(Ts_[i]->get<zeno::vec3f>()[0],
+                Ts_[i]->get<zeno::vec3f>()[1],
+                Ts_[i]->get<zeno::vec3f>()[2]);
+            LFQ.emplace_back(Qs_[i]->get<zeno::vec4f>()[3],
+                Qs_[i]->get<zeno::vec4f>()[0],
+                Qs_[i]->get<zeno::vec4f>()[1],
+                Qs_[i]->get<zeno::vec4f>()[2]);
+        }
+
+        Eigen::MatrixXd C;
+        Eigen::MatrixXi BE;
+
+        C.resize(bones->size(),3);
+        BE.resize(bones->lines.size(),2);
+
+        for(size_t i = 0;i < bones->size();++i){
+            C.row(i) << bones->verts[i][0],bones->verts[i][1],bones->verts[i][2];
+        }
+
+        for(size_t i = 0;i < bones->lines.size();++i)
+            BE.row(i) << bones->lines[i][0],bones->lines[i][1];
+
+        Eigen::VectorXi P;
+        igl::directed_edge_parents(BE,P);
+        // std::cout << "DO FORWARD KINEMATICS" << std::endl;
+        igl::forward_kinematics(C,BE,P,LFQ,LFT,Qs,Ts);
+    }
+}
+
 // input the forward kinematics result
 struct DoSkinning : zeno::INode {
     virtual void apply() override {
@@ -76,9 +155,6 @@ struct DoSkinning : zeno::INode {
         auto attr_prefix = get_param<std::string>("attr_prefix");
         auto outputChannel = get_param<std::string>("out_channel");
 
-        auto Qs_ = get_input<zeno::ListObject>("Qs")->get<NumericObject>();
-        auto Ts_ = get_input<zeno::ListObject>("Ts")->get<NumericObject>();
-
         // std::cout << "GOT QS AND TS INPUT" << std::endl;
         size_t dim = 3;
         size_t nm_handles = 0;
@@ -121,68 +197,7 @@ struct DoSkinning : zeno::INode {
 
         // std::cout << "CHECKOUT_2" << std::endl;
 
-        auto do_FK = get_param<int>("FK");
-        if(!do_FK){
-            std::cout << "GLOBAL TRANSFORMATION BLENDING" << std::endl;
-            std::cout << "NM_HANDLES : " << nm_handles << std::endl;
-            for(size_t i = 0;i < nm_handles;++i){
-                if(std::isnan(zeno::length(Ts_[i]->get<zeno::vec3f>())) || std::isnan(zeno::length(Qs_[i]->get<zeno::vec4f>()))){
-                    std::cout << "NAN RIGGING AFFINE TRANSFORMATION DETECTED" << std::endl;
-                    std::cout << "T<" << i << "> : " << Eigen::Vector3d(Ts_[i]->get<zeno::vec3f>()[0],
-                        Ts_[i]->get<zeno::vec3f>()[1],
-                        Ts_[i]->get<zeno::vec3f>()[2]).transpose() << std::endl;
-
-                    std::cout << "Q<" << i << "> : " << Eigen::Vector4d(Qs_[i]->get<zeno::vec4f>()[0],
-                        Qs_[i]->get<zeno::vec4f>()[1],
-                        Qs_[i]->get<zeno::vec4f>()[2],
-                        Qs_[i]->get<zeno::vec4f>()[3]).transpose() << std::endl;
-
-                    throw std::runtime_error("NAN RIGGING AFFINE TRANSFORMATION DETECTED");
-                }
-
-                Ts.emplace_back(Ts_[i]->get<zeno::vec3f>()[0],
-                    Ts_[i]->get<zeno::vec3f>()[1],
-                    Ts_[i]->get<zeno::vec3f>()[2]);
-                Qs.emplace_back(Qs_[i]->get<zeno::vec4f>()[3],
-                    Qs_[i]->get<zeno::vec4f>()[0],
-                    Qs_[i]->get<zeno::vec4f>()[1],
-                    Qs_[i]->get<zeno::vec4f>()[2]);
-            }
-        }else{
-            if(!has_input("restBones")){
-                throw std::runtime_error("INPUT JOINTS INFOR FOR FORWARD KINEMATICS");
-            }
-            auto bones = get_input<PrimitiveObject>("restBones");
-            std::vector<Eigen::Vector3d> LFT;
-            RotationList LFQ;
-            for(size_t i = 0;i < nm_handles;++i){
-                LFT.emplace_back(Ts_[i]->get<zeno::vec3f>()[0],
-                    Ts_[i]->get<zeno::vec3f>()[1],
-                    Ts_[i]->get<zeno::vec3f>()[2]);
-                LFQ.emplace_back(Qs_[i]->get<zeno::vec4f>()[3],
-                    Qs_[i]->get<zeno::vec4f>()[0],
-                    Qs_[i]->get<zeno::vec4f>()[1],
-                    Qs_[i]->get<zeno::vec4f>()[2]);
-            }
-
-            Eigen::MatrixXd C;
-            Eigen::MatrixXi BE;
-
-            C.resize(bones->size(),3);
-            BE.resize(bones->lines.size(),2);
-
-            for(size_t i = 0;i < bones->size();++i){
-                C.row(i) << bones->verts[i][0],bones->verts[i][1],bones->verts[i][2];
-            }
-
-            for(size_t i = 0;i < bones->lines.size();++i)
-                BE.row(i) << bones->lines[i][0],bones->lines[i][1];
-
-            Eigen::VectorXi P;
-            igl::directed_edge_parents(BE,P);
-            // std::cout << "DO FORWARD KINEMATICS" << std::endl;
-            igl::forward_kinematics(C,BE,P,LFQ,LFT,Qs,Ts);
-        }
+        skinning_transforms(this, nm_handles, Qs, Ts);
 
 
 
@@ -251,4 +266,203 @@ ZENDEFNODE(DoSkinning, {
     {"Skinning"},
 });
 
+// keeps the K heaviest of the nm_handles weight attributes of each vertex,
+// rescaled so they still add up to the total of all of them
+static std::shared_ptr<SparseSkinningWeight> make_sparse_skinning_weight(PrimitiveObject *shape, std::string const &attr_prefix, int K) {
+    std::vector<float const *> ws;
+    while(shape->has_attr(attr_prefix + "_" + std::to_string(ws.size())))
+        ws.push_back(shape->attr<float>(attr_prefix + "_" + std::to_string(ws.size())).data());
+    if(ws.empty())
+        throw std::runtime_error("The Skinned Prim Does Not Have Weight Attr");
+
+    auto res = std::make_shared<SparseSkinningWeight>();
+    res->K = std::clamp<int>(K, 1, ws.size());
+    res->nm_bones = ws.size();
+    res->nm_verts = shape->size();
+    res->bones.assign(res->nm_verts * res->K, 0);
+    res->weights.assign(res->nm_verts * res->K, 0.0f);
+
+    bool has_nan = false;
+    K = res->K;
+    #pragma omp parallel for reduction(||:has_nan)
+    for(intptr_t i = 0;i < (intptr_t)res->nm_verts;++i){
+        int *bi = res->bones.data() + i * K;
+        float *wi = res->weights.data() + i * K;
+        float total = 0, kept = 0;
+        for(int b = 0;b < (int)ws.size();++b){
+            float w = ws[b][i];
+            has_nan = has_nan || std::isnan(w);
+            total += w;
+            if(!(std::abs(w) > std::abs(wi[K - 1])))
+                continue;
+            int k = K - 1;
+            for(;k > 0 && std::abs(wi[k - 1]) < std::abs(w);--k){
+                wi[k] = wi[k - 1];
+                bi[k] = bi[k - 1];
+            }
+            wi[k] = w;
+            bi[k] = b;
+        }
+        for(int k = 0;k < K;++k)
+            kept += wi[k];
+        if(kept != 0 && kept != total)
+            for(int k = 0;k < K;++k)
+                wi[k] *= total / kept;
+    }
+    if(has_nan)
+        throw std::runtime_error("NAN VALUE DETECTED IN SKINNING WEIGHT MATRIX");
+    return res;
+}
+
+// identity of the dense weight attributes, the address and size of each one;
+// comparing it costs O(B) per frame, but weights edited in place without
+// reallocation are not noticed, wire a MakeSparseSkinningWeight then
+static std::vector<std::pair<float const *, size_t>> skinning_weight_key(PrimitiveObject *shape, std::string const &attr_prefix) {
+    std::vector<std::pair<float const *, size_t>> key;
+    while(shape->has_attr(attr_prefix + "_" + std::to_string(key.size()))){
+        auto const &w = shape->attr<float>(attr_prefix + "_" + std::to_string(key.size()));
+        key.emplace_back(w.data(), w.size());
+    }
+    return key;
+}
+
+struct MakeSparseSkinningWeight : zeno::INode {
+    virtual void apply() override {
+        auto shape = get_input<PrimitiveObject>("shape");
+        auto attr_prefix = get_param<std::string>("attr_prefix");
+        auto K = get_param<int>("K");
+        set_output("sparseWeight",make_sparse_skinning_weight(shape.get(),attr_prefix,K));
+    }
+};
+
+ZENDEFNODE(MakeSparseSkinningWeight, {
+    {"shape"},
+    {"sparseWeight"},
+    {{"string","attr_prefix","sw"},{"int","K","4"}},
+    {"Skinning"},
+});
+
+// same as DoSkinning, but each vertex only visits its K heaviest bones, so
+// time and memory are O(V * K) instead of O(V * B); the sparse weights are
+// either given or built from the shape and kept while its weight attributes
+// stay the same arrays
+struct DoSparseSkinning : zeno::INode {
+    std::weak_ptr<PrimitiveObject> cachedShape;
+    std::vector<std::pair<float const *, size_t>> cachedKey;
+    std::string cachedPrefix;
+    int cachedK = 0;
+    std::shared_ptr<SparseSkinningWeight> cachedWeight;
+
+    virtual void apply() override {
+        auto shape = get_input<PrimitiveObject>("shape");
+        auto algorithm = get_param<std::string>(("algorithm"));
+        auto attr_prefix = get_param<std::string>("attr_prefix");
+        auto outputChannel = get_param<std::string>("out_channel");
+        auto K = get_param<int>("K");
+
+        std::shared_ptr<SparseSkinningWeight> sw;
+        if(has_input("sparseWeight")){
+            sw = get_input<SparseSkinningWeight>("sparseWeight");
+        }else{
+            auto key = skinning_weight_key(shape.get(),attr_prefix);
+            if(!cachedWeight || cachedShape.lock() != shape || cachedKey != key || cachedPrefix != attr_prefix
+                || cachedK != K || cachedWeight->nm_verts != shape->size()){
+                cachedWeight = make_sparse_skinning_weight(shape.get(),attr_prefix,K);
+                cachedShape = shape;
+                cachedKey = std::move(key);
+                cachedPrefix = attr_prefix;
+                cachedK = K;
+            }
+            sw = cachedWeight;
+        }
+        if(sw->nm_verts != shape->size())
+            throw std::runtime_error("THE SPARSE SKINNING WEIGHT DOES NOT MATCH THE SHAPE");
+
+        RotationList Qs;
+        std::vector<Eigen::Vector3d> Ts;
+        skinning_transforms(this, sw->nm_bones, Qs, Ts);
+
+        auto deformed_shape = std::make_shared<zeno::PrimitiveObject>(*shape);
+        auto &out_chan = deformed_shape->add_attr<zeno::vec3f>(outputChannel);
+        auto const &verts = shape->verts;
+        int const *bones = sw->bones.data();
+        float const *weights = sw->weights.data();
+        intptr_t nv = sw->nm_verts;
+        K = sw->K;
+
+        if(algorithm == "DQS"){
+            // rotation and dual part of each bone, the same as igl::dqs
+            std::vector<zeno::vec4f> vQ(sw->nm_bones), vD(sw->nm_bones);
+            for(size_t c = 0;c < sw->nm_bones;++c){
+                auto const &q = Qs[c];
+                auto const &t = Ts[c];
+                vQ[c] = zeno::vec4f(q.x(),q.y(),q.z(),q.w());
+                vD[c] = zeno::vec4f( 0.5*( t(0)*q.w() + t(1)*q.z() - t(2)*q.y()),
+                                     0.5*(-t(0)*q.z() + t(1)*q.w() + t(2)*q.x()),
+                                     0.5*( t(0)*q.y() - t(1)*q.x() + t(2)*q.w()),
+                                    -0.5*( t(0)*q.x() + t(1)*q.y() + t(2)*q.z()));
+            }
+            bool has_zero = false;
+            #pragma omp parallel for reduction(||:has_zero)
+            for(intptr_t i = 0;i < nv;++i){
+                int const *bi = bones + i * K;
+                float const *wi = weights + i * K;
+                zeno::vec4f b0(0), be(0);
+                for(int k = 0;k < K;++k){
+                    // flip into the hemisphere of the heaviest bone, so that
+                    // antipodal rotations don't cancel out
+                    float w = zeno::dot(vQ[bi[k]],vQ[bi[0]]) < 0 ? -wi[k] : wi[k];
+                    b0 += w * vQ[bi[k]];
+                    be += w * vD[bi[k]];
+                }
+                float len = zeno::length(b0);
+                if(!(len > 0)){
+                    has_zero = true;
+                    continue;
+                }
+                zeno::vec3f d0 = zeno::vec3f(b0[0],b0[1],b0[2]) / len;
+                zeno::vec3f de = zeno::vec3f(be[0],be[1],be[2]) / len;
+                float a0 = b0[3] / len;
+                float ae = be[3] / len;
+                auto const &v = verts[i];
+                out_chan[i] = v + 2 * zeno::cross(d0, zeno::cross(d0, v) + a0 * v)
+                                + 2 * (a0 * de - ae * d0 + zeno::cross(d0, de));
+            }
+            // DoSkinning would get NaNs from igl::dqs here and throw as well
+            if(has_zero)
+                throw std::runtime_error("IN SPARSE SKINNING ZERO WEIGHT VERTEX DETECTED");
+        }else if(algorithm == "LBS"){
+            // columns of the 3x4 affine of each bone
+            std::vector<std::array<zeno::vec3f,4>> A(sw->nm_bones);
+            for(size_t c = 0;c < sw->nm_bones;++c){
+                Eigen::Matrix3d R = Qs[c].toRotationMatrix();
+                for(int j = 0;j < 3;++j)
+                    A[c][j] = zeno::vec3f(R(0,j),R(1,j),R(2,j));
+                A[c][3] = zeno::vec3f(Ts[c](0),Ts[c](1),Ts[c](2));
+            }
+            #pragma omp parallel for
+            for(intptr_t i = 0;i < nv;++i){
+                int const *bi = bones + i * K;
+                float const *wi = weights + i * K;
+                auto const &v = verts[i];
+                zeno::vec3f u(0);
+                for(int k = 0;k < K;++k){
+                    auto const &a = A[bi[k]];
+                    u += wi[k] * (a[0] * v[0] + a[1] * v[1] + a[2] * v[2] + a[3]);
+                }
+                out_chan[i] = u;
+            }
+        }
+
+        set_output("dshape",std::move(deformed_shape));
+    }
+};
+
+ZENDEFNODE(DoSparseSkinning, {
+    {"shape","Qs","Ts","restBones","sparseWeight"},
+    {"dshape"},
+    {{"enum LBS DQS","algorithm","DQS"},{"string","attr_prefix","sw"},{"string","out_channel","curPos"},{"int","FK","0"},{"int","K","4"}},
+    {"Skinning"},
+});
+
 };
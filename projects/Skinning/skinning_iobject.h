@@ -28,4 +28,15 @@ struct SkinningWeight : zeno::IObject {
     Eigen::MatrixXd weight;
 };
 
+// the K largest (bone, weight) pairs of each vertex, vertex i owns the slots
+// [i * K, (i + 1) * K), sorted by decreasing |weight|, unused ones are 0
+struct SparseSkinningWeight : zeno::IObject {
+    SparseSkinningWeight() = default;
+    int K = 0;
+    size_t nm_bones = 0;
+    size_t nm_verts = 0;
+    std::vector<int> bones;
+    std::vector<float> weights;
+};
+
 };
\ No newline at end of file
@@ -232,8 +232,10 @@ struct VDBWrangle : zeno::INode {
             (get_input<zeno::StringObject>("ChangeBackground")->get())=="true" : false;
         if (auto p = std::dynamic_pointer_cast<zeno::VDBFloatGrid>(grid); p)
             vdb_wrangle(exec, p->m_grid, modifyActive, changeBackground, hasPos);
-        else if (auto p = std::dynamic_pointer_cast<zeno::VDBFloat3Grid>(grid); p)
+        else if (auto p = std::dynamic_pointer_cast<zeno::VDBFloat3Grid>(grid); p) {
             vdb_wrangle(exec, p->m_grid, modifyActive, changeBackground, hasPos);
+            p->invalidatePackedGrid();
+        }
 
         set_output("grid", std::move(grid));
     }
@@ -75,6 +75,7 @@ struct  ResampleVDBGrid : zeno::INode {
           auto target = get_input("resampleTo")->as<VDBFloat3Grid>();
           auto source = get_input("resampleFrom")->as<VDBFloat3Grid>();
           resampleVDB<openvdb::Vec3fGrid>(source->m_grid, target->m_grid);
+          target->invalidatePackedGrid();
         }
         set_output("resampleTo", get_input("resampleTo"));
     } else {
@@ -144,6 +145,7 @@ struct CombineVDB : zeno::INode{
         auto source = get_input("FieldB")->as<VDBFloat3Grid>();
         auto srcgrid = source->m_grid->deepCopy();
         openvdb::tools::compSum(*(target->m_grid), *(srcgrid));
+        target->invalidatePackedGrid();
         set_output("FieldOut", get_input("FieldA"));
       }
     }
@@ -161,6 +163,7 @@ struct CombineVDB : zeno::INode{
         auto source = get_input("FieldB")->as<VDBFloat3Grid>();
         auto srcgrid = source->m_grid->deepCopy();
         openvdb::tools::compMul(*(target->m_grid), *(srcgrid));
+        target->invalidatePackedGrid();
         set_output("FieldOut", get_input("FieldA"));
       }
     }
@@ -178,6 +181,7 @@ struct CombineVDB : zeno::INode{
         auto source = get_input("FieldB")->as<VDBFloat3Grid>();
         auto srcgrid = source->m_grid->deepCopy();
         openvdb::tools::compReplace(*(target->m_grid), *(srcgrid));
+        target->invalidatePackedGrid();
         set_output("FieldOut", get_input("FieldA"));
       }
     }
@@ -249,6 +253,7 @@ struct VDBDeactivate : zeno::INode
       openvdb::tree::LeafManager<std::decay_t<decltype(grid->tree())>> leafman(grid->tree());
       leafman.foreach(modifier);
       openvdb::tools::prune(grid->tree());
+      get_input<VDBFloat3Grid>("Field")->invalidatePackedGrid();
     }
   }
 };
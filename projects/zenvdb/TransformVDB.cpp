@@ -36,6 +36,7 @@ struct TransformVDB : INode {
         } else if (type == "Vec3fGrid") {
             auto &grid = std::dynamic_pointer_cast<VDBFloat3Grid>(vdb)->m_grid;
             vdb_transform(grid, tran, euler, sca);
+            std::dynamic_pointer_cast<VDBFloat3Grid>(vdb)->invalidatePackedGrid();
         } else if (type == "Vec3IGrid") {
             auto &grid = std::dynamic_pointer_cast<VDBInt3Grid>(vdb)->m_grid;
             vdb_transform(grid, tran, euler, sca);
@@ -37,6 +37,7 @@ struct VDBFillActiveVoxels : INode {
         auto velman = openvdb::tree::LeafManager
             <std::decay_t<decltype(p->m_grid->tree())>>(p->m_grid->tree());
         velman.foreach(fill_voxels_op(vec_to_other<openvdb::Vec3f>(std::get<zeno::vec3f>(value))));
+        p->invalidatePackedGrid();
     }
 
     set_output("grid", get_input("grid"));
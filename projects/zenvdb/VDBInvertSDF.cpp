@@ -16,6 +16,7 @@ struct VDBChangeBackground : INode{
         openvdb::tools::changeBackground(p->m_grid->tree(), get_input2<float>("background"));
     } else if (auto p = std::dynamic_pointer_cast<VDBFloat3Grid>(grid); p) {
         openvdb::tools::changeBackground(p->m_grid->tree(), vec_to_other<openvdb::Vec3f>(get_input2<zeno::vec3f>("background")));
+        p->invalidatePackedGrid();
     }
 
     set_output("grid", get_input("grid"));
@@ -75,6 +76,7 @@ struct VDBInvertSDF : INode{
         visitor(p->m_grid);
     } else if (auto p = std::dynamic_pointer_cast<VDBFloat3Grid>(grid)) {
         visitor(p->m_grid);
+        p->invalidatePackedGrid();
     }
 
     set_output("grid", get_input("grid"));
@@ -86,6 +86,7 @@ struct VDBSmooth : zeno::INode {
               lsf.mean(width, iterations, mask.get());
             else if(type == "Median")
               lsf.median(width, iterations, mask.get());
+            inoutVDB->invalidatePackedGrid();
             set_output("inoutVDB", get_input("inoutVDB"));
         }
     }
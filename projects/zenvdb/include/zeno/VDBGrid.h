@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <optional>
 #include <vector>
 #include <zeno/zeno.h>
@@ -194,6 +196,42 @@ struct VDBGridWrapper<openvdb::Vec3fGrid> : zeno::IObjectClone<VDBGridWrapper<op
     if (!hasPackedGrid()) throw std::runtime_error("packed version of vec3fgrid is not initialized!");
     return *m_packedGrid;
   }
+
+  // the packed copy is reused while it matches m_grid: both carry the same
+  // version number and m_grid still holds the same tree. nodes that write
+  // m_grid in place (rather than through the packed copy) must bump the
+  // version with invalidatePackedGrid(); replacing the tree is caught anyway
+  std::uint64_t m_gridVersion = 0;
+  std::uint64_t m_packedVersion = 0;
+  std::weak_ptr<const typename GridT::TreeType> m_packedTree;
+
+  bool isPackedGridInSync() const {
+    return hasPackedGrid() && m_grid && m_packedVersion == m_gridVersion &&
+           !m_packedTree.expired() && m_packedTree.lock() == m_grid->constTreePtr();
+  }
+  void markPackedGridInSync() {
+    m_packedVersion = m_gridVersion;
+    m_packedTree = m_grid->constTreePtr();
+  }
+  void invalidatePackedGrid() {
+    ++m_gridVersion;
+  }
+  // packed copy of m_grid, converted only when m_grid changed since the copy was made
+  packed_FloatGrid3 &acquirePackedGrid() {
+    if (!isPackedGridInSync()) {
+      if (!hasPackedGrid())
+        m_packedGrid.emplace();
+      m_packedGrid->from_vec3(m_grid);
+      markPackedGridInSync();
+    }
+    return *m_packedGrid;
+  }
+  // write the packed copy back after a solver node modified it
+  void syncPackedToGrid() {
+    refPackedGrid().to_vec3(m_grid);
+    ++m_gridVersion;
+    markPackedGridInSync();
+  }
   ///
 
   virtual ~VDBGridWrapper() override = default;
@@ -216,6 +254,7 @@ struct VDBGridWrapper<openvdb::Vec3fGrid> : zeno::IObjectClone<VDBGridWrapper<op
           m_grid = nullptr;
           m_packedGrid = {};
       }
+      invalidatePackedGrid();
       return *this;
   }
 
@@ -241,9 +280,11 @@ struct VDBGridWrapper<openvdb::Vec3fGrid> : zeno::IObjectClone<VDBGridWrapper<op
 
   virtual void input(std::string path) override {
     m_grid = readFloatGrid<GridT>(path);
+    invalidatePackedGrid();
     m_packedGrid = packed_FloatGrid3{};
     auto &packed = refPackedGrid();
     packed.from_vec3(m_grid);
+    markPackedGridInSync();
   }
 
   virtual const openvdb::math::Transform& getTransform() override {
@@ -253,15 +294,18 @@ struct VDBGridWrapper<openvdb::Vec3fGrid> : zeno::IObjectClone<VDBGridWrapper<op
   virtual void
   setTransform(openvdb::math::Transform::Ptr const &trans) override {
     m_grid->setTransform(trans);
+    invalidatePackedGrid();
   }
   virtual void
   dilateTopo(int l) override {
     openvdb::tools::dilateActiveValues(
       m_grid->tree(), l,
       openvdb::tools::NearestNeighbors::NN_FACE_EDGE_VERTEX, openvdb::tools::TilePolicy::EXPAND_TILES);
+      invalidatePackedGrid();
       if (hasPackedGrid()) {
         auto &packed = refPackedGrid();
         packed.from_vec3(m_grid);
+        markPackedGridInSync();
       }
   }
 
@@ -2,7 +2,9 @@
 
 #include <zeno/utils/api.h>
 #include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/PrimitiveTopology.h>
 #include <string>
+#include <vector>
 
 namespace zeno {
 
@@ -13,11 +15,20 @@ ZENO_API void primTriangulate(PrimitiveObject *prim, bool with_uv = true, bool h
 ZENO_API void primTriangulateIntoPolys(PrimitiveObject *prim);
 ZENO_API void primPolygonate(PrimitiveObject *prim, bool with_uv = true);
 
+// sweep-line triangulation of one loop (indices into verts), outputs corner triples in [0, len);
+// convex loops get the fan, triangles keep the winding of the loop
+ZENO_API void polygonTriangulate(vec3f const *verts, int const *loop, int len, std::vector<vec3i> &triangles);
+// rings[0] is the outline, the other rings are holes, outputs vertex indices
+ZENO_API void polygonTriangulate(std::vector<vec3f> const &verts, std::vector<std::vector<int>> const &rings, std::vector<vec3i> &triangles);
+ZENO_API void polygonDecompose(std::vector<vec3f> const &verts, std::vector<int> const &poly, std::vector<vec3i> &triangles);
+
 ZENO_API void primSepTriangles(PrimitiveObject *prim, bool smoothNormal = true, bool keepTriFaces = true);
 //ZENO_API void primSmoothNormal(PrimitiveObject *prim, bool isFlipped = false);
 
 ZENO_API void primFlipFaces(PrimitiveObject *prim, bool only_face = false);
-ZENO_API void primCalcNormal(PrimitiveObject *prim, float flip = 1.0f, std::string nrmAttr = "nrm");
+// weighting: default (per corner cross products), area or angle; cuspAngle in degrees,
+// when in (0, 180) per-corner normals split at sharper edges are added too
+ZENO_API void primCalcNormal(PrimitiveObject *prim, float flip = 1.0f, std::string nrmAttr = "nrm", std::string weighting = "default", float cuspAngle = 0.0f);
 //ZENO_API void primCalcInsetDir(PrimitiveObject *prim, float flip = 1.0f, std::string nrmAttr = "nrm");
 
 ZENO_API void primWireframe(PrimitiveObject *prim, bool removeFaces = false, bool toEdges = false);
@@ -38,9 +49,14 @@ ZENO_API void prim_set_faceset(PrimitiveObject* prim, std::string faceset_name);
 
 ZENO_API void primFilterVerts(PrimitiveObject *prim, std::string tagAttr, int tagValue, bool isInversed = false, std::string revampAttrO = {}, std::string method = "verts", int* aux = nullptr, int aux_size = 0, bool use_aux = false);
 
+ZENO_API std::shared_ptr<PrimitiveTopology const> primTopology(PrimitiveObject *prim);
+
 ZENO_API void primMarkIsland(PrimitiveObject *prim, std::string tagAttr);
 ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr);
 ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeFaces(PrimitiveObject *prim, std::string tagAttr);
+// all pieces in one primitive, grouped by tag; ranges (if given) gets one point per tag
+// with the tagValue and the <array>Begin / <array>Count of the piece in every array
+ZENO_API std::shared_ptr<PrimitiveObject> primUnmergeShared(PrimitiveObject *prim, std::string tagAttr, bool byFaces = false, PrimitiveObject *ranges = nullptr);
 
 ZENO_API void primSimplifyTag(PrimitiveObject *prim, std::string tagAttr);
 ZENO_API void primColorByTag(PrimitiveObject *prim, std::string tagAttr, std::string clrAttr, int seed = -1);
@@ -54,6 +70,6 @@ ZENO_API void primRandomize(PrimitiveObject *prim, std::string attr, std::string
 ZENO_API void primPerlinNoise(PrimitiveObject *prim, std::string inAttr, std::string outAttr, std::string outType, float scale, float detail, float roughness, float disortion, vec3f offset, float average, float strength);
 
 ZENO_API std::shared_ptr<PrimitiveObject> primScatter(
-    PrimitiveObject *prim, std::string type, std::string denAttr, float density, float minRadius, bool interpAttrs, int seed);
+    PrimitiveObject *prim, std::string type, std::string denAttr, float density, float minRadius, bool interpAttrs, int seed, bool srcAttrs = false);
 
 }
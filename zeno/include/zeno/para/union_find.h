@@ -0,0 +1,46 @@
+#pragma once
+
+#include <zeno/para/parallel_for.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+namespace zeno {
+
+// lock-free union-find, parents always have a smaller index than their
+// children so concurrent linking can never make a cycle, and every root
+// ends up being the smallest element of its set
+struct ConcurrentUnionFind {
+    std::vector<std::atomic<int>> parent;
+
+    explicit ConcurrentUnionFind(std::size_t n) : parent(n) {
+        parallel_for(n, [&] (std::size_t i) {
+            parent[i].store(i, std::memory_order_relaxed);
+        });
+    }
+
+    int find(int i) {
+        while (true) {
+            int p = parent[i].load(std::memory_order_relaxed);
+            int gp = parent[p].load(std::memory_order_relaxed);
+            if (p == gp) return p;
+            // path halving, a failed exchange only means someone else shortened it
+            parent[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+            i = gp;
+        }
+    }
+
+    void unite(int a, int b) {
+        while (true) {
+            a = find(a);
+            b = find(b);
+            if (a == b) return;
+            if (a < b) std::swap(a, b);
+            int expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed))
+                return;
+        }
+    }
+};
+
+}
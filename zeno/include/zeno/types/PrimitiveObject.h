@@ -4,6 +4,7 @@
 #include <zeno/types/AttrVector.h>
 #include <zeno/utils/type_traits.h>
 #include <zeno/utils/vec.h>
+#include <atomic>
 #include <optional>
 #include <variant>
 #include <memory>
@@ -15,117 +16,7 @@ namespace zeno {
 
 struct MaterialObject;
 struct InstancingObject;
-/*
-    Assuming points {p_i}, 0<=i<n, forms a counterclockwise polygon,
-    compute the sum of the cross product of every triangle of a triangle
-    fan of the polygon (even in the concave parts):
-      normal = vector3(0, 0, 0);
-    for(int i=1; i<n-1; ++i)
-        normal += cross(p[i+1]-p[0],p[i]-p[0]);
-    normal /= norm(n);
-    This is derived from the Stoke's theorem.
-    The length of the normal (before normalization)
-    is equal to two times the signed area enclosed by the loop.
-    So you are guaranteed that it will not be null (if the area is not null)
-    and you are guaranteed that it will point in the right direction.
-
-*/
-static zeno::vec3f polyNormal(std::vector<zeno::vec3f> & verts, std::vector<int> &poly)
-{
-    zeno::vec3f normal = zeno::vec3f(0,0,0);
-    for(int i=1;i<poly.size()-1;i++)
-    {
-        normal += zeno::cross(verts[poly[i+1]]-verts[poly[0]], verts[poly[i]]-verts[poly[0]]);
-    }
-    normal = -zeno::normalize(normal);
-    return normal;
-}
-static char isReflex(zeno::vec3f a, zeno::vec3f b, zeno::vec3f c, zeno::vec3f n)
-{
-    
-    return zeno::dot(zeno::cross(b - a, c - b), n) <= 0 ? 1 : 0;
-}
-static void markReflex(std::vector<zeno::vec3f> &verts, std::vector<int> &poly, std::vector<char> &reflexMark,
-                       zeno::vec3f n) 
-{
-    reflexMark.resize(poly.size());
-    for(int i=0;i<poly.size();i++)
-    {
-        int prev = i==0? (poly.size()-1) : (i-1);
-        int next = i==(poly.size()-1)? 0 : (i+1);
-        reflexMark[i] = isReflex(verts[poly[prev]], verts[poly[i]], verts[poly[next]], n);
-    }
-}
-static void takeOutTriangle(std::vector<zeno::vec3f> & verts, std::vector<int> &poly, std::vector<char>& reflexMark, std::vector<zeno::vec3i> & triangles)
-{
-    if(poly.size()==3)
-    {
-        triangles.push_back(zeno::vec3i(poly[0], poly[1], poly[2]));
-        poly.resize(0);
-        return;
-    }else
-    {
-        //find 3 consecutive points which satisfy:
-        //if there are no reflex points, any 3 points
-        //if there are at least one reflex point, a must be the reflex point, and b must be a non-reflex point
-        char anyReflex = 0;
-        for(auto r:reflexMark)
-        {
-            //printf("r : %d\n", r);
-            anyReflex = anyReflex | r;
-        }
-
-
-        int a = 0;
-        int b = 1;
-        int c = 2;
-        while (zeno::length(zeno::cross(verts[poly[b]] - verts[poly[a]], verts[poly[c]] - verts[poly[b]])) <=
-               0.0000001)
-        {
-            a++;
-            b++;
-            c++;
-        }
-        
-        if(anyReflex == true)
-        {
-            while(a < poly.size())
-            {
-                b = (a + 1) % poly.size();
-                if(reflexMark[a] == true && reflexMark[b] == false)
-                    break;
-                a++;
-            }
-        }
-        c = (a+2) % poly.size();
-
-        triangles.push_back(zeno::vec3i(poly[a], poly[b], poly[c]));
-        //printf("tridx : %d, %d, %d\n", poly[a], poly[b], poly[c]);
-        //printf("tridx : %d, %d, %d\n", a, b, c);
-        //remove b from the poly loop
-        poly.erase(poly.begin()+b);
-        //recompute reflexMark
-        auto n = polyNormal(verts, poly);
-        //printf("n:%f, %f, %f\n", n[0], n[1], n[2]);
-        markReflex(verts, poly, reflexMark, n);
-        //recursively take out triangle from the rest of things
-        takeOutTriangle(verts, poly, reflexMark, triangles);
-    }
-}
-static void polygonDecompose(std::vector<zeno::vec3f> & verts, std::vector<int> &poly,
-                             std::vector<vec3i> & triangles)
-{
-    triangles.resize(0);
-    std::vector<char> reflexMark;
-    auto n = polyNormal(verts, poly);
-    markReflex(verts, poly, reflexMark, n);
-    for (int i=0;i<reflexMark.size();i++) {
-    
-        //printf("r: %d\n", reflexMark[i] );
-    }
-    takeOutTriangle(verts, poly, reflexMark, triangles);
-
-}
+struct PrimitiveTopology;
 
 struct PrimitiveObject : IObjectClone<PrimitiveObject> {
     AttrVector<vec3f> verts;
@@ -143,6 +34,17 @@ struct PrimitiveObject : IObjectClone<PrimitiveObject> {
     std::shared_ptr<MaterialObject> mtl;
     std::shared_ptr<InstancingObject> inst;
 
+    // adjacency cache owned by primTopology, see PrimitiveTopology::sourceKey
+    std::shared_ptr<PrimitiveTopology const> topologyCache() const {
+        return std::atomic_load(&m_topologyCache);
+    }
+
+    // nodes that rewrite face indices in place, keeping the array sizes,
+    // must drop the cache with setTopologyCache(nullptr)
+    void setTopologyCache(std::shared_ptr<PrimitiveTopology const> topo) {
+        std::atomic_store(&m_topologyCache, std::move(topo));
+    }
+
     // deprecated:
     template <class Accept = std::variant<vec3f, float>, class F>
     void foreach_attr(F &&f) {
@@ -282,6 +184,9 @@ struct PrimitiveObject : IObjectClone<PrimitiveObject> {
         return verts.resize(size);
     }
     // end of deprecated
+
+private:
+    std::shared_ptr<PrimitiveTopology const> m_topologyCache;
 };
 
 } // namespace zeno
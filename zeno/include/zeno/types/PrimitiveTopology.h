@@ -0,0 +1,71 @@
+#pragma once
+
+#include <zeno/utils/vec.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace zeno {
+
+// connectivity of the faces of a primitive, built by primTopology and cached
+// on the primitive until its tris, quads, polys or loops are resized or
+// reallocated (in place rewrites must drop the cache, see PrimitiveObject).
+// faces are numbered tris first, then quads, then polys; the corners of face
+// f are faceVerts[faceBegin[f]] .. faceVerts[faceBegin[f + 1] - 1], and corner
+// h doubles as the half-edge going from faceVerts[h] to the next corner.
+// all the CSR tables below are sorted, so the result does not depend on the
+// number of threads used to build them.
+struct PrimitiveTopology {
+    // vertex count, then data pointer and size of tris, quads, polys and loops
+    // of the primitive this was built from
+    std::array<uintptr_t, 9> sourceKey{};
+    size_t numVerts = 0;
+
+    std::vector<int> faceBegin;
+    std::vector<int> faceVerts;
+    std::vector<int> cornerFace;
+
+    // faces around vertex v: vertFaces[vertFaceBegin[v]] .. vertFaces[vertFaceBegin[v + 1] - 1]
+    std::vector<int> vertFaceBegin;
+    std::vector<int> vertFaces;
+
+    // corners (half-edges) at vertex v, same layout as above
+    std::vector<int> vertCornerBegin;
+    std::vector<int> vertCorners;
+
+    // vertices sharing an edge with vertex v, same layout as above
+    std::vector<int> vertVertBegin;
+    std::vector<int> vertVerts;
+
+    // undirected edges, edges[e][0] < edges[e][1], sorted
+    std::vector<vec2i> edges;
+    // faces around edge e: edgeFaces[edgeFaceBegin[e]] .. edgeFaces[edgeFaceBegin[e + 1] - 1]
+    std::vector<int> edgeFaceBegin;
+    std::vector<int> edgeFaces;
+    // the undirected edge of each half-edge (corner)
+    std::vector<int> halfEdgeEdge;
+
+    size_t numFaces() const {
+        return faceBegin.size() - 1;
+    }
+
+    int faceSize(int f) const {
+        return faceBegin[f + 1] - faceBegin[f];
+    }
+
+    int nextCorner(int h) const {
+        int f = cornerFace[h];
+        return h + 1 == faceBegin[f + 1] ? faceBegin[f] : h + 1;
+    }
+
+    int prevCorner(int h) const {
+        int f = cornerFace[h];
+        return h == faceBegin[f] ? faceBegin[f + 1] - 1 : h - 1;
+    }
+
+    bool isBoundaryEdge(int e) const {
+        return edgeFaceBegin[e + 1] - edgeFaceBegin[e] == 1;
+    }
+};
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <zeno/utils/disable_copy.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace zeno {
+
+// read-ahead for frame based cache readers: while frame N cooks, frames
+// N+1..N+ahead are decoded on background threads into a buffer of at most
+// `ahead` frames; asking for a frame that isn't buffered (a scrub) cancels
+// whatever is still queued, so decode must be safe to call from any thread
+template <class T>
+struct FramePrefetcher : disable_copy {
+    using Ptr = std::shared_ptr<T>;
+
+    FramePrefetcher() = default;
+
+    ~FramePrefetcher() {
+        cancel();
+    }
+
+    template <class Decode>
+    Ptr fetch(int frame, int ahead, Decode const &decode) {
+        Ptr res;
+        if (auto it = pending.find(frame); it != pending.end()) {
+            auto fut = std::move(it->second);
+            pending.erase(it);
+            res = fut.get();
+        }
+        if (!res) {
+            retireAll();
+            res = decode(frame);
+        }
+
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->first <= frame || it->first > frame + ahead) {
+                retired.push_back(std::move(it->second));
+                it = pending.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        for (int f = frame + 1; f <= frame + ahead; f++) {
+            if (pending.count(f))
+                continue;
+            pending.emplace(f, std::async(std::launch::async, [f, decode, cancelled = cancelled] () -> Ptr {
+                if (cancelled->load(std::memory_order_relaxed))
+                    return nullptr;
+                return decode(f);
+            }));
+        }
+        reapRetired();
+        return res;
+    }
+
+    // drops every buffered frame and waits for the ones being decoded, must
+    // be called before anything the decoder reads from goes away
+    void cancel() {
+        retireAll();
+        for (auto &fut: retired)
+            fut.wait();
+        retired.clear();
+    }
+
+private:
+    void retireAll() {
+        cancelled->store(true, std::memory_order_relaxed);
+        cancelled = std::make_shared<std::atomic<bool>>(false);
+        for (auto &[f, fut]: pending)
+            retired.push_back(std::move(fut));
+        pending.clear();
+    }
+
+    void reapRetired() {
+        for (auto it = retired.begin(); it != retired.end();) {
+            if (it->wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                it = retired.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    std::map<int, std::future<Ptr>> pending;
+    std::vector<std::future<Ptr>> retired;
+    std::shared_ptr<std::atomic<bool>> cancelled = std::make_shared<std::atomic<bool>>(false);
+};
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <zeno/utils/api.h>
+#include <zeno/utils/disable_copy.h>
+#include <cstddef>
+#include <string>
+
+namespace zeno {
+
+// read-only memory mapping of a whole file, empty if it can't be opened
+struct MappedFile : disable_copy {
+    ZENO_API explicit MappedFile(std::string const &path);
+    ZENO_API ~MappedFile();
+
+    char const *data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    explicit operator bool() const { return m_data != nullptr; }
+
+private:
+    char const *m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+}
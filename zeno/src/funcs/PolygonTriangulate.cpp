@@ -0,0 +1,409 @@
+#include <zeno/funcs/PrimitiveUtils.h>
+#include <zeno/utils/vec.h>
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
+namespace zeno {
+namespace {
+
+struct Vec2d {
+    double x, y;
+};
+
+// > 0 if a, b, c turn counter-clockwise
+double turn(Vec2d a, Vec2d b, Vec2d c) {
+    return (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+}
+
+// monotone decomposition then stack triangulation of each monotone piece,
+// O(n log n) in the total number of vertices, see de Berg et al. ch. 3.
+// vertices are the concatenated rings, the first ring counter-clockwise
+// and the holes clockwise, triangles are counter-clockwise local indices.
+struct MonotoneTriangulator {
+    std::vector<Vec2d> p;
+    std::vector<int> next, prev;
+    std::vector<vec3i> tris;
+    std::vector<std::pair<int, int>> diagonals;
+    bool ok = true;
+    int cur = 0;
+
+    // the sweep goes from top to bottom, ties are broken by x, which is
+    // the same as turning the plane by an infinitesimal angle
+    bool above(int a, int b) const {
+        return p[a].y > p[b].y || (p[a].y == p[b].y && p[a].x < p[b].x);
+    }
+
+    // x of edge e (from e to next[e]) on the sweep line through cur
+    double xAt(int e) const {
+        Vec2d a = p[e], b = p[next[e]], v = p[cur];
+        if (a.y == b.y)
+            return std::clamp(v.x, std::min(a.x, b.x), std::max(a.x, b.x));
+        return a.x + (v.y - a.y) / (b.y - a.y) * (b.x - a.x);
+    }
+
+    struct EdgeLess {
+        MonotoneTriangulator const *self;
+        using is_transparent = void;
+
+        bool operator()(int a, int b) const {
+            double xa = self->xAt(a), xb = self->xAt(b);
+            return xa != xb ? xa < xb : a < b;
+        }
+        bool operator()(int a, double x) const {
+            return self->xAt(a) < x;
+        }
+        bool operator()(double x, int b) const {
+            return x < self->xAt(b);
+        }
+    };
+
+    void addTri(int a, int b, int c) {
+        if (turn(p[a], p[b], p[c]) < 0) std::swap(b, c);
+        tris.emplace_back(a, b, c);
+    }
+
+    void split() {
+        int n = p.size();
+        std::vector<int> events(n);
+        for (int i = 0; i < n; i++) events[i] = i;
+        std::sort(events.begin(), events.end(), [&] (int a, int b) { return above(a, b); });
+
+        std::set<int, EdgeLess> status(EdgeLess{this});
+        std::vector<std::set<int, EdgeLess>::iterator> where(n, status.end());
+        std::vector<int> helper(n, -1);
+        std::vector<char> isMerge(n, 0);
+
+        auto insert = [&] (int e, int h) {
+            where[e] = status.insert(e).first;
+            helper[e] = h;
+        };
+        auto erase = [&] (int e) {
+            if (where[e] == status.end()) {
+                ok = false;
+                return;
+            }
+            status.erase(where[e]);
+            where[e] = status.end();
+        };
+        auto connectMergeHelper = [&] (int e, int v) {
+            if (e >= 0 && helper[e] >= 0 && isMerge[helper[e]])
+                diagonals.emplace_back(v, helper[e]);
+        };
+        auto leftEdge = [&] (int v) {
+            auto it = status.lower_bound(p[v].x);
+            if (it == status.begin()) {
+                ok = false;
+                return -1;
+            }
+            return *std::prev(it);
+        };
+
+        for (int v: events) {
+            if (!ok) return;
+            cur = v;
+            int pv = prev[v], nv = next[v];
+            bool prevBelow = above(v, pv), nextBelow = above(v, nv);
+            bool convex = turn(p[pv], p[v], p[nv]) > 0;
+            if (prevBelow && nextBelow) {
+                if (convex) {
+                    // start vertex
+                    insert(v, v);
+                } else {
+                    // split vertex
+                    int ej = leftEdge(v);
+                    if (ej < 0) return;
+                    diagonals.emplace_back(v, helper[ej]);
+                    helper[ej] = v;
+                    insert(v, v);
+                }
+            } else if (!prevBelow && !nextBelow) {
+                if (convex) {
+                    // end vertex
+                    connectMergeHelper(pv, v);
+                    erase(pv);
+                } else {
+                    // merge vertex
+                    isMerge[v] = 1;
+                    connectMergeHelper(pv, v);
+                    erase(pv);
+                    int ej = leftEdge(v);
+                    if (ej < 0) return;
+                    connectMergeHelper(ej, v);
+                    helper[ej] = v;
+                }
+            } else if (!prevBelow) {
+                // regular vertex with the interior on its right
+                connectMergeHelper(pv, v);
+                erase(pv);
+                insert(v, v);
+            } else {
+                // regular vertex with the interior on its left
+                int ej = leftEdge(v);
+                if (ej < 0) return;
+                connectMergeHelper(ej, v);
+                helper[ej] = v;
+            }
+        }
+    }
+
+    void triangulateMonotone(std::vector<int> const &face) {
+        int k = face.size();
+        if (k < 3) return;
+        if (k == 3) {
+            addTri(face[0], face[1], face[2]);
+            return;
+        }
+        int top = 0, bottom = 0;
+        for (int i = 1; i < k; i++) {
+            if (above(face[i], face[top])) top = i;
+            if (above(face[bottom], face[i])) bottom = i;
+        }
+        // going counter-clockwise from the top walks down the left chain
+        std::vector<char> onLeft(p.size());
+        for (int i = top; i != bottom; i = (i + 1) % k) onLeft[face[i]] = 1;
+        std::vector<int> u(face);
+        std::sort(u.begin(), u.end(), [&] (int a, int b) { return above(a, b); });
+
+        std::vector<int> stack{u[0], u[1]};
+        for (int j = 2; j < k - 1; j++) {
+            if (onLeft[u[j]] != onLeft[stack.back()]) {
+                for (size_t s = 0; s + 1 < stack.size(); s++) {
+                    addTri(u[j], stack[s], stack[s + 1]);
+                }
+                int last = stack.back();
+                stack = {last, u[j]};
+            } else {
+                int last = stack.back();
+                stack.pop_back();
+                while (!stack.empty()) {
+                    int top = stack.back();
+                    double t = onLeft[u[j]] ? turn(p[top], p[last], p[u[j]]) : turn(p[u[j]], p[last], p[top]);
+                    if (t <= 0) break;
+                    addTri(u[j], last, top);
+                    last = top;
+                    stack.pop_back();
+                }
+                stack.push_back(last);
+                stack.push_back(u[j]);
+            }
+        }
+        for (size_t s = 0; s + 1 < stack.size(); s++) {
+            addTri(u[k - 1], stack[s], stack[s + 1]);
+        }
+    }
+
+    // walks the faces cut out by the diagonals, each is y-monotone
+    void triangulatePieces() {
+        int n = p.size();
+        std::vector<std::vector<int>> nbr(n);
+        for (int v = 0; v < n; v++) {
+            nbr[v].push_back(next[v]);
+            nbr[v].push_back(prev[v]);
+        }
+        for (auto [a, b]: diagonals) {
+            nbr[a].push_back(b);
+            nbr[b].push_back(a);
+        }
+        for (int v = 0; v < n; v++) {
+            auto &nb = nbr[v];
+            std::sort(nb.begin(), nb.end(), [&] (int a, int b) {
+                return std::atan2(p[a].y - p[v].y, p[a].x - p[v].x) < std::atan2(p[b].y - p[v].y, p[b].x - p[v].x);
+            });
+            nb.erase(std::unique(nb.begin(), nb.end()), nb.end());
+        }
+        auto slotOf = [&] (int v, int w) {
+            return int(std::find(nbr[v].begin(), nbr[v].end(), w) - nbr[v].begin());
+        };
+
+        std::vector<std::vector<char>> visited(n);
+        for (int v = 0; v < n; v++) visited[v].assign(nbr[v].size(), 0);
+        // the reversed ring edges bound the outside, never walk them
+        for (int v = 0; v < n; v++) visited[v][slotOf(v, prev[v])] = 1;
+
+        std::vector<int> face;
+        for (int v = 0; v < n && ok; v++) {
+            for (int s = 0; s < (int)nbr[v].size() && ok; s++) {
+                if (visited[v][s]) continue;
+                face.clear();
+                int a = v, sa = s;
+                while (!visited[a][sa]) {
+                    visited[a][sa] = 1;
+                    face.push_back(a);
+                    int b = nbr[a][sa];
+                    // next edge is the one right before a, clockwise around b
+                    int sb = slotOf(b, a);
+                    sb = (sb + (int)nbr[b].size() - 1) % (int)nbr[b].size();
+                    a = b;
+                    sa = sb;
+                    if (face.size() > p.size()) {
+                        ok = false;
+                        return;
+                    }
+                }
+                triangulateMonotone(face);
+            }
+        }
+    }
+};
+
+// O(n^2) ear clipping, only used when the sweep gives up on degenerate input
+void earClip(std::vector<Vec2d> const &p, std::vector<vec3i> &tris) {
+    int n = p.size();
+    std::vector<int> next(n), prev(n);
+    for (int i = 0; i < n; i++) {
+        next[i] = (i + 1) % n;
+        prev[i] = (i + n - 1) % n;
+    }
+    auto inside = [&] (Vec2d a, Vec2d b, Vec2d c, Vec2d q) {
+        return turn(a, b, q) >= 0 && turn(b, c, q) >= 0 && turn(c, a, q) >= 0;
+    };
+    int v = 0;
+    for (int remain = n, misses = 0; remain > 3;) {
+        int a = prev[v], c = next[v];
+        bool ear = turn(p[a], p[v], p[c]) > 0;
+        for (int q = next[c]; ear && q != a; q = next[q]) {
+            if (inside(p[a], p[v], p[c], p[q])) ear = false;
+        }
+        if (ear || misses > remain) {
+            tris.emplace_back(a, v, c);
+            next[a] = c;
+            prev[c] = a;
+            remain--;
+            misses = 0;
+            v = c;
+        } else {
+            misses++;
+            v = next[v];
+        }
+    }
+    tris.emplace_back(prev[v], v, next[v]);
+}
+
+// projects the rings on the plane of the first one, which becomes counter-clockwise
+template <class GetPos>
+bool projectRings(GetPos const &getPos, std::vector<int> const &ringBegin, std::vector<Vec2d> &p) {
+    vec3f nrm(0);
+    for (int i = ringBegin[0]; i < ringBegin[1]; i++) {
+        int j = i + 1 == ringBegin[1] ? ringBegin[0] : i + 1;
+        auto a = getPos(i), b = getPos(j);
+        nrm += vec3f((a[1] - b[1]) * (a[2] + b[2]), (a[2] - b[2]) * (a[0] + b[0]), (a[0] - b[0]) * (a[1] + b[1]));
+    }
+    if (lengthSquared(nrm) == 0) return false;
+    nrm = normalize(nrm);
+    vec3f uaxis = std::abs(nrm[0]) < 0.9f ? vec3f(1, 0, 0) : vec3f(0, 1, 0);
+    uaxis = normalize(cross(uaxis, nrm));
+    vec3f vaxis = cross(nrm, uaxis);
+    p.resize(ringBegin.back());
+    for (int i = 0; i < ringBegin.back(); i++) {
+        auto a = getPos(i);
+        p[i] = {(double)dot(a, uaxis), (double)dot(a, vaxis)};
+    }
+    return true;
+}
+
+// triangulates rings given as ranges of the concatenated points, returns corner triples
+void triangulateRings(std::vector<Vec2d> const &p, std::vector<int> const &ringBegin, std::vector<vec3i> &tris) {
+    int nrings = ringBegin.size() - 1;
+    int n = ringBegin.back();
+    MonotoneTriangulator mt;
+    mt.p = p;
+    mt.next.resize(n);
+    mt.prev.resize(n);
+    for (int r = 0; r < nrings; r++) {
+        int b = ringBegin[r], e = ringBegin[r + 1];
+        double area = 0;
+        for (int i = b; i < e; i++) {
+            int j = i + 1 == e ? b : i + 1;
+            area += p[i].x * p[j].y - p[j].x * p[i].y;
+        }
+        // outer ring counter-clockwise, holes clockwise
+        bool reverse = r == 0 ? area < 0 : area > 0;
+        for (int i = b; i < e; i++) {
+            int j = i + 1 == e ? b : i + 1;
+            if (reverse) std::swap(i, j);
+            mt.next[i] = j;
+            mt.prev[j] = i;
+            if (reverse) std::swap(i, j);
+        }
+    }
+    int expected = n - 2 + 2 * (nrings - 1);
+    bool valid = n >= 3;
+    for (int r = 0; r < nrings; r++) {
+        if (ringBegin[r + 1] - ringBegin[r] < 3) valid = false;
+    }
+    if (valid) {
+        mt.split();
+        if (mt.ok) mt.triangulatePieces();
+        valid = mt.ok && (int)mt.tris.size() == expected;
+    }
+    if (valid) {
+        tris.insert(tris.end(), mt.tris.begin(), mt.tris.end());
+        return;
+    }
+    // degenerate input, clip the outer ring alone
+    int outer = ringBegin[1];
+    if (outer < 3) return;
+    std::vector<Vec2d> q(outer);
+    std::vector<int> order(outer);
+    for (int i = 0, v = 0; i < outer; i++, v = mt.next[v]) {
+        order[i] = v;
+        q[i] = p[v];
+    }
+    std::vector<vec3i> local;
+    earClip(q, local);
+    for (auto t: local) {
+        tris.emplace_back(order[t[0]], order[t[1]], order[t[2]]);
+    }
+}
+
+}
+
+ZENO_API void polygonTriangulate(vec3f const *verts, int const *loop, int len, std::vector<vec3i> &triangles) {
+    triangles.clear();
+    if (len < 3) return;
+    // convex polygons keep the fan, which is what every other path produces
+    // scratch reused across calls, the callers run one polygon per task
+    static thread_local std::vector<Vec2d> p;
+    static thread_local std::vector<int> ringBegin;
+    ringBegin.assign({0, len});
+    bool planar = projectRings([&] (int i) { return verts[loop[i]]; }, ringBegin, p);
+    // a loop with no area has nothing to project on, the fan is as good as anything
+    bool convex = true;
+    for (int i = 0; i < len && planar && convex; i++) {
+        if (turn(p[(i + len - 1) % len], p[i], p[(i + 1) % len]) < 0) convex = false;
+    }
+    if (convex || len == 3) {
+        for (int j = 2; j < len; j++) triangles.emplace_back(0, j - 1, j);
+        return;
+    }
+    triangulateRings(p, ringBegin, triangles);
+    if (triangles.size() != len - 2) {
+        triangles.clear();
+        for (int j = 2; j < len; j++) triangles.emplace_back(0, j - 1, j);
+    }
+}
+
+ZENO_API void polygonTriangulate(std::vector<vec3f> const &verts, std::vector<std::vector<int>> const &rings, std::vector<vec3i> &triangles) {
+    triangles.clear();
+    if (rings.empty()) return;
+    std::vector<int> ringBegin{0}, ids;
+    for (auto const &ring: rings) {
+        ids.insert(ids.end(), ring.begin(), ring.end());
+        ringBegin.push_back(ids.size());
+    }
+    std::vector<Vec2d> p;
+    if (!projectRings([&] (int i) { return verts[ids[i]]; }, ringBegin, p)) return;
+    std::vector<vec3i> local;
+    triangulateRings(p, ringBegin, local);
+    for (auto t: local) {
+        triangles.emplace_back(ids[t[0]], ids[t[1]], ids[t[2]]);
+    }
+}
+
+ZENO_API void polygonDecompose(std::vector<vec3f> const &verts, std::vector<int> const &poly, std::vector<vec3i> &triangles) {
+    polygonTriangulate(verts, {poly}, triangles);
+}
+
+}
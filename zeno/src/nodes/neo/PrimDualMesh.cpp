@@ -88,6 +88,76 @@ static void prim_foreach_faces_edges(PrimitiveObject *prim, Func const &each_fac
     }
 }*/
 
+// the dual face of vertex vid: the centers of the polys around it, walked
+// from one poly to the next across their shared edges
+static void dualFaceOfVertex(PrimitiveObject const *prim, PrimitiveTopology const &topo,
+                             int nonPolys, int vid, PrimitiveObject *outprim) {
+    std::vector<int> faceids;
+    for (int i = topo.vertFaceBegin[vid]; i < topo.vertFaceBegin[vid + 1]; i++) {
+        if (topo.vertFaces[i] >= nonPolys)
+            faceids.push_back(topo.vertFaces[i] - nonPolys);
+    }
+    if (faceids.empty()) return;
+    int loopbase = outprim->loops.size();
+    std::map<int, std::vector<int>> lut;
+    std::map<int, int> vid2f;
+    for (int ff = 0; ff < faceids.size(); ff++) {
+        int f = faceids[ff];
+        auto [start, len] = prim->polys[f];
+        if (len < 2) {
+            log_warn("polygon has {} edges < 2", len);
+            return;
+        }
+        int resl = -1;
+        for (int l = 0; l < len; l++) {
+            if (prim->loops[start + l] == vid) {
+                resl = l;
+                break;
+            }
+        }
+        if (resl == -1) {
+            log_warn("cannot find vertex {} in face {}", vid, f);
+            return;
+        }
+        auto vnext = prim->loops[start + (resl + 1) % len];
+        auto vprev = prim->loops[start + (resl - 1 + len) % len];
+        lut[vnext].push_back(vprev);
+        if (vnext != vprev)
+            lut[vprev].push_back(vnext);
+        vid2f.emplace(vnext, f);
+    }
+    //ZENO_P(lut);
+
+    std::set<int> visited;
+    auto dfs = [&] (auto &dfs, int vv0) -> void {
+        if (visited.count(vv0)) return;
+        visited.insert(vv0);
+        auto vid2fit = vid2f.find(vv0);
+        if (vid2fit == vid2f.end()) return;
+        auto f0 = vid2fit->second;
+        //ZENO_P(f0);
+        outprim->loops.push_back(f0);
+        auto lutit = lut.find(vv0);
+        if (lutit == lut.end()) {
+            log_warn("lut lookup failed at {}", vv0);
+            return;
+        }
+        auto const &ffs = lutit->second;
+        if (ffs.size() < 2) return;
+        if (ffs.size() > 2) {
+            log_warn("edge shared by {} faces > 2", ffs.size());
+            return;
+        }
+        int vv1 = ffs[0];
+        int vv2 = ffs[1];
+        dfs(dfs, vv1);
+        dfs(dfs, vv2);
+    };
+    dfs(dfs, lut.begin()->first);
+
+    outprim->polys.emplace_back(loopbase, outprim->loops.size() - loopbase);
+}
+
 struct PrimDualMesh : INode {
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
@@ -104,35 +174,19 @@ struct PrimDualMesh : INode {
 
         scope_exit<> revertoldpolysize;
         if (keepBounds) {
-            std::map<std::pair<int, int>, int> bounde2f;
-            {
-                std::vector<std::pair<int, int>> notbound;
-                for (int f = 0; f < prim->polys.size(); f++) {
-                    auto each_edge = [&] (int v1, int v2) {
-                        std::pair<int, int> key(std::min(v1, v2), std::max(v1, v2));
-                        auto [it, succ] = bounde2f.try_emplace(key, f);
-                        if (!succ) {
-                            notbound.push_back(key);
-                            it->second = -1;
-                        }
-                    };
-                    auto [start, len] = prim->polys[f];
-                    if (len >= 1) {
-                        for (int l = start; l < start + len - 1; l++) {
-                            each_edge(prim->loops[l], prim->loops[l + 1]);
-                        }
-                        each_edge(prim->loops[start + len - 1], prim->loops[start]);
-                    }
-                }
-                for (auto const &nbk: notbound)
-                    bounde2f.erase(nbk);
-            }
+            auto topo = primTopology(prim.get());
+            // the dual is made of the polys only, so are its bounds
+            int nonPolys = prim->tris.size() + prim->quads.size();
             auto oldpolysize = prim->polys.size();
             revertoldpolysize = scope_exit<>([prim, oldpolysize] {
                 prim->polys.resize(oldpolysize);
             });
-            for (auto const &[ev, f]: bounde2f) {
-                auto [v1, v2] = ev;
+            for (int e = 0; e < topo->edges.size(); e++) {
+                int polyUses = 0;
+                for (int i = topo->edgeFaceBegin[e]; i < topo->edgeFaceBegin[e + 1]; i++)
+                    polyUses += topo->edgeFaces[i] >= nonPolys;
+                if (polyUses != 1) continue;
+                auto [v1, v2] = topo->edges[e];
                 int loopbase = prim->loops.size();
                 prim->loops.push_back(v1);
                 prim->loops.push_back(v2);
@@ -140,7 +194,6 @@ struct PrimDualMesh : INode {
             }
         }
 
-        std::map<int, std::vector<int>> v2f;
         outprim->verts.resize(prim->polys.size());
         for (int f = 0; f < prim->polys.size(); f++) {
             meth_average<vec3f> reducer;
@@ -148,72 +201,14 @@ struct PrimDualMesh : INode {
             for (int l = start; l < start + len; l++) {
                 int v = prim->loops[l];
                 reducer.add(prim->verts[v]);
-                v2f[v].push_back(f);
             }
             outprim->verts[f] = reducer.get();
         }
 
-        std::for_each(v2f.begin(), v2f.end(), [&] (auto const &v2fent) {
-            auto const &[vid, faceids] = v2fent;
-            int loopbase = outprim->loops.size();
-            std::map<int, std::vector<int>> lut;
-            std::map<int, int> vid2f;
-            for (int ff = 0; ff < faceids.size(); ff++) {
-                int f = faceids[ff];
-                auto [start, len] = prim->polys[f];
-                if (len < 2) {
-                    log_warn("polygon has {} edges < 2", len);
-                    return;
-                }
-                int resl = -1;
-                for (int l = 0; l < len; l++) {
-                    if (prim->loops[start + l] == vid) {
-                        resl = l;
-                        break;
-                    }
-                }
-                if (resl == -1) {
-                    log_warn("cannot find vertex {} in face {}", vid, f);
-                    return;
-                }
-                auto vnext = prim->loops[start + (resl + 1) % len];
-                auto vprev = prim->loops[start + (resl - 1 + len) % len];
-                lut[vnext].push_back(vprev);
-                if (vnext != vprev)
-                    lut[vprev].push_back(vnext);
-                vid2f.emplace(vnext, f);
-            }
-            //ZENO_P(lut);
-
-            std::set<int> visited;
-            auto dfs = [&] (auto &dfs, int vv0) -> void {
-                if (visited.count(vv0)) return;
-                visited.insert(vv0);
-                auto vid2fit = vid2f.find(vv0);
-                if (vid2fit == vid2f.end()) return;
-                auto f0 = vid2fit->second;
-                //ZENO_P(f0);
-                outprim->loops.push_back(f0);
-                auto lutit = lut.find(vv0);
-                if (lutit == lut.end()) {
-                    log_warn("lut lookup failed at {}", vv0);
-                    return;
-                }
-                auto const &ffs = lutit->second;
-                if (ffs.size() < 2) return;
-                if (ffs.size() > 2) {
-                    log_warn("edge shared by {} faces > 2", ffs.size());
-                    return;
-                }
-                int vv1 = ffs[0];
-                int vv2 = ffs[1];
-                dfs(dfs, vv1);
-                dfs(dfs, vv2);
-            };
-            dfs(dfs, lut.begin()->first);
-
-            outprim->polys.emplace_back(loopbase, outprim->loops.size() - loopbase);
-        });
+        auto topo = primTopology(prim.get());
+        int nonPolys = prim->tris.size() + prim->quads.size();
+        for (int vid = 0; vid < topo->numVerts; vid++)
+            dualFaceOfVertex(prim.get(), *topo, nonPolys, vid, outprim.get());
 
         set_output("prim", std::move(outprim));
     }
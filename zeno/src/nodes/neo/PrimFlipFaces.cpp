@@ -42,6 +42,7 @@ ZENO_API void primFlipFaces(PrimitiveObject *prim, bool only_face) {
             });
         });
     }
+    prim->setTopologyCache(nullptr);
 }
 
 struct PrimFlipFaces : zeno::INode {
@@ -3,60 +3,66 @@
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/NumericObject.h>
-#include <zeno/utils/tuple_hash.h>
-#include <unordered_map>
+#include <zeno/types/GenericObject.h>
+#include <zeno/types/UserData.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/union_find.h>
+#include <atomic>
 
 namespace zeno {
 
 ZENO_API void primMarkIsland(PrimitiveObject *prim, std::string tagAttr) {
-    // Oh, I mean, Tesla was a great DJ
     auto &tagVert = prim->add_attr<int>(tagAttr);
     auto m = tagVert.size();
-    std::vector<int> found(m);
-    for (int i = 0; i < m; i++) {
-        found[i] = i;
-    }
-    auto find = [&] (int i) {
-        while (i != found[i])
-            i = found[i];
-        return i;
-    };
-    for (int i = 0; i < prim->lines.size(); i++) {
+    ConcurrentUnionFind uf(m);
+
+    parallel_for(prim->lines.size(), [&] (size_t i) {
         auto ind = prim->lines[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        found[e1] = e0;
-    }
-    for (int i = 0; i < prim->tris.size(); i++) {
+        uf.unite(ind[0], ind[1]);
+    });
+    parallel_for(prim->tris.size(), [&] (size_t i) {
         auto ind = prim->tris[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        int e2 = find(ind[2]);
-        found[e1] = e0;
-        found[e2] = e0;
-    }
-    for (int i = 0; i < prim->quads.size(); i++) {
+        uf.unite(ind[0], ind[1]);
+        uf.unite(ind[0], ind[2]);
+    });
+    parallel_for(prim->quads.size(), [&] (size_t i) {
         auto ind = prim->quads[i];
-        int e0 = find(ind[0]);
-        int e1 = find(ind[1]);
-        int e2 = find(ind[2]);
-        int e3 = find(ind[3]);
-        found[e1] = e0;
-        found[e2] = e0;
-        found[e3] = e0;
-    }
-    for (int i = 0; i < prim->polys.size(); i++) {
+        uf.unite(ind[0], ind[1]);
+        uf.unite(ind[0], ind[2]);
+        uf.unite(ind[0], ind[3]);
+    });
+    parallel_for(prim->polys.size(), [&] (size_t i) {
         auto [base, len] = prim->polys[i];
-        if (len <= 1) continue;
-        int e0 = find(prim->loops[base]);
         for (int j = base + 1; j < base + len; j++) {
-            int ej = find(prim->loops[j]);
-            found[ej] = e0;
+            uf.unite(prim->loops[base], prim->loops[j]);
         }
-    }
-    for (int i = 0; i < m; i++) {
-        tagVert[i] = find(i);
-    }
+    });
+
+    // dense island ids, numbered by their smallest vertex
+    std::vector<int> root(m);
+    parallel_for(m, [&] (size_t i) {
+        root[i] = uf.find(i);
+    });
+    std::vector<int> islandId(m);
+    int count = parallel_exclusive_scan_sum(counter_iterator<size_t>(0), counter_iterator<size_t>(m), islandId.begin(), [&] (size_t i) {
+        return int(root[i] == i);
+    });
+    std::vector<std::atomic<int>> sizes(count);
+    parallel_for(m, [&] (size_t i) {
+        int id = islandId[root[i]];
+        tagVert[i] = id;
+        sizes[id].fetch_add(1, std::memory_order_relaxed);
+    });
+
+    // vertex count of each island, read back with
+    // userData().get<GenericObject<std::vector<int>>>(tagAttr + "_sizes")
+    auto sizeArr = std::make_shared<GenericObject<std::vector<int>>>(std::vector<int>(count));
+    parallel_for(count, [&] (size_t i) {
+        sizeArr->value[i] = sizes[i].load(std::memory_order_relaxed);
+    });
+    prim->userData().set2(tagAttr + "_count", count);
+    prim->userData().set(tagAttr + "_sizes", std::move(sizeArr));
 }
 
 namespace {
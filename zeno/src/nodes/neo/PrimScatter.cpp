@@ -5,13 +5,14 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/para/parallel_for.h>
 #include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_sort.h>
 #define ZENO_NOTICKTOCK
 #include <zeno/utils/ticktock.h>
 #include <zeno/utils/variantswitch.h>
 #include <zeno/utils/wangsrng.h>
-#include <zeno/utils/tuple_hash.h>
 #include <zeno/utils/log.h>
-#include <unordered_map>
+#include <algorithm>
+#include <numeric>
 #include <random>
 #include <cmath>
 #ifndef M_PI
@@ -23,58 +24,98 @@ namespace zeno {
 template <class T>
 static void revamp_vector(std::vector<T> &arr, std::vector<int> const &revamp) {
     std::vector<T> newarr(arr.size());
-    for (int i = 0; i < revamp.size(); i++) {
+    parallel_for(revamp.size(), [&] (size_t i) {
         newarr[i] = arr[revamp[i]];
-    }
+    });
     std::swap(arr, newarr);
 }
 
+// dart throwing on a flat grid of minRadius sized cells: cells are visited in
+// 27 phases, the cells of one phase are at least 3 cells apart so they never
+// look at each others points, and can be decided in parallel; within a cell,
+// points are accepted in order if no accepted point is closer than minRadius
 static void primPossionFilter(PrimitiveObject *prim, float minRadius) {
     if (minRadius <= 0) return;
 
     TICK(possion);
     float invRadius = 1.f / minRadius;
-    std::unordered_map<vec3i, std::vector<int>, tuple_hash, tuple_equal> lut;
-    for (int i = 0; i < prim->verts.size(); i++) {
-        vec3i ipos(prim->verts[i] * invRadius);
-        lut[ipos].push_back(i);
+    size_t n = prim->verts.size();
+    std::vector<vec3i> cell(n);
+    parallel_for(n, [&] (size_t i) {
+        cell[i] = ifloor(prim->verts[i] * invRadius);
+    });
+    auto cellLess = [] (vec3i const &a, vec3i const &b) {
+        return a[0] != b[0] ? a[0] < b[0] : a[1] != b[1] ? a[1] < b[1] : a[2] < b[2];
+    };
+    auto cellEqual = [] (vec3i const &a, vec3i const &b) {
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+    };
+
+    // points sorted by cell, ucell[c] holds order[cellBegin[c]] .. order[cellBegin[c + 1] - 1]
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    parallel_sort(order.begin(), order.end(), [&] (int a, int b) {
+        return cellEqual(cell[a], cell[b]) ? a < b : cellLess(cell[a], cell[b]);
+    });
+    std::vector<vec3i> ucell;
+    std::vector<int> cellBegin;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || !cellEqual(cell[order[i]], cell[order[i - 1]])) {
+            ucell.push_back(cell[order[i]]);
+            cellBegin.push_back(i);
+        }
     }
+    cellBegin.push_back(n);
 
-    std::vector<uint8_t> erased(prim->verts.size());
-    for (int i = 0; i < prim->verts.size(); i++) {
-        if (erased[i])
-            continue;
-        vec3i ipos(prim->verts[i] * invRadius);
-        erased[i] = [&] {
+    std::vector<std::vector<int>> phaseCells(27);
+    for (size_t c = 0; c < ucell.size(); c++) {
+        auto m = ucell[c];
+        int phase = ((m[0] % 3 + 3) % 3) * 9 + ((m[1] % 3 + 3) % 3) * 3 + (m[2] % 3 + 3) % 3;
+        phaseCells[phase].push_back(c);
+    }
+
+    std::vector<uint8_t> accepted(n);
+    for (auto const &cells: phaseCells) {
+        parallel_for(cells.size(), [&] (size_t k) {
+            int c = cells[k];
+            int nbBegin[27], nbEnd[27], nnb = 0;
             for (int dz = -1; dz <= 1; dz++) {
                 for (int dy = -1; dy <= 1; dy++) {
                     for (int dx = -1; dx <= 1; dx++) {
-                        auto it = lut.find(ipos + vec3i(dx, dy, dz));
-                        if (it != lut.end()) {
-                            for (int j: it->second) {
-                                if (j == i || erased[j])
-                                    continue;
-                                auto dis = prim->verts[i] - prim->verts[j];
-                                if (length(dis) < minRadius)
-                                    return true;
-                            }
-                        }
+                        vec3i nc = ucell[c] + vec3i(dx, dy, dz);
+                        auto it = std::lower_bound(ucell.begin(), ucell.end(), nc, cellLess);
+                        if (it == ucell.end() || !cellEqual(*it, nc)) continue;
+                        nbBegin[nnb] = cellBegin[it - ucell.begin()];
+                        nbEnd[nnb] = cellBegin[it - ucell.begin() + 1];
+                        nnb++;
                     }
                 }
             }
-            return false;
-        }();
+            for (int a = cellBegin[c]; a < cellBegin[c + 1]; a++) {
+                auto pa = prim->verts[order[a]];
+                accepted[order[a]] = [&] {
+                    for (int nb = 0; nb < nnb; nb++) {
+                        for (int b = nbBegin[nb]; b < nbEnd[nb]; b++) {
+                            if (accepted[order[b]] && length(pa - prim->verts[order[b]]) < minRadius)
+                                return false;
+                        }
+                    }
+                    return true;
+                }();
+            }
+        });
     }
 
-    std::vector<int> revamp(prim->verts.size());
-    int nrevamp = 0;
-    for (int i = 0; i < erased.size(); i++) {
-        if (!erased[i])
-            revamp[nrevamp++] = i;
-    }
-    revamp.resize(nrevamp);
+    std::vector<int> scan(n);
+    int nrevamp = parallel_exclusive_scan_sum(accepted.begin(), accepted.end(), scan.begin(), [] (uint8_t x) {
+        return int(x);
+    });
+    std::vector<int> revamp(nrevamp);
+    parallel_for(n, [&] (size_t i) {
+        if (accepted[i]) revamp[scan[i]] = i;
+    });
 
-    prim->verts.forall_attr([&] (auto const &key, auto &arr) {
+    prim->verts.forall_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
         revamp_vector(arr, revamp);
     });
     prim->verts.resize(nrevamp);
@@ -82,7 +123,7 @@ static void primPossionFilter(PrimitiveObject *prim, float minRadius) {
 }
 
 ZENO_API std::shared_ptr<PrimitiveObject> primScatter(
-    PrimitiveObject *prim, std::string type, std::string denAttr, float density, float minRadius, bool interpAttrs, int seed) {
+    PrimitiveObject *prim, std::string type, std::string denAttr, float density, float minRadius, bool interpAttrs, int seed, bool srcAttrs) {
     auto retprim = std::make_shared<PrimitiveObject>();
 
     if (seed == -1) seed = std::random_device{}();
@@ -137,66 +178,68 @@ ZENO_API std::shared_ptr<PrimitiveObject> primScatter(
     if (!prim->verts.num_attrs()) {
         interpAttrs = false;
     }
-    if (interpAttrs) {
-        prim->verts.foreach_attr([&] (auto const &key, auto const &arr) {
-            using T = std::decay_t<decltype(arr[0])>;
-            retprim->add_attr<T>(key);
-        });
-    }
-
-    if (type == "tris") {
-        parallel_for((size_t)0, (size_t)npoints, [&] (size_t i) {
-            wangsrng rng(seed, i);
-            auto val = rng.next_float();
-            auto it = std::lower_bound(cdf.begin(), cdf.end(), val);
-            size_t index = it - cdf.begin();
+    // the source vertices and weights of point i, drawn from its own random
+    // stream, so attribute interpolation recomputes them instead of storing
+    // them per point, unless srcAttrs asks to keep them as attributes
+    bool isTris = type == "tris";
+    auto sample = [&] (size_t i, vec3i &ind, vec3f &w) {
+        wangsrng rng(seed, i);
+        auto val = rng.next_float();
+        auto it = std::lower_bound(cdf.begin(), cdf.end(), val);
+        size_t index = it - cdf.begin();
+        if (isTris) {
             index = std::min(index, prim->tris.size() - 1);
-            auto const &ind = prim->tris[index];
-            auto a = prim->verts[ind[0]];
-            auto b = prim->verts[ind[1]];
-            auto c = prim->verts[ind[2]];
+            ind = prim->tris[index];
             auto r1 = std::sqrt(rng.next_float());
             auto r2 = rng.next_float();
-            auto w1 = 1 - r1;
-            auto w2 = r1 * (1 - r2);
-            auto w3 = r1 * r2;
-            auto p = w1 * a + w2 * b + w3 * c;
-            retprim->verts[i] = p;
-            if (interpAttrs) {
-                prim->verts.foreach_attr([&] (auto const &key, auto const &arr) {
-                    using T = std::decay_t<decltype(arr[0])>;
-                    auto &retarr = retprim->attr<T>(key);
-                    auto a = arr[ind[0]];
-                    auto b = arr[ind[1]];
-                    auto c = arr[ind[2]];
-                    auto p = w1 * a + w2 * b + w3 * c;
-                    retarr[i] = p;
-                });
-            }
-        });
-    } else if (type == "lines") {
-        parallel_for((size_t)0, (size_t)npoints, [&] (size_t i) {
-            wangsrng rng(seed, i);
-            auto val = rng.next_float();
-            auto it = std::lower_bound(cdf.begin(), cdf.end(), val);
-            size_t index = it - cdf.begin();
+            w = {1 - r1, r1 * (1 - r2), r1 * r2};
+        } else {
             index = std::min(index, prim->lines.size() - 1);
-            auto const &ind = prim->lines[index];
-            auto a = prim->verts[ind[0]];
-            auto b = prim->verts[ind[1]];
+            auto const &line = prim->lines[index];
+            ind = {line[0], line[1], line[1]};
             auto r1 = rng.next_float();
-            auto p = a * (1 - r1) + b * r1;
-            retprim->verts[i] = p;
-            if (interpAttrs) {
-                prim->verts.foreach_attr([&] (auto const &key, auto const &arr) {
-                    using T = std::decay_t<decltype(arr[0])>;
-                    auto &retarr = retprim->attr<T>(key);
-                    auto a = arr[ind[0]];
-                    auto b = arr[ind[1]];
-                    auto p = a * (1 - r1) + b * r1;
-                    retarr[i] = p;
-                });
-            }
+            w = {1 - r1, r1, 0};
+        }
+    };
+
+    vec3i *srcInd = srcAttrs ? retprim->verts.add_attr<vec3i>("srcInd").data() : nullptr;
+    vec3f *srcWeight = srcAttrs ? retprim->verts.add_attr<vec3f>("srcWeight").data() : nullptr;
+    parallel_for((size_t)0, (size_t)npoints, [&] (size_t i) {
+        vec3i ind;
+        vec3f w;
+        sample(i, ind, w);
+        auto a = prim->verts[ind[0]];
+        auto b = prim->verts[ind[1]];
+        if (isTris) {
+            auto c = prim->verts[ind[2]];
+            retprim->verts[i] = w[0] * a + w[1] * b + w[2] * c;
+        } else {
+            retprim->verts[i] = a * w[0] + b * w[1];
+        }
+        if (srcAttrs) {
+            srcInd[i] = ind;
+            srcWeight[i] = w;
+        }
+    });
+
+    if (interpAttrs) {
+        prim->verts.foreach_attr([&] (auto const &key, auto const &arr) {
+            using T = std::decay_t<decltype(arr[0])>;
+            auto &retarr = retprim->add_attr<T>(key);
+            parallel_for((size_t)0, (size_t)npoints, [&] (size_t i) {
+                vec3i ind;
+                vec3f w;
+                if (srcAttrs) {
+                    ind = srcInd[i];
+                    w = srcWeight[i];
+                } else {
+                    sample(i, ind, w);
+                }
+                if (isTris)
+                    retarr[i] = w[0] * arr[ind[0]] + w[1] * arr[ind[1]] + w[2] * arr[ind[2]];
+                else
+                    retarr[i] = arr[ind[0]] * w[0] + arr[ind[1]] * w[1];
+            });
         });
     }
 
@@ -217,7 +260,8 @@ struct PrimScatter : INode {
         auto minRadius = get_input2<float>("minRadius");
         auto interpAttrs = get_input2<bool>("interpAttrs");
         auto seed = get_input2<int>("seed");
-        auto retprim = primScatter(prim.get(), type, denAttr, density, minRadius, interpAttrs, seed);
+        auto srcAttrs = get_input2<bool>("srcAttrs");
+        auto retprim = primScatter(prim.get(), type, denAttr, density, minRadius, interpAttrs, seed, srcAttrs);
         set_output("parsPrim", retprim);
     }
 };
@@ -231,6 +275,7 @@ ZENO_DEFNODE(PrimScatter)({
         {"float", "minRadius", "0"},
         {"bool", "interpAttrs", "1"},
         {"int", "seed", "-1"},
+        {"bool", "srcAttrs", "0"},
     },
     {
         {"parsPrim"},
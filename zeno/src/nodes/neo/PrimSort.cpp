@@ -65,6 +65,7 @@ struct PrimSort : INode {
                 idx = reverse_indices[idx];
             }
         }
+        prim->setTopologyCache(nullptr);
         set_output("prim", std::move(prim));
     }
   }
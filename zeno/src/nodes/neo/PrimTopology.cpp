@@ -0,0 +1,184 @@
+#include <zeno/funcs/PrimitiveUtils.h>
+#include <zeno/types/PrimitiveObject.h>
+#include <zeno/types/PrimitiveTopology.h>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_sort.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace zeno {
+namespace {
+
+std::array<uintptr_t, 9> topologyKey(PrimitiveObject const *prim) {
+    return {
+        prim->verts.size(),
+        uintptr_t(prim->tris.values.data()), prim->tris.size(),
+        uintptr_t(prim->quads.values.data()), prim->quads.size(),
+        uintptr_t(prim->polys.values.data()), prim->polys.size(),
+        uintptr_t(prim->loops.values.data()), prim->loops.size(),
+    };
+}
+
+// counts[i] + 1 entries turned into CSR offsets, returns the total
+int countsToOffsets(std::vector<int> &offsets) {
+    std::vector<int> counts = std::move(offsets);
+    offsets.resize(counts.size() + 1);
+    int total = parallel_exclusive_scan_sum(counts.begin(), counts.end(), offsets.begin());
+    offsets.back() = total;
+    return total;
+}
+
+// CSR of the values grouped by key, each group sorted
+void buildCSR(size_t nkeys, size_t n, std::vector<int> &begin, std::vector<int> &values,
+              std::vector<int> const &keys, std::vector<int> const &vals) {
+    std::vector<std::atomic<int>> counts(nkeys);
+    parallel_for(n, [&] (size_t i) {
+        counts[keys[i]].fetch_add(1, std::memory_order_relaxed);
+    });
+    begin.resize(nkeys);
+    parallel_for(nkeys, [&] (size_t k) {
+        begin[k] = counts[k].load(std::memory_order_relaxed);
+    });
+    countsToOffsets(begin);
+    parallel_for(nkeys, [&] (size_t k) {
+        counts[k].store(begin[k], std::memory_order_relaxed);
+    });
+    values.resize(n);
+    parallel_for(n, [&] (size_t i) {
+        values[counts[keys[i]].fetch_add(1, std::memory_order_relaxed)] = vals[i];
+    });
+    parallel_for(nkeys, [&] (size_t k) {
+        std::sort(values.begin() + begin[k], values.begin() + begin[k + 1]);
+    });
+}
+
+std::shared_ptr<PrimitiveTopology> buildTopology(PrimitiveObject const *prim) {
+    auto topo = std::make_shared<PrimitiveTopology>();
+    topo->sourceKey = topologyKey(prim);
+    size_t nv = topo->numVerts = prim->verts.size();
+    size_t ntris = prim->tris.size(), nquads = prim->quads.size(), npolys = prim->polys.size();
+    size_t nf = ntris + nquads + npolys;
+
+    topo->faceBegin.resize(nf);
+    parallel_for(nf, [&] (size_t f) {
+        topo->faceBegin[f] = f < ntris ? 3 : f < ntris + nquads ? 4 : prim->polys[f - ntris - nquads][1];
+    });
+    size_t ncorners = countsToOffsets(topo->faceBegin);
+    topo->faceVerts.resize(ncorners);
+    topo->cornerFace.resize(ncorners);
+    parallel_for(nf, [&] (size_t f) {
+        int h = topo->faceBegin[f];
+        if (f < ntris) {
+            for (int j = 0; j < 3; j++) topo->faceVerts[h + j] = prim->tris[f][j];
+        } else if (f < ntris + nquads) {
+            for (int j = 0; j < 4; j++) topo->faceVerts[h + j] = prim->quads[f - ntris][j];
+        } else {
+            auto [base, len] = prim->polys[f - ntris - nquads];
+            for (int j = 0; j < len; j++) topo->faceVerts[h + j] = prim->loops[base + j];
+        }
+        std::fill(topo->cornerFace.begin() + h, topo->cornerFace.begin() + topo->faceBegin[f + 1], (int)f);
+    });
+
+    {
+        std::vector<int> cornerIds(ncorners);
+        parallel_for(ncorners, [&] (size_t h) {
+            cornerIds[h] = h;
+        });
+        buildCSR(nv, ncorners, topo->vertCornerBegin, topo->vertCorners, topo->faceVerts, cornerIds);
+    }
+    buildCSR(nv, ncorners, topo->vertFaceBegin, topo->vertFaces, topo->faceVerts, topo->cornerFace);
+    // a face touching a vertex twice is listed once
+    std::vector<int> uniqueCount(nv);
+    parallel_for(nv, [&] (size_t v) {
+        auto first = topo->vertFaces.begin() + topo->vertFaceBegin[v];
+        auto last = topo->vertFaces.begin() + topo->vertFaceBegin[v + 1];
+        uniqueCount[v] = std::unique(first, last) - first;
+    });
+    {
+        std::vector<int> oldBegin = std::move(topo->vertFaceBegin);
+        topo->vertFaceBegin = uniqueCount;
+        countsToOffsets(topo->vertFaceBegin);
+        std::vector<int> oldFaces = std::move(topo->vertFaces);
+        topo->vertFaces.resize(topo->vertFaceBegin[nv]);
+        parallel_for(nv, [&] (size_t v) {
+            std::copy_n(oldFaces.begin() + oldBegin[v], uniqueCount[v], topo->vertFaces.begin() + topo->vertFaceBegin[v]);
+        });
+    }
+
+    // undirected edges: sort the half-edges by their (min, max) vertex pair
+    std::vector<uint64_t> edgeKey(ncorners);
+    parallel_for(ncorners, [&] (size_t h) {
+        uint32_t a = topo->faceVerts[h], b = topo->faceVerts[topo->nextCorner(h)];
+        if (a > b) std::swap(a, b);
+        edgeKey[h] = uint64_t(a) << 32 | b;
+    });
+    std::vector<int> halfEdges(ncorners);
+    parallel_for(ncorners, [&] (size_t h) {
+        halfEdges[h] = h;
+    });
+    parallel_sort(halfEdges.begin(), halfEdges.end(), [&] (int x, int y) {
+        return edgeKey[x] != edgeKey[y] ? edgeKey[x] < edgeKey[y] : x < y;
+    });
+    std::vector<int> edgeOfSorted(ncorners);
+    int nedges = parallel_exclusive_scan_sum(counter_iterator<size_t>(0), counter_iterator<size_t>(ncorners), edgeOfSorted.begin(), [&] (size_t i) {
+        return int(i == 0 || edgeKey[halfEdges[i]] != edgeKey[halfEdges[i - 1]]);
+    });
+    topo->edges.resize(nedges);
+    topo->edgeFaceBegin.resize(nedges + 1);
+    topo->edgeFaces.resize(ncorners);
+    topo->halfEdgeEdge.resize(ncorners);
+    parallel_for(ncorners, [&] (size_t i) {
+        int h = halfEdges[i];
+        int e = i == 0 || edgeKey[h] != edgeKey[halfEdges[i - 1]] ? edgeOfSorted[i] : edgeOfSorted[i] - 1;
+        topo->halfEdgeEdge[h] = e;
+        topo->edgeFaces[i] = topo->cornerFace[h];
+        if (i == 0 || edgeKey[h] != edgeKey[halfEdges[i - 1]]) {
+            topo->edges[e] = vec2i(edgeKey[h] >> 32, edgeKey[h] & 0xffffffffu);
+            topo->edgeFaceBegin[e] = i;
+        }
+    });
+    topo->edgeFaceBegin[nedges] = ncorners;
+
+    // vertex neighbours from both ends of every edge, degenerate edges skipped
+    std::vector<int> ends(nedges * 2), others(nedges * 2);
+    parallel_for((size_t)nedges, [&] (size_t e) {
+        auto [a, b] = topo->edges[e];
+        ends[e * 2] = a;
+        others[e * 2] = b;
+        ends[e * 2 + 1] = b;
+        others[e * 2 + 1] = a;
+    });
+    buildCSR(nv, nedges * 2, topo->vertVertBegin, topo->vertVerts, ends, others);
+    {
+        std::vector<int> count(nv);
+        parallel_for(nv, [&] (size_t v) {
+            auto first = topo->vertVerts.begin() + topo->vertVertBegin[v];
+            auto last = topo->vertVerts.begin() + topo->vertVertBegin[v + 1];
+            count[v] = std::remove(first, last, (int)v) - first;
+        });
+        std::vector<int> oldBegin = std::move(topo->vertVertBegin);
+        topo->vertVertBegin = count;
+        countsToOffsets(topo->vertVertBegin);
+        std::vector<int> oldVerts = std::move(topo->vertVerts);
+        topo->vertVerts.resize(topo->vertVertBegin[nv]);
+        parallel_for(nv, [&] (size_t v) {
+            std::copy_n(oldVerts.begin() + oldBegin[v], count[v], topo->vertVerts.begin() + topo->vertVertBegin[v]);
+        });
+    }
+    return topo;
+}
+
+}
+
+ZENO_API std::shared_ptr<PrimitiveTopology const> primTopology(PrimitiveObject *prim) {
+    auto topo = prim->topologyCache();
+    if (topo && topo->sourceKey == topologyKey(prim))
+        return topo;
+    topo = buildTopology(prim);
+    prim->setTopologyCache(topo);
+    return topo;
+}
+
+}
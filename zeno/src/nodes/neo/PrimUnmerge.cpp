@@ -7,160 +7,376 @@
 #include <zeno/para/parallel_for.h>
 #include <zeno/types/UserData.h>
 #include "zeno/utils/log.h"
+#include <algorithm>
+#include <numeric>
 
 namespace zeno {
 
-ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr) {
-    if (!prim->verts.size()) return {};
-
-    auto const &tagArr = prim->verts.attr<int>(tagAttr);
-    int tagMax = parallel_reduce_max(tagArr.begin(), tagArr.end()) + 1;
+namespace {
 
-    std::vector<std::shared_ptr<PrimitiveObject>> primList(tagMax);
-    for (int tag = 0; tag < tagMax; tag++) {
-        primList[tag] = std::make_shared<PrimitiveObject>();
+// elements of one array grouped by tag and stored back to back, group t is
+// made of the source elements source[offset[t]] .. source[offset[t + 1] - 1]
+struct TagGather {
+    std::vector<int> offset;
+    std::vector<int> source;
+    std::vector<int> tag;
+
+    int ntags() const { return (int)offset.size() - 1; }
+    size_t size() const { return source.size(); }
+    int count(int t) const { return offset[t + 1] - offset[t]; }
+
+    void fill_tags() {
+        tag.resize(source.size());
+        parallel_for((size_t)ntags(), [&] (size_t t) {
+            std::fill(tag.begin() + offset[t], tag.begin() + offset[t + 1], (int)t);
+        });
     }
+};
 
-#if 1
-    std::vector<std::vector<int>> aux_arrays;
-    aux_arrays.resize(tagMax);
-    for (int tag = 0; tag < tagMax; tag++) {
-      aux_arrays[tag].resize(0);
+// stable counting sort of n elements by tagOf(i), elements tagged -1 are dropped
+template <class F>
+TagGather partitionByTag(size_t n, int ntags, F const &tagOf) {
+    std::vector<int> elemTag(n);
+    parallel_for(n, [&] (size_t i) {
+        elemTag[i] = tagOf(i);
+    });
+    TagGather g;
+    g.offset.assign(ntags + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        if (elemTag[i] >= 0) g.offset[elemTag[i] + 1]++;
     }
-    //auto const &tagArr = prim->verts.attr<int>(tagAttr);
-    for (int i = 0; i < prim->size(); i++) {
-      aux_arrays[tagArr[i]].emplace_back(i);
+    for (int t = 0; t < ntags; t++) {
+        g.offset[t + 1] += g.offset[t];
     }
-    for (int tag = 0; tag < tagMax; tag++) {
-        primList[tag]->assign(prim);
-        primFilterVerts(primList[tag].get(), tagAttr, tag, false, {}, "verts", aux_arrays[tag].data(), aux_arrays[tag].size(),true);
+    g.source.resize(g.offset[ntags]);
+    std::vector<int> cursor(g.offset.begin(), g.offset.end() - 1);
+    for (size_t i = 0; i < n; i++) {
+        if (elemTag[i] >= 0) g.source[cursor[elemTag[i]]++] = i;
     }
+    g.fill_tags();
+    return g;
+}
+
+// sorted unique keys of each tag, keys[offset[t]] .. keys[offset[t + 1] - 1] belong to tag t
+TagGather uniqueByTag(std::vector<int> const &offset, std::vector<int> keys) {
+    int ntags = (int)offset.size() - 1;
+    std::vector<int> counts(ntags);
+    parallel_for((size_t)ntags, [&] (size_t t) {
+        auto first = keys.begin() + offset[t], last = keys.begin() + offset[t + 1];
+        std::sort(first, last);
+        counts[t] = std::unique(first, last) - first;
+    });
+    TagGather g;
+    g.offset.assign(ntags + 1, 0);
+    for (int t = 0; t < ntags; t++) {
+        g.offset[t + 1] = g.offset[t] + counts[t];
+    }
+    g.source.resize(g.offset[ntags]);
+    parallel_for((size_t)ntags, [&] (size_t t) {
+        std::copy_n(keys.begin() + offset[t], counts[t], g.source.begin() + g.offset[t]);
+    });
+    g.fill_tags();
+    return g;
+}
 
-#else
-    std::vector<std::vector<int>> vert_revamp(tagMax);
-    std::vector<int> vert_unrevamp(prim->verts.size());
+// either one primitive per tag, or a single primitive holding all groups back to back
+struct UnmergeOutput {
+    std::vector<PrimitiveObject *> prims;
+    bool shared = false;
+    // group offsets of each array, what the ranges primitive is made of
+    std::vector<std::pair<std::string, std::vector<int>>> ranges;
 
-    for (size_t i = 0; i < prim->verts.size(); i++) {
-        int tag = tagArr[i];
-        vert_revamp[tag].push_back(i);
-        vert_unrevamp[i] = tag;
+    int base(TagGather const &g, int t) const {
+        return shared ? g.offset[t] : 0;
     }
+};
 
-    for (int tag = 0; tag < tagMax; tag++) {
-        auto &revamp = vert_revamp[tag];
-        auto const &outprim = primList[tag];
+// index of key in the sorted group t of g, as seen from the output primitive
+int lookupInGroup(UnmergeOutput const &out, TagGather const &g, int t, int key) {
+    auto first = g.source.begin() + g.offset[t], last = g.source.begin() + g.offset[t + 1];
+    return out.base(g, t) + int(std::lower_bound(first, last, key) - first);
+}
 
-        outprim->verts.resize(revamp.size());
-        parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-            outprim->verts[i] = prim->verts[revamp[i]];
-        });
-        prim->verts.foreach_attr([&] (auto const &key, auto const &inarr) {
-            using T = std::decay_t<decltype(inarr[0])>;
-            auto &outarr = outprim->verts.add_attr<T>(key);
-            parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                outarr[i] = inarr[revamp[i]];
-            });
+// scatters the elements picked by g, together with all their attributes,
+// into the array selected by getter, remap(value, tag, src) rewrites the
+// element itself, e.g. for the vertex indices of faces
+template <class Getter, class Remap>
+void gatherAttrVector(PrimitiveObject *prim, UnmergeOutput &out, TagGather const &g, std::string const &name, Getter getter, Remap remap) {
+    auto const &in = getter(prim);
+    using ValT = typename std::decay_t<decltype(in)>::value_type;
+    size_t nout = out.prims.size();
+    std::vector<std::decay_t<decltype(in)> *> outArrs(nout);
+    for (size_t k = 0; k < nout; k++) {
+        outArrs[k] = &getter(out.prims[k]);
+        outArrs[k]->resize(out.shared ? g.size() : g.count(k));
+    }
+    auto dest = [&] (size_t i) -> std::pair<size_t, size_t> {
+        int t = g.tag[i];
+        return out.shared ? std::pair<size_t, size_t>{0, i} : std::pair<size_t, size_t>{t, i - g.offset[t]};
+    };
+
+    std::vector<ValT *> dst(nout);
+    for (size_t k = 0; k < nout; k++) {
+        dst[k] = outArrs[k]->values.data();
+    }
+    parallel_for(g.size(), [&] (size_t i) {
+        auto [k, j] = dest(i);
+        dst[k][j] = remap(in.values[g.source[i]], g.tag[i], g.source[i]);
+    });
+
+    in.template foreach_attr<AttrAcceptAll>([&] (auto const &key, auto const &arr) {
+        using T = std::decay_t<decltype(arr[0])>;
+        std::vector<T *> dst(nout);
+        for (size_t k = 0; k < nout; k++) {
+            dst[k] = outArrs[k]->template add_attr<T>(key).data();
+        }
+        parallel_for(g.size(), [&] (size_t i) {
+            auto [k, j] = dest(i);
+            dst[k][j] = arr[g.source[i]];
         });
+    });
+    out.ranges.emplace_back(name, g.offset);
+}
+
+struct KeepValue {
+    template <class T>
+    T operator()(T const &val, int, int) const {
+        return val;
     }
+};
 
-    std::vector<std::vector<int>> face_revamp;
-
-    auto mock = [&] (auto getter) {
-        auto &prim_tris = getter(prim);
-        if (prim_tris.size()) {
-            face_revamp.clear();
-            face_revamp.resize(tagMax);
-            using T = std::decay_t<decltype(prim_tris[0])>;
-
-            for (size_t i = 0; i < prim_tris.size(); i++) {
-                auto ind = reinterpret_cast<decay_vec_t<T> const *>(&prim_tris[i]);
-                int tag = vert_unrevamp[ind[0]];
-                bool bad = false;
-                for (int j = 1; j < is_vec_n<T>; j++) {
-                    int new_tag = vert_unrevamp[ind[j]];
-                    if (tag != new_tag) {
-                        bad = true;
-                        break;
-                    }
-                }
-                if (!bad) face_revamp[tag].push_back(i);
+// rewrites every vertex index of a face through vmap(index, tag)
+template <class VMap>
+auto remapFaceIndices(VMap const &vmap) {
+    return [&vmap] (auto ind, int t, int) {
+        using T = decltype(ind);
+        if constexpr (is_vec_v<T>) {
+            for (size_t j = 0; j < is_vec_n<T>; j++) {
+                ind[j] = vmap(ind[j], t);
             }
+        } else {
+            ind = vmap(ind, t);
+        }
+        return ind;
+    };
+}
 
-            for (int tag = 0; tag < tagMax; tag++) {
-                auto &revamp = face_revamp[tag];
-                auto &v_revamp = vert_revamp[tag];
-                auto *outprim = primList[tag].get();
-                auto &outprim_tris = getter(outprim);
-
-                outprim_tris.resize(revamp.size());
-                parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                    auto ind = reinterpret_cast<decay_vec_t<T> const *>(&prim_tris[revamp[i]]);
-                    auto outind = reinterpret_cast<decay_vec_t<T> *>(&outprim_tris[i]);
-                    for (int j = 0; j < is_vec_n<T>; j++) {
-                        outind[j] = v_revamp[ind[j]];
-                    }
-                });
-
-                prim_tris.foreach_attr([&] (auto const &key, auto const &inarr) {
-                    using T = std::decay_t<decltype(inarr[0])>;
-                    auto &outarr = outprim_tris.template add_attr<T>(key);
-                    parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                        outarr[i] = inarr[revamp[i]];
-                    });
-                });
-            }
+// the loops of the polys picked by pg, in the order of pg, loopStart[i] is
+// where the loops of the i-th picked poly begin
+TagGather loopsOfPolys(PrimitiveObject *prim, TagGather const &pg, std::vector<int> &loopStart) {
+    TagGather lg;
+    lg.offset.assign(pg.ntags() + 1, 0);
+    loopStart.resize(pg.size());
+    int n = 0;
+    for (int t = 0; t < pg.ntags(); t++) {
+        lg.offset[t] = n;
+        for (int i = pg.offset[t]; i < pg.offset[t + 1]; i++) {
+            loopStart[i] = n;
+            n += prim->polys[pg.source[i]][1];
+        }
+    }
+    lg.offset[pg.ntags()] = n;
+    lg.source.resize(n);
+    parallel_for(pg.size(), [&] (size_t i) {
+        auto const &[base, len] = prim->polys[pg.source[i]];
+        for (int l = 0; l < len; l++) {
+            lg.source[loopStart[i] + l] = base + l;
         }
+    });
+    lg.fill_tags();
+    return lg;
+}
+
+template <class VMap>
+void gatherPolys(PrimitiveObject *prim, UnmergeOutput &out, TagGather const &pg, TagGather const &lg, std::vector<int> const &loopStart, VMap const &vmap) {
+    std::vector<int> newBase(prim->polys.size());
+    parallel_for(pg.size(), [&] (size_t i) {
+        int t = pg.tag[i];
+        newBase[pg.source[i]] = loopStart[i] - lg.offset[t] + out.base(lg, t);
+    });
+    gatherAttrVector(prim, out, pg, "polys", [] (auto *p) -> auto & { return p->polys; },
+                     [&] (vec2i poly, int, int src) { return vec2i(newBase[src], poly[1]); });
+    gatherAttrVector(prim, out, lg, "loops", [] (auto *p) -> auto & { return p->loops; },
+                     remapFaceIndices(vmap));
+
+    if (prim->loops.has_attr("uvs") && prim->uvs.size()) {
+        auto const &loopUVs = prim->loops.attr<int>("uvs");
+        std::vector<int> keys(lg.size());
+        parallel_for(lg.size(), [&] (size_t i) {
+            keys[i] = loopUVs[lg.source[i]];
+        });
+        auto ug = uniqueByTag(lg.offset, std::move(keys));
+        gatherAttrVector(prim, out, ug, "uvs", [] (auto *p) -> auto & { return p->uvs; }, KeepValue{});
+        std::vector<int *> dst(out.prims.size());
+        for (size_t k = 0; k < out.prims.size(); k++) {
+            dst[k] = out.prims[k]->loops.attr<int>("uvs").data();
+        }
+        parallel_for(lg.size(), [&] (size_t i) {
+            int t = lg.tag[i];
+            int uv = lookupInGroup(out, ug, t, loopUVs[lg.source[i]]);
+            if (out.shared) dst[0][i] = uv;
+            else dst[t][i - lg.offset[t]] = uv;
+        });
+    }
+}
+
+template <class F>
+void forEachFaceArray(PrimitiveObject *prim, F const &f) {
+    f("points", [] (auto *p) -> auto & { return p->points; });
+    f("lines", [] (auto *p) -> auto & { return p->lines; });
+    f("tris", [] (auto *p) -> auto & { return p->tris; });
+    f("quads", [] (auto *p) -> auto & { return p->quads; });
+    f("edges", [] (auto *p) -> auto & { return p->edges; });
+}
+
+// every vertex goes to the primitive of its tag, faces are kept if all of
+// their vertices carry the same tag
+void unmergeByVertTag(PrimitiveObject *prim, std::string const &tagAttr, int ntags, UnmergeOutput &out) {
+    auto const &tagArr = prim->verts.attr<int>(tagAttr);
+    auto vertTag = [&] (int v) {
+        int t = tagArr[v];
+        return t >= 0 && t < ntags ? t : -1;
+    };
+    auto vg = partitionByTag(prim->verts.size(), ntags, vertTag);
+    std::vector<int> local(prim->verts.size(), -1);
+    parallel_for(vg.size(), [&] (size_t i) {
+        local[vg.source[i]] = i - vg.offset[vg.tag[i]];
+    });
+    auto vmap = [&] (int v, int t) {
+        return out.base(vg, t) + local[v];
     };
-    mock([] (auto &&p) -> auto & { return p->points; });
-    mock([] (auto &&p) -> auto & { return p->lines; });
-    mock([] (auto &&p) -> auto & { return p->tris; });
-    mock([] (auto &&p) -> auto & { return p->quads; });
+    gatherAttrVector(prim, out, vg, "verts", [] (auto *p) -> auto & { return p->verts; }, KeepValue{});
+
+    forEachFaceArray(prim, [&] (const char *name, auto getter) {
+        auto const &arr = getter(prim);
+        if (!arr.size()) return;
+        auto fg = partitionByTag(arr.size(), ntags, [&] (size_t i) {
+            auto const &ind = arr[i];
+            using T = std::decay_t<decltype(ind)>;
+            if constexpr (is_vec_v<T>) {
+                int t = vertTag(ind[0]);
+                for (size_t j = 1; j < is_vec_n<T>; j++) {
+                    if (vertTag(ind[j]) != t) return -1;
+                }
+                return t;
+            } else {
+                return vertTag(ind);
+            }
+        });
+        gatherAttrVector(prim, out, fg, name, getter, remapFaceIndices(vmap));
+    });
 
     if (prim->polys.size()) {
-        face_revamp.clear();
-        face_revamp.resize(tagMax);
-
-        for (size_t i = 0; i < prim->polys.size(); i++) {
-            auto &[base, len] = prim->polys[i];
-            if (len <= 0) continue;
-            int tag = vert_unrevamp[prim->loops[base]];
-            bool bad = false;
-            for (int j = base + 1; j < base + len; i++) {
-                int new_tag = vert_unrevamp[prim->loops[j]];
-                if (tag != new_tag) {
-                    bad = true;
-                    break;
-                }
+        auto pg = partitionByTag(prim->polys.size(), ntags, [&] (size_t i) {
+            auto const &[base, len] = prim->polys[i];
+            if (len <= 0) return -1;
+            int t = vertTag(prim->loops[base]);
+            for (int j = base + 1; j < base + len; j++) {
+                if (vertTag(prim->loops[j]) != t) return -1;
             }
-            if (!bad) face_revamp[tag].push_back(i);
+            return t;
+        });
+        std::vector<int> loopStart;
+        auto lg = loopsOfPolys(prim, pg, loopStart);
+        gatherPolys(prim, out, pg, lg, loopStart, vmap);
+    }
+}
+
+// faces go to the primitive of their tag, each taking the vertices it uses
+void unmergeByFaceTag(PrimitiveObject *prim, std::vector<int> const &faceTag, int ntags, UnmergeOutput &out) {
+    if (prim->tris.size()) {
+        auto fg = partitionByTag(prim->tris.size(), ntags, [&] (size_t i) { return faceTag[i]; });
+        std::vector<int> offset(ntags + 1);
+        for (int t = 0; t <= ntags; t++) {
+            offset[t] = fg.offset[t] * 3;
         }
+        std::vector<int> keys(fg.size() * 3);
+        parallel_for(fg.size(), [&] (size_t i) {
+            auto const &ind = prim->tris[fg.source[i]];
+            for (int j = 0; j < 3; j++) keys[i * 3 + j] = ind[j];
+        });
+        auto vg = uniqueByTag(offset, std::move(keys));
+        auto vmap = [&] (int v, int t) {
+            return lookupInGroup(out, vg, t, v);
+        };
+        gatherAttrVector(prim, out, vg, "verts", [] (auto *p) -> auto & { return p->verts; }, KeepValue{});
+        gatherAttrVector(prim, out, fg, "tris", [] (auto *p) -> auto & { return p->tris; }, remapFaceIndices(vmap));
+    } else {
+        auto pg = partitionByTag(prim->polys.size(), ntags, [&] (size_t i) { return faceTag[i]; });
+        std::vector<int> loopStart;
+        auto lg = loopsOfPolys(prim, pg, loopStart);
+        std::vector<int> keys(lg.size());
+        parallel_for(lg.size(), [&] (size_t i) {
+            keys[i] = prim->loops[lg.source[i]];
+        });
+        auto vg = uniqueByTag(lg.offset, std::move(keys));
+        auto vmap = [&] (int v, int t) {
+            return lookupInGroup(out, vg, t, v);
+        };
+        gatherAttrVector(prim, out, vg, "verts", [] (auto *p) -> auto & { return p->verts; }, KeepValue{});
+        gatherPolys(prim, out, pg, lg, loopStart, vmap);
+    }
+}
 
-        for (int tag = 0; tag < tagMax; tag++) {
-            auto &revamp = face_revamp[tag];
-            auto &v_revamp = vert_revamp[tag];
-            auto *outprim = primList[tag].get();
-
-            outprim->polys.resize(revamp.size());
-            for (size_t i = 0; i < revamp.size(); i++) {
-                auto const &[base, len] = prim->polys[revamp[i]];
-                int new_base = outprim->loops.size();
-                for (int j = base; j < base + len; j++) {
-                    outprim->loops.push_back(prim->loops[j]);
-                }
-                outprim->polys[i] = {new_base, len};
-            }
+std::vector<std::shared_ptr<PrimitiveObject>> makeUnmergeOutput(PrimitiveObject *prim, size_t n, UnmergeOutput &out) {
+    std::vector<std::shared_ptr<PrimitiveObject>> primList(n);
+    for (size_t i = 0; i < n; i++) {
+        primList[i] = std::make_shared<PrimitiveObject>();
+        primList[i]->m_userData = prim->m_userData;
+        primList[i]->mtl = prim->mtl;
+        primList[i]->inst = prim->inst;
+        out.prims.push_back(primList[i].get());
+    }
+    return primList;
+}
 
-            prim->polys.foreach_attr([&] (auto const &key, auto const &inarr) {
-                using T = std::decay_t<decltype(inarr[0])>;
-                auto &outarr = outprim->polys.add_attr<T>(key);
-                parallel_for((size_t)0, revamp.size(), [&] (size_t i) {
-                    outarr[i] = inarr[revamp[i]];
-                });
-            });
+// one point per tag, with the begin and count of the tag in every array
+void writeUnmergeRanges(UnmergeOutput const &out, std::vector<int> const &tagValues, PrimitiveObject *ranges) {
+    int ntags = tagValues.size();
+    ranges->verts.clear_with_attr();
+    ranges->verts.resize(ntags);
+    auto &tagArr = ranges->verts.add_attr<int>("tagValue");
+    std::copy(tagValues.begin(), tagValues.end(), tagArr.begin());
+    for (auto const &[name, offset]: out.ranges) {
+        auto &begin = ranges->verts.add_attr<int>(name + "Begin");
+        auto &count = ranges->verts.add_attr<int>(name + "Count");
+        for (int t = 0; t < ntags; t++) {
+            begin[t] = offset[t];
+            count[t] = offset[t + 1] - offset[t];
         }
     }
-#endif
+}
+
+int vertTagCount(PrimitiveObject *prim, std::string const &tagAttr) {
+    auto const &tagArr = prim->verts.attr<int>(tagAttr);
+    return std::max(0, parallel_reduce_max(tagArr.begin(), tagArr.end()) + 1);
+}
 
+// dense ids of the face tags, in increasing order of the tag values
+int faceTagIds(PrimitiveObject *prim, std::string const &tagAttr, std::vector<int> &faceTag, std::vector<int> &tagValues) {
+    if (prim->tris.size() > 0 && prim->polys.size() > 0) {
+        primPolygonate(prim, true);
+    }
+    auto const &attr = prim->tris.size() ? prim->tris.attr<int>(tagAttr) : prim->polys.attr<int>(tagAttr);
+    tagValues.assign(attr.begin(), attr.end());
+    std::sort(tagValues.begin(), tagValues.end());
+    tagValues.erase(std::unique(tagValues.begin(), tagValues.end()), tagValues.end());
+    faceTag.resize(attr.size());
+    parallel_for(attr.size(), [&] (size_t i) {
+        faceTag[i] = std::lower_bound(tagValues.begin(), tagValues.end(), attr[i]) - tagValues.begin();
+    });
+    return tagValues.size();
+}
+
+}
+
+ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeVerts(PrimitiveObject *prim, std::string tagAttr) {
+    if (!prim->verts.size()) return {};
+
+    int ntags = vertTagCount(prim, tagAttr);
+    UnmergeOutput out;
+    auto primList = makeUnmergeOutput(prim, ntags, out);
+    unmergeByVertTag(prim, tagAttr, ntags, out);
     return primList;
 }
 
@@ -208,64 +424,15 @@ void remap_attr_on_faces(PrimitiveObject *prim, std::string tagAttr, std::map<in
 
 ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeFaces(PrimitiveObject *prim, std::string tagAttr) {
     if (!prim->verts.size()) return {};
+    if (!prim->tris.size() && !prim->polys.size()) return {};
 
-    if (prim->tris.size() > 0 && prim->polys.size() > 0) {
-        primPolygonate(prim, true);
-    }
-
-    std::vector<std::shared_ptr<PrimitiveObject>> list;
+    std::vector<int> faceTag, tagValues;
+    int ntags = faceTagIds(prim, tagAttr, faceTag, tagValues);
+    UnmergeOutput out;
+    auto list = makeUnmergeOutput(prim, ntags, out);
+    unmergeByFaceTag(prim, faceTag, ntags, out);
 
-    std::map<int, std::vector<int>> mapping;
-    if (prim->tris.size() > 0) {
-        auto &attr = prim->tris.attr<int>(tagAttr);
-        for (auto i = 0; i < prim->tris.size(); i++) {
-            if (mapping.count(attr[i]) == 0) {
-                mapping[attr[i]] = {};
-            }
-            mapping[attr[i]].push_back(i);
-        }
-        for (auto &[key, val]: mapping) {
-            auto new_prim = std::dynamic_pointer_cast<PrimitiveObject>(prim->clone());
-            new_prim->tris.resize(val.size());
-            for (auto i = 0; i < val.size(); i++) {
-                new_prim->tris[i] = prim->tris[val[i]];
-            }
-            new_prim->tris.foreach_attr<AttrAcceptAll>([&](auto const &key, auto &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                auto &attr = prim->tris.attr<T>(key);
-                for (auto i = 0; i < arr.size(); i++) {
-                    arr[i] = attr[val[i]];
-                }
-            });
-            list.push_back(new_prim);
-        }
-    }
-    else if (prim->polys.size() > 0) {
-        auto &attr = prim->polys.attr<int>(tagAttr);
-        for (auto i = 0; i < prim->polys.size(); i++) {
-            if (mapping.count(attr[i]) == 0) {
-                mapping[attr[i]] = {};
-            }
-            mapping[attr[i]].push_back(i);
-        }
-        for (auto &[key, val]: mapping) {
-            auto new_prim = std::dynamic_pointer_cast<PrimitiveObject>(prim->clone());
-            new_prim->polys.resize(val.size());
-            for (auto i = 0; i < val.size(); i++) {
-                new_prim->polys[i] = prim->polys[val[i]];
-            }
-            new_prim->polys.foreach_attr<AttrAcceptAll>([&](auto const &key, auto &arr) {
-                using T = std::decay_t<decltype(arr[0])>;
-                auto &attr = prim->polys.attr<T>(key);
-                for (auto i = 0; i < arr.size(); i++) {
-                    arr[i] = attr[val[i]];
-                }
-            });
-            list.push_back(new_prim);
-        }
-    }
     for (auto i = 0; i < list.size(); i++) {
-        primKillDeadVerts(list[i].get());
         // remove unused abcpath
         {
             auto abcpath_set = get_attr_on_faces(list[i].get(), "abcpath", true);
@@ -310,6 +477,28 @@ ZENO_API std::vector<std::shared_ptr<PrimitiveObject>> primUnmergeFaces(Primitiv
     return list;
 }
 
+ZENO_API std::shared_ptr<PrimitiveObject> primUnmergeShared(PrimitiveObject *prim, std::string tagAttr, bool byFaces, PrimitiveObject *ranges) {
+    UnmergeOutput out;
+    out.shared = true;
+    auto outPrim = makeUnmergeOutput(prim, 1, out)[0];
+
+    std::vector<int> tagValues;
+    if (!byFaces && prim->verts.size()) {
+        int ntags = vertTagCount(prim, tagAttr);
+        unmergeByVertTag(prim, tagAttr, ntags, out);
+        tagValues.resize(ntags);
+        std::iota(tagValues.begin(), tagValues.end(), 0);
+    } else if (byFaces && prim->verts.size() && (prim->tris.size() || prim->polys.size())) {
+        std::vector<int> faceTag;
+        int ntags = faceTagIds(prim, tagAttr, faceTag, tagValues);
+        unmergeByFaceTag(prim, faceTag, ntags, out);
+    }
+    if (ranges) {
+        writeUnmergeRanges(out, tagValues, ranges);
+    }
+    return outPrim;
+}
+
 namespace {
 
 struct PrimUnmerge : INode {
@@ -321,6 +510,14 @@ struct PrimUnmerge : INode {
         if (get_input2<bool>("preSimplify")) {
             primSimplifyTag(prim.get(), tagAttr);
         }
+        if (get_input2<bool>("sharedBuffer")) {
+            auto ranges = std::make_shared<PrimitiveObject>();
+            set_output("prim", primUnmergeShared(prim.get(), tagAttr, method != "verts", ranges.get()));
+            set_output("ranges", std::move(ranges));
+            set_output("listPrim", std::make_shared<ListObject>());
+            return;
+        }
+
         std::vector<std::shared_ptr<PrimitiveObject>> primList;
         if (method == "verts") {
             primList = primUnmergeVerts(prim.get(), tagAttr);
@@ -334,6 +531,8 @@ struct PrimUnmerge : INode {
             listPrim->arr.push_back(std::move(primPtr));
         }
         set_output("listPrim", std::move(listPrim));
+        set_output("prim", std::make_shared<PrimitiveObject>());
+        set_output("ranges", std::make_shared<PrimitiveObject>());
     }
 };
 
@@ -343,9 +542,12 @@ ZENDEFNODE(PrimUnmerge, {
         {"string", "tagAttr", "tag"},
         {"bool", "preSimplify", "0"},
         {"enum verts faces", "method", "verts"},
+        {"bool", "sharedBuffer", "0"},
     },
     {
         {"list", "listPrim"},
+        {"primitive", "prim"},
+        {"primitive", "ranges"},
     },
     {
     },
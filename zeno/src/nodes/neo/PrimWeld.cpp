@@ -3,76 +3,172 @@
 #include <zeno/funcs/PrimitiveUtils.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/types/NumericObject.h>
-#include <unordered_map>
+#include <zeno/para/parallel_for.h>
+#include <zeno/para/parallel_reduce.h>
+#include <zeno/para/parallel_scan.h>
+#include <zeno/para/parallel_sort.h>
+#include <zeno/para/union_find.h>
 #include <algorithm>
+#include <numeric>
+#include <limits>
 
 namespace zeno {
 namespace {
 
 template <class T>
 static void revamp_vector(std::vector<T> &arr, std::vector<int> const &revamp) {
-    std::vector<T> newarr(arr.size());
-    for (int i = 0; i < revamp.size(); i++) {
+    std::vector<T> newarr(revamp.size());
+    parallel_for(revamp.size(), [&] (size_t i) {
         newarr[i] = arr[revamp[i]];
-    }
+    });
     std::swap(arr, newarr);
 }
 
+// root[i] is the smallest vertex sharing the tag of vertex i
+static std::vector<int> clusterByTag(PrimitiveObject *prim, std::string const &tagAttr) {
+    auto const &tag = prim->verts.attr<int>(tagAttr);
+    std::vector<int> order(prim->size());
+    std::iota(order.begin(), order.end(), 0);
+    parallel_sort(order.begin(), order.end(), [&] (int a, int b) {
+        return tag[a] != tag[b] ? tag[a] < tag[b] : a < b;
+    });
+    std::vector<int> root(prim->size());
+    parallel_for(order.size(), [&] (size_t i) {
+        if (i != 0 && tag[order[i - 1]] == tag[order[i]]) return;
+        for (size_t j = i; j < order.size() && tag[order[j]] == tag[order[i]]; j++) {
+            root[order[j]] = order[i];
+        }
+    });
+    return root;
+}
+
+// root[i] is the smallest vertex of the cluster of vertex i, where two
+// vertices closer than distance are in the same cluster (single linkage)
+static std::vector<int> clusterByDistance(PrimitiveObject *prim, float distance) {
+    if (!(distance > 0))
+        throw makeError("PrimWeld: distance must be positive, got " + std::to_string(distance));
+    auto const &pos = prim->verts.values;
+    size_t n = pos.size();
+    // cells larger than distance only cost more pair tests, so grow them
+    // when the coordinates in cell units would not fit in an int
+    float maxCoord = parallel_reduce((size_t)0, n, 0.f, [] (float x, float y) {
+        return std::max(x, y);
+    }, [&] (size_t i) {
+        return std::max({std::abs(pos[i][0]), std::abs(pos[i][1]), std::abs(pos[i][2])});
+    });
+    float invCell = std::min(1 / distance, float(1 << 30) / std::max(maxCoord, 1.f));
+    std::vector<vec3i> cell(n);
+    parallel_for(n, [&] (size_t i) {
+        cell[i] = ifloor(pos[i] * invCell);
+    });
+    auto cellLess = [] (vec3i const &a, vec3i const &b) {
+        return a[0] != b[0] ? a[0] < b[0] : a[1] != b[1] ? a[1] < b[1] : a[2] < b[2];
+    };
+    auto cellEqual = [] (vec3i const &a, vec3i const &b) {
+        return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+    };
+
+    // vertices sorted by cell, ucell[c] holds order[cellBegin[c]] .. order[cellBegin[c + 1] - 1]
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    parallel_sort(order.begin(), order.end(), [&] (int a, int b) {
+        return cellLess(cell[a], cell[b]);
+    });
+    std::vector<vec3i> ucell;
+    std::vector<int> cellBegin;
+    for (size_t i = 0; i < n; i++) {
+        if (i == 0 || !cellEqual(cell[order[i]], cell[order[i - 1]])) {
+            ucell.push_back(cell[order[i]]);
+            cellBegin.push_back(i);
+        }
+    }
+    cellBegin.push_back(n);
+
+    // each pair of neighbouring cells is visited once, from the lesser one
+    std::vector<vec3i> offsets;
+    for (int dx = -1; dx <= 1; dx++) for (int dy = -1; dy <= 1; dy++) for (int dz = -1; dz <= 1; dz++) {
+        if (!cellLess(vec3i(dx, dy, dz), vec3i(0))) offsets.emplace_back(dx, dy, dz);
+    }
+    float dist2 = distance * distance;
+    ConcurrentUnionFind uf(n);
+    parallel_for(ucell.size(), [&] (size_t c) {
+        for (auto const &off: offsets) {
+            vec3i nc = ucell[c] + off;
+            auto it = std::lower_bound(ucell.begin() + c, ucell.end(), nc, cellLess);
+            if (it == ucell.end() || !cellEqual(*it, nc)) continue;
+            size_t d = it - ucell.begin();
+            for (int a = cellBegin[c]; a < cellBegin[c + 1]; a++) {
+                for (int b = d == c ? a + 1 : cellBegin[d]; b < cellBegin[d + 1]; b++) {
+                    if (lengthSquared(pos[order[a]] - pos[order[b]]) <= dist2)
+                        uf.unite(order[a], order[b]);
+                }
+            }
+        }
+    });
+    std::vector<int> root(n);
+    parallel_for(n, [&] (size_t i) {
+        root[i] = uf.find(i);
+    });
+    return root;
+}
+
 struct PrimWeld : INode {
     virtual void apply() override {
         auto prim = get_input<PrimitiveObject>("prim");
-        auto tagAttr = get_input<StringObject>("tagAttr")->get();
         auto isAverage = get_input<StringObject>("method")->get() == "average";
 
-        std::unordered_multimap<int, int> lut;
-        auto &tag = prim->verts.attr<int>(tagAttr);
-        for (int i = 0; i < prim->size(); i++) {
-            lut.insert({tag[i], i});
-        }
-        std::vector<int> revamp;
-        std::vector<int> unrevamp(prim->size());
-        revamp.resize(lut.size());
-        int nrevamp = 0;
-        for (auto it = lut.begin(); it != lut.end();) {
-            auto nit = std::find_if(std::next(it), lut.end(), [val = it->first] (auto const &p) {
-                return p.first != val;
-            });
-            auto start = it->second;
-            if (isAverage) {
-                vec3f average = prim->verts[start];
-                int count = 1;
-                for (++it; it != nit; ++it) {
-                    unrevamp[it->second] = nrevamp;
-                    auto pos = prim->verts[it->second];
-                    average += pos;
-                    ++count;
-                }
-                average *= 1 / (float)count;
-                prim->verts[start] = average;
-            } else {
-                for (; it != nit; ++it) {
-                    //printf("(%d) %d -> %d\n", it->first, it->second, nrevamp);
-                    unrevamp[it->second] = nrevamp;
-                    // unrevamp[old_coor] = new_coor
-                }
-            }
-            revamp[nrevamp] = start;
-            ++nrevamp;
+        std::vector<int> root;
+        if (get_input2<std::string>("weldBy") == "distance") {
+            root = clusterByDistance(prim.get(), get_input2<float>("distance"));
+        } else {
+            root = clusterByTag(prim.get(), get_input<StringObject>("tagAttr")->get());
         }
-        revamp.resize(nrevamp);
-        //primRevampVerts(prim.get(), revamp, &unrevamp);
 
-        revamp_vector(prim->verts.values, revamp);
+        // clusters numbered by their smallest vertex, which is kept for oneof
+        size_t nverts = prim->size();
+        std::vector<int> clusterId(nverts);
+        int nrevamp = parallel_exclusive_scan_sum(counter_iterator<size_t>(0), counter_iterator<size_t>(nverts), clusterId.begin(), [&] (size_t i) {
+            return int(root[i] == i);
+        });
+        std::vector<int> revamp(nrevamp);
+        std::vector<int> unrevamp(nverts);
+        parallel_for(nverts, [&] (size_t i) {
+            unrevamp[i] = clusterId[root[i]];
+            if (root[i] == i) revamp[clusterId[i]] = i;
+        });
+
         if (isAverage) {
-            prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+            // members of each cluster, stored back to back
+            std::vector<int> memberBegin(nrevamp + 1);
+            for (size_t i = 0; i < nverts; i++) {
+                memberBegin[unrevamp[i] + 1]++;
+            }
+            for (int k = 0; k < nrevamp; k++) {
+                memberBegin[k + 1] += memberBegin[k];
+            }
+            std::vector<int> members(nverts);
+            std::vector<int> cursor(memberBegin.begin(), memberBegin.end() - 1);
+            for (size_t i = 0; i < nverts; i++) {
+                members[cursor[unrevamp[i]]++] = i;
+            }
+            auto average = [&] (auto &arr) {
                 using T = std::decay_t<decltype(arr[0])>;
                 std::vector<T> new_arr(nrevamp);
-                for (size_t i = 0; i < arr.size(); i++) {
-                    new_arr[unrevamp[i]] += arr[i] / (T)lut.count(i);
-                }
+                parallel_for((size_t)nrevamp, [&] (size_t k) {
+                    T sum = arr[members[memberBegin[k]]];
+                    for (int m = memberBegin[k] + 1; m < memberBegin[k + 1]; m++) {
+                        sum += arr[members[m]];
+                    }
+                    new_arr[k] = sum / (T)(memberBegin[k + 1] - memberBegin[k]);
+                });
                 arr = std::move(new_arr);
+            };
+            average(prim->verts.values);
+            prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
+                average(arr);
             });
         } else {
+            revamp_vector(prim->verts.values, revamp);
             prim->verts.foreach_attr<AttrAcceptAll>([&] (auto const &key, auto &arr) {
                 revamp_vector(arr, revamp);
             });
@@ -84,38 +180,45 @@ struct PrimWeld : INode {
                 x = unrevamp[x];
         };
 
-        for (size_t i = 0; i < prim->points.size(); i++) {
-            auto &ind = prim->points[i];
-            repair(ind);
-        }
-
-        for (size_t i = 0; i < prim->lines.size(); i++) {
+        parallel_for(prim->points.size(), [&] (size_t i) {
+            repair(prim->points[i]);
+        });
+        parallel_for(prim->lines.size(), [&] (size_t i) {
             auto &ind = prim->lines[i];
             repair(ind[0]);
             repair(ind[1]);
-        }
-        prim->lines->erase(std::remove_if(prim->lines.begin(), prim->lines.end(), [&] (auto const &ind) {
-            return ind[0] == ind[1];
-        }), prim->lines.end());
-        prim->lines.update();
-
-        for (size_t i = 0; i < prim->tris.size(); i++) {
+        });
+        parallel_for(prim->tris.size(), [&] (size_t i) {
             auto &ind = prim->tris[i];
             repair(ind[0]);
             repair(ind[1]);
             repair(ind[2]);
-        }
-        prim->tris->erase(std::remove_if(prim->tris.begin(), prim->tris.end(), [&] (auto const &ind) {
-            return ind[0] == ind[1] || ind[0] == ind[2] || ind[1] == ind[2];
-        }), prim->tris.end());
-
-        for (size_t i = 0; i < prim->quads.size(); i++) {
+        });
+        parallel_for(prim->quads.size(), [&] (size_t i) {
             auto &ind = prim->quads[i];
             repair(ind[0]);
             repair(ind[1]);
             repair(ind[2]);
             repair(ind[3]);
-        }
+        });
+        parallel_for(prim->loops.size(), [&] (size_t i) {
+            repair(prim->loops[i]);
+        });
+        parallel_for(prim->edges.size(), [&] (size_t i) {
+            auto &ind = prim->edges[i];
+            repair(ind[0]);
+            repair(ind[1]);
+        });
+
+        prim->lines->erase(std::remove_if(prim->lines.begin(), prim->lines.end(), [&] (auto const &ind) {
+            return ind[0] == ind[1];
+        }), prim->lines.end());
+        prim->lines.update();
+
+        prim->tris->erase(std::remove_if(prim->tris.begin(), prim->tris.end(), [&] (auto const &ind) {
+            return ind[0] == ind[1] || ind[0] == ind[2] || ind[1] == ind[2];
+        }), prim->tris.end());
+
         std::vector<uint8_t> ridquad(prim->quads.size());
         auto ridquadit = ridquad.begin();
         for (auto ind: prim->quads) {
@@ -134,17 +237,14 @@ struct PrimWeld : INode {
         }), prim->quads.end());
         prim->quads.update();
 
-        for (size_t i = 0; i < prim->loops.size(); i++) {
-            auto &ind = prim->loops[i];
-            repair(ind);
-        }
-        for (auto &[base, len]: prim->polys) {
+        parallel_for(prim->polys.size(), [&] (size_t i) {
+            auto &[base, len] = prim->polys[i];
             auto bit = prim->loops.begin() + base;
             auto eit = prim->loops.begin() + (base + len);
             auto mit = std::unique(bit, eit);
             std::fill(mit, eit, 0); // not used anyway... prune later
             len = mit - bit;
-        }
+        });
         prim->polys->erase(std::remove_if(prim->polys.begin(), prim->polys.end(), [&] (auto const &ply) {
             return ply[1] <= 2;
         }), prim->polys.end());
@@ -161,6 +261,8 @@ ZENDEFNODE(PrimWeld, {
     {"PrimitiveObject", "prim"},
     {"string", "tagAttr", "weld"},
     {"enum oneof average", "method", "oneof"},
+    {"enum tag distance", "weldBy", "tag"},
+    {"float", "distance", "0.001"},
     },
     {
     {"PrimitiveObject", "prim"},
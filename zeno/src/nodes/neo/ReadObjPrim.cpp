@@ -4,9 +4,12 @@
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/string.h>
 #include <zeno/utils/fileio.h>
+#include <zeno/utils/mapped_file.h>
 #include <zeno/utils/logger.h>
 #include <zeno/utils/vec.h>
+#include <zeno/para/parallel_for.h>
 #include <string_view>
+#include <charconv>
 #include <algorithm>
 #include <cstring>
 #include <cstdlib>
@@ -18,8 +21,8 @@ namespace zeno {
 namespace {
 
 template <std::size_t ...Is>
-static bool match_helper(char const *&it, char const *arr, std::index_sequence<Is...>) {
-    if (((it[Is] == arr[Is]) && ...)) {
+static bool match_helper(char const *&it, char const *eit, char const *arr, std::index_sequence<Is...>) {
+    if (eit - it >= (std::ptrdiff_t)sizeof...(Is) && ((it[Is] == arr[Is]) && ...)) {
         it += sizeof...(Is);
         return true;
     } else {
@@ -28,95 +31,163 @@ static bool match_helper(char const *&it, char const *arr, std::index_sequence<I
 }
 
 template <std::size_t N>
-static bool match(char const *&it, char const (&arr)[N]) {
-    return match_helper(it, arr, std::make_index_sequence<N - 1>{});
+static bool match(char const *&it, char const *eit, char const (&arr)[N]) {
+    return match_helper(it, eit, arr, std::make_index_sequence<N - 1>{});
 }
 
-static float takef(char const *&it) {
-    char *eptr;
-    float val = std::strtof(it, &eptr);
-    it = eptr;
-    return val;
+static bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
 }
 
-static int takeu(char const *&it) {
-    char *eptr;
-    int val(std::strtoul(it, &eptr, 10));
-    it = eptr;
-    return val;
+static void skip_blank(char const *&it, char const *eit) {
+    while (it != eit && is_blank(*it)) ++it;
 }
 
-// std::shared_ptr<PrimitiveObject> parse_obj(std::vector<char> &&bin) 
-PrimitiveObject* parse_obj(const char *binData, std::size_t binSize) {
-    /*bin.resize(bin.size() + 8, '\0');*/
+static float takef(char const *&it, char const *eit) {
+    skip_blank(it, eit);
+    if (it != eit && *it == '+') ++it;
+    float val = 0;
+    auto [ptr, ec] = std::from_chars(it, eit, val);
+    it = ptr;
+    return val;
+}
 
-    char const *it = binData;
-    char const *eit = binData + binSize;// - 8;
+static int takei(char const *&it, char const *eit) {
+    skip_blank(it, eit);
+    int val = 0;
+    auto [ptr, ec] = std::from_chars(it, eit, val);
+    it = ptr;
+    return val;
+}
 
-    // auto prim = std::make_shared<PrimitiveObject>();
-    auto prim = new PrimitiveObject;
+// everything parsed from one chunk of lines, indices are 0-based; relative
+// (negative) ones are kept local to the chunk and listed to be fixed on merge
+struct ObjChunk {
+    std::vector<vec3f> verts;
+    std::vector<vec2f> uvs;
+    std::vector<int> loops;
     std::vector<int> loop_uvs;
+    std::vector<vec2i> polys;
+    std::vector<vec2i> lines;
+    std::vector<int> rel_loops;
+    std::vector<int> rel_loop_uvs;
+    std::vector<int> rel_lines; // line * 2 + end
+
+    int vert_index(int x) {
+        return x < 0 ? (int)verts.size() + x : x - 1;
+    }
 
-    while (it < eit) {
-        auto nit = std::find(it, eit, '\n');
-        auto nnit = nit + 1;
-        if (nit[-1] == '\r')
-            --nit;
-
-        if (match(it, "v ")) {
-            float x = takef(it);
-            float y = takef(it);
-            float z = takef(it);
-            prim->verts.emplace_back(x, y, z);
-
-        } else if (match(it, "vt ")) {
-            float x = takef(it);
-            float y = takef(it);
-            prim->uvs.emplace_back(x, y);
-
-        } else if (match(it, "f ")) {
-            int beg = prim->loops.size();
-            int cnt{};
-            while (it != nit) {
-                int x = takeu(it) - 1;
-                if (*it == '/' && it[1] != '/') {
-                    ++it;
-                    int xt = takeu(it) - 1;
-                    loop_uvs.push_back(xt);
+    void parse(char const *it, char const *eit) {
+        while (it < eit) {
+            auto nit = std::find(it, eit, '\n');
+
+            if (match(it, nit, "v ")) {
+                float x = takef(it, nit);
+                float y = takef(it, nit);
+                float z = takef(it, nit);
+                verts.emplace_back(x, y, z);
+
+            } else if (match(it, nit, "vt ")) {
+                float x = takef(it, nit);
+                float y = takef(it, nit);
+                uvs.emplace_back(x, y);
+
+            } else if (match(it, nit, "f ")) {
+                int beg = loops.size();
+                int cnt{};
+                skip_blank(it, nit);
+                while (it != nit) {
+                    int x = takei(it, nit);
+                    if (x < 0) rel_loops.push_back(loops.size());
+                    loops.push_back(vert_index(x));
+                    if (it != nit && *it == '/' && it + 1 != nit && it[1] != '/') {
+                        ++it;
+                        int xt = takei(it, nit);
+                        if (xt < 0) rel_loop_uvs.push_back(loop_uvs.size());
+                        loop_uvs.push_back(xt < 0 ? (int)uvs.size() + xt : xt - 1);
+                    }
+                    it = std::find_if(it, nit, is_blank);
+                    ++cnt;
+                    skip_blank(it, nit);
                 }
-                it = std::find(it, nit, ' ');
-                prim->loops.push_back(x);
-                ++cnt;
-                it = std::find_if(it, nit, [] (char c) { return c != ' '; });
-            }
-            prim->polys.emplace_back(beg, cnt);
+                polys.emplace_back(beg, cnt);
 
-        } else if (match(it, "l ")) {
-            int x = takeu(it) - 1;
-            int y = takeu(it) - 1;
-            prim->lines.emplace_back(x, y);
+            } else if (match(it, nit, "l ")) {
+                int x = takei(it, nit);
+                int y = takei(it, nit);
+                if (x < 0) rel_lines.push_back(lines.size() * 2);
+                if (y < 0) rel_lines.push_back(lines.size() * 2 + 1);
+                lines.emplace_back(vert_index(x), vert_index(y));
 
-        //} else if (match(it, "o ")) {
-            // todo: support tag verts to be multi components of primitive
-            //std::string_view o_name(it, nit - it);
+            //} else if (match(it, nit, "o ")) {
+                // todo: support tag verts to be multi components of primitive
+                //std::string_view o_name(it, nit - it);
 
+            }
+            it = nit == eit ? eit : nit + 1;
         }
-        it = nnit;
     }
+};
 
-    {
-        int vert_count = prim->verts.size();
-        for (auto &i : prim->loops) {
-            if (i < 0) {
-                i += vert_count + 1;
-            }
-        }
-        for (auto &i : loop_uvs) {
-            if (i < 0) {
-                i += vert_count + 1;
-            }
-        }
+// std::shared_ptr<PrimitiveObject> parse_obj(std::vector<char> &&bin) 
+PrimitiveObject* parse_obj(const char *binData, std::size_t binSize) {
+    char const *eit = binData + binSize;
+
+    // split at line boundaries, each chunk is parsed on its own
+    constexpr std::size_t kChunkSize = 1 << 20;
+    std::vector<char const *> bounds{binData};
+    while (eit - bounds.back() > (std::ptrdiff_t)kChunkSize) {
+        auto nit = std::find(bounds.back() + kChunkSize, eit, '\n');
+        if (nit == eit) break;
+        bounds.push_back(nit + 1);
+    }
+    bounds.push_back(eit);
+    std::vector<ObjChunk> chunks(bounds.size() - 1);
+    parallel_for(chunks.size(), [&] (std::size_t c) {
+        chunks[c].parse(bounds[c], bounds[c + 1]);
+    });
+
+    // offsets of each chunk in the merged arrays
+    struct Offsets {
+        int verts = 0, uvs = 0, loops = 0, loop_uvs = 0, polys = 0, lines = 0;
+    };
+    std::vector<Offsets> base(chunks.size() + 1);
+    for (std::size_t c = 0; c < chunks.size(); c++) {
+        auto &b = base[c + 1];
+        b = base[c];
+        b.verts += chunks[c].verts.size();
+        b.uvs += chunks[c].uvs.size();
+        b.loops += chunks[c].loops.size();
+        b.loop_uvs += chunks[c].loop_uvs.size();
+        b.polys += chunks[c].polys.size();
+        b.lines += chunks[c].lines.size();
     }
+    auto const &total = base.back();
+
+    // auto prim = std::make_shared<PrimitiveObject>();
+    auto prim = new PrimitiveObject;
+    prim->verts.resize(total.verts);
+    prim->uvs.resize(total.uvs);
+    prim->loops.resize(total.loops);
+    prim->polys.resize(total.polys);
+    prim->lines.resize(total.lines);
+    std::vector<int> loop_uvs(total.loop_uvs);
+
+    parallel_for(chunks.size(), [&] (std::size_t c) {
+        auto &ch = chunks[c];
+        auto const &b = base[c];
+        for (int i: ch.rel_loops) ch.loops[i] += b.verts;
+        for (int i: ch.rel_loop_uvs) ch.loop_uvs[i] += b.uvs;
+        for (int i: ch.rel_lines) ch.lines[i / 2][i % 2] += b.verts;
+        for (auto &poly: ch.polys) poly[0] += b.loops;
+        std::copy(ch.verts.begin(), ch.verts.end(), prim->verts.begin() + b.verts);
+        std::copy(ch.uvs.begin(), ch.uvs.end(), prim->uvs.begin() + b.uvs);
+        std::copy(ch.loops.begin(), ch.loops.end(), prim->loops.begin() + b.loops);
+        std::copy(ch.loop_uvs.begin(), ch.loop_uvs.end(), loop_uvs.begin() + b.loop_uvs);
+        std::copy(ch.polys.begin(), ch.polys.end(), prim->polys.begin() + b.polys);
+        std::copy(ch.lines.begin(), ch.lines.end(), prim->lines.begin() + b.lines);
+        ch = ObjChunk{};
+    });
 
     if (loop_uvs.size() == prim->loops.size()) {
         prim->loops.add_attr<int>("uvs") = std::move(loop_uvs);
@@ -128,12 +199,8 @@ PrimitiveObject* parse_obj(const char *binData, std::size_t binSize) {
 struct ReadObjPrim : INode {
     virtual void apply() override {
         auto path = get_input2<std::string>("path");
-        std::string native_path = std::filesystem::u8path(path).string();
-        std::ifstream file(native_path, std::ios::binary);
-        auto binary = std::vector<char>((std::istreambuf_iterator<char>(file)),
-                              std::istreambuf_iterator<char>());
-        // auto prim = parse_obj(std::move(binary));
-        auto prim = std::shared_ptr<PrimitiveObject>(parse_obj(binary.data(), binary.size()));
+        MappedFile file(path);
+        auto prim = std::shared_ptr<PrimitiveObject>(parse_obj(file.data(), file.size()));
         if (get_param<bool>("triangulate")) {
             primTriangulate(prim.get());
         }
@@ -155,12 +222,12 @@ ZENDEFNODE(ReadObjPrim,
 struct MustReadObjPrim : INode {
     virtual void apply() override {
         auto path = get_input2<std::string>("path");
-        auto binary = file_get_binary<std::vector<char>>(path);
-        if (binary.empty()) {
+        MappedFile file(path);
+        if (!file) {
             auto s = zeno::format("can not find {}", path);
             throw zeno::makeError(s);
         }
-        auto prim = std::shared_ptr<PrimitiveObject>(parse_obj(binary.data(), binary.size()));
+        auto prim = std::shared_ptr<PrimitiveObject>(parse_obj(file.data(), file.size()));
         if (get_param<bool>("triangulate")) {
             primTriangulate(prim.get());
         }
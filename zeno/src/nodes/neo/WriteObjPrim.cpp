@@ -4,45 +4,89 @@
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/vec.h>
 #include <zeno/utils/fileio.h>
+#include <zeno/para/parallel_for.h>
 #include <string_view>
+#include <algorithm>
+#include <charconv>
 #include <fstream>
-#include <iomanip>
+#include <thread>
 
 namespace fs = std::filesystem;
 
 namespace zeno {
 namespace {
 
+void put_float(std::string &s, float x) {
+    char buf[32];
+    auto res = std::to_chars(buf, buf + sizeof buf, x);
+    s.append(buf, res.ptr);
+}
+
+void put_int(std::string &s, int x) {
+    char buf[16];
+    auto res = std::to_chars(buf, buf + sizeof buf, x);
+    s.append(buf, res.ptr);
+}
+
+// formats the n lines in parallel chunks, a bounded batch of them at a time
+template <class F>
+void write_lines(std::ostream &fout, std::size_t n, F const &fmt) {
+    constexpr std::size_t kChunk = 1 << 14;
+    std::size_t nchunks = (n + kChunk - 1) / kChunk;
+    std::size_t nbatch = std::max(1u, std::thread::hardware_concurrency()) * 4;
+    std::vector<std::string> bufs(std::min(nchunks, nbatch));
+    for (std::size_t first = 0; first < nchunks; first += nbatch) {
+        std::size_t last = std::min(nchunks, first + nbatch);
+        parallel_for(first, last, [&] (std::size_t c) {
+            auto &s = bufs[c - first];
+            s.clear();
+            for (std::size_t i = c * kChunk; i < std::min(n, (c + 1) * kChunk); i++) {
+                fmt(s, i);
+            }
+        });
+        for (std::size_t c = first; c < last; c++) {
+            fout.write(bufs[c - first].data(), bufs[c - first].size());
+        }
+    }
+}
+
 void dump_obj(PrimitiveObject *prim, std::ostream &fout) {
     fout << "# https://github.com/zenustech/zeno\n";
-    fout << std::setprecision(8);
-    for (auto const &[x, y, z]: prim->verts) {
-        fout << "v " << x << ' ' << y << ' ' << z << '\n';
-    }
+    write_lines(fout, prim->verts.size(), [&] (std::string &s, std::size_t i) {
+        auto const &[x, y, z] = prim->verts[i];
+        s += "v ";
+        put_float(s, x);
+        s += ' ';
+        put_float(s, y);
+        s += ' ';
+        put_float(s, z);
+        s += '\n';
+    });
+    int const *loop_uvs = nullptr;
     if (prim->loops.size() && prim->loops.has_attr("uvs")) {
-        auto &loop_uvs = prim->loops.attr<int>("uvs");
-        for (auto const &[x, y]: prim->uvs) {
-            fout << "vt " << x << ' ' << y << '\n';
-        }
-        for (auto const &[base, len]: prim->polys) {
-            fout << 'f';
-            for (int j = base; j < base + len; j++) {
-                auto l = prim->loops[j] + 1;
-                auto lt = loop_uvs[j] + 1;
-                fout << ' ' << l << '/' << lt;
-            }
-            fout << '\n';
-        }
-    } else {
-        for (auto const &[base, len]: prim->polys) {
-            fout << 'f';
-            for (int j = base; j < base + len; j++) {
-                auto l = prim->loops[j] + 1;
-                fout << ' ' << l;
+        loop_uvs = prim->loops.attr<int>("uvs").data();
+        write_lines(fout, prim->uvs.size(), [&] (std::string &s, std::size_t i) {
+            auto const &[x, y] = prim->uvs[i];
+            s += "vt ";
+            put_float(s, x);
+            s += ' ';
+            put_float(s, y);
+            s += '\n';
+        });
+    }
+    write_lines(fout, prim->polys.size(), [&] (std::string &s, std::size_t i) {
+        auto const &[base, len] = prim->polys[i];
+        s += 'f';
+        for (int j = base; j < base + len; j++) {
+            s += ' ';
+            put_int(s, prim->loops[j] + 1);
+            if (loop_uvs) {
+                s += '/';
+                put_int(s, loop_uvs[j] + 1);
             }
-            fout << '\n';
         }
-    }
+        s += '\n';
+    });
 }
 
 struct WriteObjPrim : INode {
@@ -54,7 +98,7 @@ struct WriteObjPrim : INode {
         if (get_param<bool>("polygonate")) {
             primPolygonate(prim.get());
         }
-        std::ofstream fout(path);
+        std::ofstream fout(std::filesystem::u8path(path), std::ios::binary);
         dump_obj(prim.get(), fout);
         set_output("prim", std::move(prim));
     }
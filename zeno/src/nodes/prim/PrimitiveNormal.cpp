@@ -4,131 +4,106 @@
 #include <zeno/types/NumericObject.h>
 #include <zeno/types/StringObject.h>
 #include <zeno/utils/vec.h>
-#include <cstring>
-#include <cstdlib>
-#include <cassert>
-#if defined(_OPENMP) && defined(__GNUG__)
-#include <omp.h>
+#include <zeno/para/parallel_for.h>
+#include <algorithm>
+#include <cmath>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
 #endif
 
 namespace zeno {
-// for parallel atomic float add
-template <typename DstT, typename SrcT> constexpr auto reinterpret_bits(SrcT &&val) {
-    using Src = std::remove_cv_t<std::remove_reference_t<SrcT>>;
-    using Dst = std::remove_cv_t<std::remove_reference_t<DstT>>;
-    static_assert(sizeof(Src) == sizeof(Dst),
-                  "Source Type and Destination Type must be of the same size");
-    static_assert(std::is_trivially_copyable_v<Src> && std::is_trivially_copyable_v<Dst>,
-                  "Both types should be trivially copyable.");
-    static_assert(std::alignment_of_v<Src> % std::alignment_of_v<Dst> == 0,
-                  "The original type should at least have an alignment as strict.");
-    Dst dst{};
-    std::memcpy(&dst, const_cast<const Src *>(&val), sizeof(Dst));
-    return dst;
-  }
-ZENO_API void primCalcNormal(zeno::PrimitiveObject* prim, float flip, std::string nrmAttr)
+
+ZENO_API void primCalcNormal(zeno::PrimitiveObject* prim, float flip, std::string nrmAttr, std::string weighting, float cuspAngle)
 {
     auto &nrm = prim->add_attr<zeno::vec3f>(nrmAttr);
-    auto &pos = prim->verts.values;
+    auto const &pos = prim->verts.values;
+    auto topo = primTopology(prim);
+    auto const &faceBegin = topo->faceBegin;
+    auto const &faceVerts = topo->faceVerts;
+    size_t nfaces = topo->numFaces();
+    size_t ncorners = faceVerts.size();
 
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < nrm.size(); i++) {
-        nrm[i] = zeno::vec3f(0);
-    }
-
-#if defined(_OPENMP) && defined(__GNUG__)
-    auto atomicCas = [](int* dest, int expected, int desired) {
-        __atomic_compare_exchange_n(const_cast<int volatile *>(dest), &expected,
-                                    desired, false, __ATOMIC_ACQ_REL,
-                                    __ATOMIC_RELAXED);
-        return expected;
-    };
-    auto atomicFloatAdd = [&](float*dst, float val) {
-        static_assert(sizeof(float) == sizeof(int), "sizeof float != sizeof int");
-        int oldVal = reinterpret_bits<int>(*dst);
-        int newVal = reinterpret_bits<int>(reinterpret_bits<float>(oldVal) + val), readVal{};
-        while ((readVal = atomicCas((int*)dst, oldVal, newVal)) != oldVal) {
-            oldVal = readVal;
-            newVal = reinterpret_bits<int>(reinterpret_bits<float>(readVal) + val);
+    // unit face normals, from the fan cross products so polys get their area vector
+    std::vector<vec3f> faceNrm(nfaces);
+    std::vector<float> faceArea(nfaces);
+    parallel_for(nfaces, [&] (size_t f) {
+        int h0 = faceBegin[f];
+        auto p0 = pos[faceVerts[h0]];
+        vec3f n(0);
+        for (int h = h0 + 1; h + 1 < faceBegin[f + 1]; h++) {
+            n += cross(pos[faceVerts[h]] - p0, pos[faceVerts[h + 1]] - p0);
         }
-        return reinterpret_bits<float>(oldVal);
-    };
-#endif
-
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < prim->tris.size(); i++) {
-        auto ind = prim->tris[i];
-        auto n = cross(pos[ind[1]] - pos[ind[0]], pos[ind[2]] - pos[ind[0]]);
+        faceArea[f] = length(n);
+        faceNrm[f] = normalizeSafe(n);
+    });
 
-#if defined(_OPENMP) && defined(__GNUG__)
-        for (int j = 0; j != 3; ++j) {
-            auto &n_i = nrm[ind[j]];
-            for (int d = 0; d != 3; ++d)
-                atomicFloatAdd(&n_i[d], n[d]);
+    // what each corner adds to the normal of its vertex
+    bool byArea = weighting == "area", byAngle = weighting == "angle";
+    std::vector<vec3f> cornerNrm(ncorners);
+    parallel_for(ncorners, [&] (size_t h) {
+        int f = topo->cornerFace[h];
+        auto p = pos[faceVerts[h]];
+        auto pnext = pos[faceVerts[topo->nextCorner(h)]];
+        if (byArea) {
+            cornerNrm[h] = faceNrm[f] * faceArea[f];
+        } else if (byAngle) {
+            auto pprev = pos[faceVerts[topo->prevCorner(h)]];
+            auto c = dot(normalizeSafe(pnext - p), normalizeSafe(pprev - p));
+            cornerNrm[h] = faceNrm[f] * std::acos(std::clamp(c, -1.f, 1.f));
+        } else {
+            auto pnext2 = pos[faceVerts[topo->nextCorner(topo->nextCorner(h))]];
+            cornerNrm[h] = cross(pnext - p, pnext2 - p);
         }
-#else
-        nrm[ind[0]] += n;
-        nrm[ind[1]] += n;
-        nrm[ind[2]] += n;
-#endif
-    }
+    });
 
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < prim->quads.size(); i++) {
-        auto ind = prim->quads[i];
-        std::array<vec3f, 4> ns = {
-            cross(pos[ind[1]] - pos[ind[0]], pos[ind[2]] - pos[ind[0]]),
-            cross(pos[ind[2]] - pos[ind[1]], pos[ind[3]] - pos[ind[1]]),
-            cross(pos[ind[3]] - pos[ind[2]], pos[ind[0]] - pos[ind[2]]),
-            cross(pos[ind[0]] - pos[ind[3]], pos[ind[1]] - pos[ind[3]]),
-        };
-
-#if defined(_OPENMP) && defined(__GNUG__)
-        for (int j = 0; j != 4; ++j) {
-            auto &n_i = nrm[ind[j]];
-            for (int d = 0; d != 3; ++d)
-                atomicFloatAdd(&n_i[d], ns[j][d]);
-        }
-#else
-        for (int j = 0; j != 4; ++j) {
-            nrm[ind[j]] += ns[j];
+    // gather over the corners at each vertex, each vertex is owned by one task
+    auto gatherCorners = [&] (int v, auto const &accept) {
+        vec3f sum(0);
+        for (int i = topo->vertCornerBegin[v]; i < topo->vertCornerBegin[v + 1]; i++) {
+            int h = topo->vertCorners[i];
+            if (accept(topo->cornerFace[h]))
+                sum += cornerNrm[h];
         }
-#endif
-    }
-
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < prim->polys.size(); i++) {
-        auto [beg, len] = prim->polys[i];
+        return sum;
+    };
+    parallel_for(std::min(nrm.size(), topo->numVerts), [&] (size_t v) {
+        nrm[v] = flip * normalizeSafe(gatherCorners(v, [] (int) { return true; }));
+    });
 
-        auto ind = [loops = prim->loops.data(), beg = beg, len = len] (int t) -> int {
-            if (t >= len) t -= len;
-            return loops[beg + t];
-        };
-        for (int j = 0; j < len; ++j) {
-            auto nsj = cross(pos[ind(j + 1)] - pos[ind(j)], pos[ind(j + 2)] - pos[ind(j)]);
-#if defined(_OPENMP) && defined(__GNUG__)
-            auto &n_i = nrm[ind(j)];
-            for (int d = 0; d != 3; ++d)
-                atomicFloatAdd(&n_i[d], nsj[d]);
-#else
-            nrm[ind(j)] += nsj;
-#endif
-        }
+    // cusp splitting: corners only smooth with the faces within cuspAngle of their own,
+    // the split normals go to per-corner attributes: <nrmAttr>0..2 on tris,
+    // <nrmAttr>0..3 on quads and <nrmAttr> on loops
+    if (cuspAngle <= 0 || cuspAngle >= 180) return;
+    float cosCusp = std::cos(cuspAngle * (float)M_PI / 180);
+    std::vector<vec3f> splitNrm(ncorners);
+    parallel_for(ncorners, [&] (size_t h) {
+        auto nf = faceNrm[topo->cornerFace[h]];
+        splitNrm[h] = flip * normalizeSafe(gatherCorners(faceVerts[h], [&] (int f) {
+            return dot(faceNrm[f], nf) >= cosCusp;
+        }));
+    });
+    size_t ntris = prim->tris.size(), nquads = prim->quads.size();
+    for (int j = 0; j < 3 && ntris; j++) {
+        auto &arr = prim->tris.add_attr<vec3f>(nrmAttr + std::to_string(j));
+        parallel_for(ntris, [&] (size_t i) {
+            arr[i] = splitNrm[faceBegin[i] + j];
+        });
     }
-
-#if defined(_OPENMP) && defined(__GNUG__)
-#pragma omp parallel for
-#endif
-    for (size_t i = 0; i < nrm.size(); i++) {
-        nrm[i] = flip * normalizeSafe(nrm[i]);
+    for (int j = 0; j < 4 && nquads; j++) {
+        auto &arr = prim->quads.add_attr<vec3f>(nrmAttr + std::to_string(j));
+        parallel_for(nquads, [&] (size_t i) {
+            arr[i] = splitNrm[faceBegin[ntris + i] + j];
+        });
+    }
+    if (prim->polys.size()) {
+        auto &arr = prim->loops.add_attr<vec3f>(nrmAttr);
+        parallel_for(prim->polys.size(), [&] (size_t i) {
+            auto [base, len] = prim->polys[i];
+            int h0 = faceBegin[ntris + nquads + i];
+            for (int j = 0; j < len; j++) {
+                arr[base + j] = splitNrm[h0 + j];
+            }
+        });
     }
 }
 struct PrimitiveCalcNormal : zeno::INode {
@@ -136,7 +111,9 @@ struct PrimitiveCalcNormal : zeno::INode {
         auto prim = get_input<PrimitiveObject>("prim");
         auto nrmAttr = get_input<StringObject>("nrmAttr")->get();
         auto flip = get_input<NumericObject>("flip")->get<bool>();
-        primCalcNormal(prim.get(), flip ? -1 : 1, nrmAttr);
+        auto weighting = get_input2<std::string>("weighting");
+        auto cuspAngle = get_input2<bool>("splitCusps") ? get_input2<float>("cuspAngle") : 0.f;
+        primCalcNormal(prim.get(), flip ? -1 : 1, nrmAttr, weighting, cuspAngle);
         set_output("prim", get_input("prim"));
     }
 };
@@ -146,6 +123,9 @@ ZENDEFNODE(PrimitiveCalcNormal, {
     {"prim"},
     {"string", "nrmAttr", "nrm"},
     {"bool", "flip", "0"},
+    {"enum default area angle", "weighting", "default"},
+    {"bool", "splitCusps", "0"},
+    {"float", "cuspAngle", "60"},
     },
     {"prim"},
     {},
@@ -69,91 +69,79 @@ ZENO_API void primTriangulate(PrimitiveObject *prim, bool with_uv, bool has_line
         mapping.resize(tribase + redsum);
     }
 
-    if (!(prim->loops.has_attr("uvs") && prim->uvs.size() > 0) || !with_uv) {
-        parallel_for(prim->polys.size(), [&] (size_t i) {
-            auto [start, len] = prim->polys[i];
+    bool has_uv = prim->loops.has_attr("uvs") && prim->uvs.size() > 0 && with_uv;
+    int const *loop_uv = has_uv ? prim->loops.attr<int>("uvs").data() : nullptr;
+    vec3f *uv0 = has_uv ? prim->tris.add_attr<zeno::vec3f>("uv0").data() : nullptr;
+    vec3f *uv1 = has_uv ? prim->tris.add_attr<zeno::vec3f>("uv1").data() : nullptr;
+    vec3f *uv2 = has_uv ? prim->tris.add_attr<zeno::vec3f>("uv2").data() : nullptr;
+    auto uvAt = [&] (int l) {
+        auto uv = prim->uvs[loop_uv[l]];
+        return vec3f(uv[0], uv[1], 0);
+    };
 
-            if (len >= 3) {
-                int scanbase;
-                if constexpr (has_lines.value) {
-                    scanbase = scansum[i][0] + tribase;
-                } else {
-                    scanbase = scansum[i] + tribase;
-                }
-                prim->tris[scanbase] = vec3i(
-                        prim->loops[start],
-                        prim->loops[start + 1],
-                        prim->loops[start + 2]);
-                mapping[scanbase] = i;
-                scanbase++;
-                for (int j = 3; j < len; j++) {
-                    prim->tris[scanbase] = vec3i(
-                            prim->loops[start],
-                            prim->loops[start + j - 1],
-                            prim->loops[start + j]);
-                    mapping[scanbase] = i;
-                    scanbase++;
-                }
-            }
+    parallel_for(prim->polys.size(), [&] (size_t i) {
+        auto [start, len] = prim->polys[i];
+
+        if (len >= 3) {
+            int scanbase;
             if constexpr (has_lines.value) {
-                if (len == 2) {
-                    int scanbase = scansum[i][1] + linebase;
-                    prim->lines[scanbase] = vec2i(
-                        prim->loops[start],
-                        prim->loops[start + 1]);
-                }
+                scanbase = scansum[i][0] + tribase;
+            } else {
+                scanbase = scansum[i] + tribase;
             }
-        });
-
-    } else {
-        auto &loop_uv = prim->loops.attr<int>("uvs");
-        auto &uvs = prim->uvs;
-        auto &uv0 = prim->tris.add_attr<zeno::vec3f>("uv0");
-        auto &uv1 = prim->tris.add_attr<zeno::vec3f>("uv1");
-        auto &uv2 = prim->tris.add_attr<zeno::vec3f>("uv2");
-
-        parallel_for(prim->polys.size(), [&] (size_t i) {
-            auto [start, len] = prim->polys[i];
-
-            if (len >= 3) {
-                int scanbase;
-                if constexpr (has_lines.value) {
-                    scanbase = scansum[i][0] + tribase;
-                } else {
-                    scanbase = scansum[i] + tribase;
-                }
-                uv0[scanbase] = {uvs[loop_uv[start]][0], uvs[loop_uv[start]][1], 0};
-                uv1[scanbase] = {uvs[loop_uv[start + 1]][0], uvs[loop_uv[start + 1]][1], 0};
-                uv2[scanbase] = {uvs[loop_uv[start + 2]][0], uvs[loop_uv[start + 2]][1], 0};
+            auto emit = [&] (int c0, int c1, int c2) {
                 prim->tris[scanbase] = vec3i(
-                        prim->loops[start],
-                        prim->loops[start + 1],
-                        prim->loops[start + 2]);
+                        prim->loops[start + c0],
+                        prim->loops[start + c1],
+                        prim->loops[start + c2]);
+                if (has_uv) {
+                    uv0[scanbase] = uvAt(start + c0);
+                    uv1[scanbase] = uvAt(start + c1);
+                    uv2[scanbase] = uvAt(start + c2);
+                }
                 mapping[scanbase] = i;
                 scanbase++;
-                for (int j = 3; j < len; j++) {
-                    uv0[scanbase] = {uvs[loop_uv[start]][0], uvs[loop_uv[start]][1], 0};
-                    uv1[scanbase] = {uvs[loop_uv[start + j - 1]][0], uvs[loop_uv[start + j - 1]][1], 0};
-                    uv2[scanbase] = {uvs[loop_uv[start + j]][0], uvs[loop_uv[start + j]][1], 0};
-                    prim->tris[scanbase] = vec3i(
-                            prim->loops[start],
-                            prim->loops[start + j - 1],
-                            prim->loops[start + j]);
-                    mapping[scanbase] = i;
-                    scanbase++;
+            };
+            // a quad folds over only when its diagonal 0-2 lies outside, then 1-3 is inside
+            auto quadSplit = [&] {
+                auto const *l = prim->loops.data() + start;
+                auto p0 = prim->verts[l[0]], p1 = prim->verts[l[1]];
+                auto p2 = prim->verts[l[2]], p3 = prim->verts[l[3]];
+                if (dot(cross(p1 - p0, p2 - p0), cross(p2 - p0, p3 - p0)) >= 0)
+                    return 0;
+                if (dot(cross(p2 - p1, p3 - p1), cross(p3 - p1, p0 - p1)) > 0)
+                    return 1;
+                return -1;
+            };
+            int split = len == 4 ? quadSplit() : -1;
+            if (len == 3) {
+                emit(0, 1, 2);
+            } else if (split == 0) {
+                emit(0, 1, 2);
+                emit(0, 2, 3);
+            } else if (split == 1) {
+                emit(0, 1, 3);
+                emit(1, 2, 3);
+            } else {
+                // concave polygons would fold over with a plain fan, each one still
+                // makes len - 2 triangles so the slots from the scan stay valid
+                static thread_local std::vector<vec3i> corners;
+                polygonTriangulate(prim->verts.data(), prim->loops.data() + start, len, corners);
+                for (auto const &c: corners) {
+                    emit(c[0], c[1], c[2]);
                 }
             }
-            if constexpr (has_lines.value) {
-                if (len == 2) {
-                    int scanbase = scansum[i][1] + linebase;
-                    prim->lines[scanbase] = vec2i(
-                        prim->loops[start],
-                        prim->loops[start + 1]);
-                }
+        }
+        if constexpr (has_lines.value) {
+            if (len == 2) {
+                int scanbase = scansum[i][1] + linebase;
+                prim->lines[scanbase] = vec2i(
+                    prim->loops[start],
+                    prim->loops[start + 1]);
             }
-        });
+        }
+    });
 
-    }
     if (with_attr) {
         prim->polys.foreach_attr<AttrAcceptAll>([&](auto const &key, auto &arr) {
           using T = std::decay_t<decltype(arr[0])>;
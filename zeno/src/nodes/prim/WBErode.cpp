@@ -9,6 +9,7 @@
 #include <zeno/utils/parallel_reduce.h>
 #include <zeno/types/ListObject.h>
 #include <zeno/utils/log.h>
+#include <algorithm>
 #include <random>
 #include <vector>
 
@@ -123,29 +124,54 @@ ZENDEFNODE(erode_value2cond,
                    "erode",
                }});
 
+// order of the 8 colors (passes) in one erosion iteration
+static void erode_rand_perm(int iterations, int iter, int perm[8]) {
+    std::uniform_real_distribution<float> distr(0.0, 1.0);
+    for (int i = 0; i < 8; i++)
+        perm[i] = i + 1;
+    for (int i = 0; i < 8; i++)
+    {
+        vec2f vec;
+        std::mt19937 mt(iterations * iter * 8 * i + i);
+        vec[0] = distr(mt);
+        vec[1] = distr(mt);
+
+        int idx1 = floor(vec[0] * 8);
+        int idx2 = floor(vec[1] * 8);
+        idx1 = idx1 == 8 ? 7 : idx1;
+        idx2 = idx2 == 8 ? 7 : idx2;
+
+        int temp = perm[idx1];
+        perm[idx1] = perm[idx2];
+        perm[idx2] = temp;
+    }
+}
+
+// x and z directions (+1 or -1) of one erosion iteration
+static void erode_rand_dirs(int iterations, int iter, int dirs[2]) {
+    std::uniform_real_distribution<float> distr(0.0, 1.0);
+    for (int i = 0; i < 2; i++)
+    {
+        std::mt19937 mt(iterations * iter * 2 * i + i);
+        float rand_val = distr(mt);
+        if (rand_val > 0.5)
+        {
+            dirs[i] = 1;
+        }
+        else
+        {
+            dirs[i] = -1;
+        }
+    }
+}
+
 struct erode_rand_color : INode {
     void apply() override {
-        std::uniform_real_distribution<float> distr(0.0, 1.0);
         auto iterations = get_input<NumericObject>("iterations")->get<int>();
         auto iter       = get_input<NumericObject>("iter")->get<int>();
 
-        int perm[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
-        for (int i = 0; i < 8; i++)
-        {
-            vec2f vec;
-            std::mt19937 mt(iterations * iter * 8 * i + i);
-            vec[0] = distr(mt);
-            vec[1] = distr(mt);
-
-            int idx1 = floor(vec[0] * 8);
-            int idx2 = floor(vec[1] * 8);
-            idx1 = idx1 == 8 ? 7 : idx1;
-            idx2 = idx2 == 8 ? 7 : idx2;
-
-            int temp = perm[idx1];
-            perm[idx1] = perm[idx2];
-            perm[idx2] = temp;
-        }
+        int perm[8];
+        erode_rand_perm(iterations, iter, perm);
 
         auto list = std::make_shared<zeno::ListObject>();
         for (int i = 0; i < 8; i++)
@@ -177,25 +203,11 @@ ZENDEFNODE(erode_rand_color,
 
 struct erode_rand_dir : INode {
     void apply() override {
-
-        std::uniform_real_distribution<float> distr(0.0, 1.0);
         auto iterations = get_input<NumericObject>("iterations")->get<int>();
         auto iter       = get_input<NumericObject>("iter")->get<int>();
 
-        int dirs[] = { -1, -1 };
-        for (int i = 0; i < 2; i++)
-        {
-            std::mt19937 mt(iterations * iter * 2 * i + i);
-            float rand_val = distr(mt);
-            if (rand_val > 0.5)
-            {
-                dirs[i] = 1;
-            }
-            else
-            {
-                dirs[i] = -1;
-            }
-        }
+        int dirs[2];
+        erode_rand_dirs(iterations, iter, dirs);
 
         auto list = std::make_shared<zeno::ListObject>();
         for (int i = 0; i < 2; i++)
@@ -221,6 +233,214 @@ ZENDEFNODE(erode_rand_dir,
                    "erode",
                }});
 
+// inputs of one thermal erosion pass (erode_tumble_material_erosion), the
+// heights and debris are read from _temp_* and written to _height/_debris
+struct ErodeThermalParams {
+    int nx, nz;
+    float cellSize;
+    float seed;
+    int openborder;
+    float maxdepth, global_erosionrate, erosionrate;
+    float cut_angle, erodability, removalrate, gridbias;
+    float const *_cutanglemask, *_erodabilitymask, *_removalratemask, *_gridbiasmask;
+    float const *_temp_height, *_temp_debris;
+    float *_height, *_debris;
+};
+
+// erodes one cell if it has the given color, cells of the same color only
+// write to themselves or to a neighbour of another color, so the cells of a
+// pass can be visited in any order and in parallel with the same result
+static void erode_thermal_cell(ErodeThermalParams const &params, int id_x, int id_z, int color, int iterseed,
+                               int const *dxs, int const *dzs)
+{
+    int is_red = ((id_z & 1) == 1) && (color == 1);
+    int is_green = ((id_x & 1) == 1) && (color == 2);
+    int is_blue = ((id_z & 1) == 0) && (color == 3);
+    int is_yellow = ((id_x & 1) == 0) && (color == 4);
+    int is_x_turn_x = ((id_x & 1) == 1) && ((color == 5) || (color == 6));
+    int is_x_turn_y = ((id_x & 1) == 0) && ((color == 7) || (color == 8));
+    if (!(is_red || is_green || is_blue || is_yellow || is_x_turn_x || is_x_turn_y))
+        return;
+
+    int nx = params.nx, nz = params.nz;
+    float cellSize = params.cellSize;
+    float seed = params.seed;
+    int openborder = params.openborder;
+    float maxdepth = params.maxdepth;
+    float global_erosionrate = params.global_erosionrate;
+    float erosionrate = params.erosionrate;
+    float cut_angle = params.cut_angle;
+    float erodability = params.erodability;
+    float removalrate = params.removalrate;
+    float gridbias = params.gridbias;
+    float const *_cutanglemask = params._cutanglemask;
+    float const *_erodabilitymask = params._erodabilitymask;
+    float const *_removalratemask = params._removalratemask;
+    float const *_gridbiasmask = params._gridbiasmask;
+    float const *_temp_height = params._temp_height;
+    float const *_temp_debris = params._temp_debris;
+    float *_height = params._height;
+    float *_debris = params._debris;
+
+    int idx = Pos2Idx(id_x, id_z, nx);
+    int dx = dxs[color - 1];
+    int dz = dzs[color - 1];
+    int bound_x = nx;
+    int bound_z = nz;
+    int clamp_x = bound_x - 1;
+    int clamp_z = bound_z - 1;
+
+    float i_debris = _temp_debris[idx];
+    float i_height = _temp_height[idx];
+
+    int samplex = clamp(id_x + dx, 0, clamp_x);
+    int samplez = clamp(id_z + dz, 0, clamp_z);
+    int validsource = (samplex == id_x + dx) && (samplez == id_z + dz);
+    if (validsource)
+    {
+        validsource = validsource || !openborder;
+        int j_idx = Pos2Idx(samplex, samplez, nx);
+        float j_debris = validsource ? _temp_debris[j_idx] : 0.0f;
+        float j_height = _temp_height[j_idx];
+
+        int cidx = 0;
+        int cidz = 0;
+
+        float c_height = 0.0f;
+        float c_debris = 0.0f;
+        float n_debris = 0.0f;
+
+        int c_idx = 0;
+        int n_idx = 0;
+
+        int dx_check = 0;
+        int dz_check = 0;
+
+        float h_diff = 0.0f;
+
+        if ((j_height - i_height) > 0.0f)
+        {
+            cidx = samplex;
+            cidz = samplez;
+
+            c_height = j_height;
+            c_debris = j_debris;
+            n_debris = i_debris;
+
+            c_idx = j_idx;
+            n_idx = idx;
+
+            dx_check = -dx;
+            dz_check = -dz;
+
+            h_diff = j_height - i_height;
+        }
+        else
+        {
+            cidx = id_x;
+            cidz = id_z;
+
+            c_height = i_height;
+            c_debris = i_debris;
+            n_debris = j_debris;
+
+            c_idx = idx;
+            n_idx = j_idx;
+
+            dx_check = dx;
+            dz_check = dz;
+
+            h_diff = i_height - j_height;
+        }
+
+        float max_diff = 0.0f;
+        float dir_prob = 0.0f;
+        float c_gridbiasmask = _gridbiasmask[c_idx];
+        for (int tmp_dz = -1; tmp_dz <= 1; tmp_dz++)
+        {
+            for (int tmp_dx = -1; tmp_dx <= 1; tmp_dx++)
+            {
+                if (!tmp_dx && !tmp_dz)
+                    continue;
+
+                int tmp_samplex = clamp(cidx + tmp_dx, 0, clamp_x);
+                int tmp_samplez = clamp(cidz + tmp_dz, 0, clamp_z);
+                int tmp_validsource = (tmp_samplex == (cidx + tmp_dx)) && (tmp_samplez == (cidz + tmp_dz));
+                tmp_validsource = tmp_validsource || !openborder;
+                int tmp_j_idx = Pos2Idx(tmp_samplex, tmp_samplez, nx);
+
+                float n_height = _temp_height[tmp_j_idx];
+
+                float tmp_diff = n_height - (c_height);
+
+                //float _gridbias = clamp(gridbias, -1.0f, 1.0f);
+                float _gridbias = clamp(gridbias * c_gridbiasmask, -1.0f, 1.0f);
+
+                if (tmp_dx && tmp_dz)
+                    tmp_diff *= clamp(1.0f - _gridbias, 0.0f, 1.0f) / 1.4142136f;
+                else
+                    tmp_diff *= clamp(1.0f + _gridbias, 0.0f, 1.0f);
+
+                if (tmp_diff <= 0.0f)
+                {
+                    if ((dx_check == tmp_dx) && (dz_check == tmp_dz))
+                        dir_prob = tmp_diff;
+                    if (tmp_diff < max_diff)
+                        max_diff = tmp_diff;
+                }
+            }
+        }
+        if (max_diff > 0.001f || max_diff < -0.001f)
+            dir_prob = dir_prob / max_diff;
+
+        int cond = 0;
+        if (dir_prob >= 1.0f)
+            cond = 1;
+        else
+        {
+            dir_prob = dir_prob * dir_prob * dir_prob * dir_prob;
+            unsigned int cutoff = (unsigned int)(dir_prob * 4294967295.0);
+            unsigned int randval = erode_random(seed, (idx + nx * nz) * 8 + color + iterseed);
+            cond = randval < cutoff;
+        }
+
+        if (cond)
+        {
+            float abs_h_diff = h_diff < 0.0f ? -h_diff : h_diff;
+            //float _cut_angle = clamp(cut_angle, 0.0f, 90.0f);
+            float _cut_angle = clamp(cut_angle * _cutanglemask[n_idx], 0.0f, 90.0f);
+            float delta_x = cellSize * (dx && dz ? 1.4142136f : 1.0f);
+            float height_removed = _cut_angle < 90.0f ? tan(_cut_angle * M_PI / 180) * delta_x : 1e10f;
+            float height_diff = abs_h_diff - height_removed;
+            if (height_diff < 0.0f)
+                height_diff = 0.0f;
+            float prob = ((n_debris + c_debris) != 0.0f) ? clamp((height_diff / (n_debris + c_debris)), 0.0f, 1.0f) : 1.0f;
+            unsigned int cutoff = (unsigned int)(prob * 4294967295.0);
+            unsigned int randval = erode_random(seed * 3.14, (idx + nx * nz) * 8 + color + iterseed);
+            int do_erode = randval < cutoff;
+
+            float height_removal_amt = do_erode * clamp(global_erosionrate * erosionrate * erodability * _erodabilitymask[c_idx], 0.0f, height_diff);
+
+            _height[c_idx] -= height_removal_amt;
+
+            //float bedrock_density = 1.0f - (removalrate);
+            float bedrock_density = 1.0f - (removalrate * _removalratemask[c_idx]);
+            if (bedrock_density > 0.0f)
+            {
+                float newdebris = bedrock_density * height_removal_amt;
+                if (n_debris + newdebris > maxdepth)
+                {
+                    float rollback = n_debris + newdebris - maxdepth;
+                    rollback = min(rollback, newdebris);
+                    _height[c_idx] += rollback / bedrock_density;
+                    newdebris -= rollback;
+                }
+                _debris[c_idx] += newdebris;
+            }
+        }
+    }
+}
+
 // thermal erosion NOT slump                        用于子图：Erode_Thermal                  thermal_erosion
 struct erode_tumble_material_erosion : INode {
     void apply() override {
@@ -318,180 +538,179 @@ struct erode_tumble_material_erosion : INode {
         // 计算
         ////////////////////////////////////////////////////////////////////////////////////////
 
+        ErodeThermalParams params{nx, nz, cellSize, seed, openborder, maxdepth, global_erosionrate, erosionrate,
+                                  cut_angle, erodability, removalrate, gridbias,
+                                  _cutanglemask.data(), _erodabilitymask.data(), _removalratemask.data(),
+                                  _gridbiasmask.data(), _temp_height.data(), _temp_debris.data(),
+                                  _height.data(), _debris.data()};
+        int iterseed = iter * 134775813;
+        int color = perm[i];
+        int dxs[] = { 0, p_dirs[0], 0, p_dirs[0], x_dirs[0], x_dirs[1], x_dirs[0], x_dirs[1] };
+        int dzs[] = { p_dirs[1], 0, p_dirs[1], 0, x_dirs[0],-x_dirs[1], x_dirs[0],-x_dirs[1] };
+
 #pragma omp parallel for
         for (int id_z = 0; id_z < nz; id_z++)
         {
             for (int id_x = 0; id_x < nx; id_x++)
             {
-                int iterseed = iter * 134775813;
-                int color = perm[i];
-
-                int is_red = ((id_z & 1) == 1) && (color == 1);
-                int is_green = ((id_x & 1) == 1) && (color == 2);
-                int is_blue = ((id_z & 1) == 0) && (color == 3);
-                int is_yellow = ((id_x & 1) == 0) && (color == 4);
-                int is_x_turn_x = ((id_x & 1) == 1) && ((color == 5) || (color == 6));
-                int is_x_turn_y = ((id_x & 1) == 0) && ((color == 7) || (color == 8));
-                int dxs[] = { 0, p_dirs[0], 0, p_dirs[0], x_dirs[0], x_dirs[1], x_dirs[0], x_dirs[1] };
-                int dzs[] = { p_dirs[1], 0, p_dirs[1], 0, x_dirs[0],-x_dirs[1], x_dirs[0],-x_dirs[1] };
-
-                if (is_red || is_green || is_blue || is_yellow || is_x_turn_x || is_x_turn_y)
-                {
-                    int idx = Pos2Idx(id_x, id_z, nx);
-                    int dx = dxs[color - 1];
-                    int dz = dzs[color - 1];
-                    int bound_x = nx;
-                    int bound_z = nz;
-                    int clamp_x = bound_x - 1;
-                    int clamp_z = bound_z - 1;
-
-                    float i_debris = _temp_debris[idx];
-                    float i_height = _temp_height[idx];
-
-                    int samplex = clamp(id_x + dx, 0, clamp_x);
-                    int samplez = clamp(id_z + dz, 0, clamp_z);
-                    int validsource = (samplex == id_x + dx) && (samplez == id_z + dz);
-                    if (validsource)
-                    {
-                        validsource = validsource || !openborder;
-                        int j_idx = Pos2Idx(samplex, samplez, nx);
-                        float j_debris = validsource ? _temp_debris[j_idx] : 0.0f;
-                        float j_height = _temp_height[j_idx];
-
-                        int cidx = 0;
-                        int cidz = 0;
-
-                        float c_height = 0.0f;
-                        float c_debris = 0.0f;
-                        float n_debris = 0.0f;
-
-                        int c_idx = 0;
-                        int n_idx = 0;
-
-                        int dx_check = 0;
-                        int dz_check = 0;
-
-                        float h_diff = 0.0f;
+                erode_thermal_cell(params, id_x, id_z, color, iterseed, dxs, dzs);
+            }
+        }
 
-                        if ((j_height - i_height) > 0.0f)
-                        {
-                            cidx = samplex;
-                            cidz = samplez;
+        set_output("prim_2DGrid", std::move(terrain));
+    }
+};
+ZENDEFNODE(erode_tumble_material_erosion,
+           {/* inputs: */ {
+                   "prim_2DGrid",
 
-                            c_height = j_height;
-                            c_debris = j_debris;
-                            n_debris = i_debris;
+                   {"ListObject", "perm"},
+                   {"ListObject", "p_dirs"},
+                   {"ListObject", "x_dirs"},
 
-                            c_idx = j_idx;
-                            n_idx = idx;
+                   {"float", "seed", "9676.79"},
+                   {"int", "iterations", "0"},
+                   {"int", "iter", "0"},
+                   {"int", "i", "0"},
 
-                            dx_check = -dx;
-                            dz_check = -dz;
+                   {"int", "openborder", "0"},
+                   {"float", "maxdepth", "5.0"},
+                   {"float", "global_erosionrate", "1.0"},
+                   {"float", "erosionrate", "0.03"},
 
-                            h_diff = j_height - i_height;
-                        }
-                        else
-                        {
-                            cidx = id_x;
-                            cidz = id_z;
+                   {"float", "cutangle", "35"},
+                   {"string", "cutangle_mask_layer", "cutangle_mask"},
 
-                            c_height = i_height;
-                            c_debris = i_debris;
-                            n_debris = j_debris;
+                   {"float", "erodability", "0.4"},
+                   {"string", "erodability_mask_layer", "erodability_mask"},
 
-                            c_idx = idx;
-                            n_idx = j_idx;
+                   {"float", "removalrate", "0.7"},
+                   {"string", "removalrate_mask_layer", "removalrate_mask"},
 
-                            dx_check = dx;
-                            dz_check = dz;
+                   {"float", "gridbias", "0.0"},
+                   {"string", "gridbias_mask_layer", "gridbias_mask"},
+               },
+               /* outputs: */
+               {
+                   "prim_2DGrid",
+               },
+               /* params: */
+               {
 
-                            h_diff = i_height - j_height;
-                        }
+               },
+               /* category: */
+               {
+                   "erode",
+               }});
 
-                        float max_diff = 0.0f;
-                        float dir_prob = 0.0f;
-                        float c_gridbiasmask = _gridbiasmask[c_idx];
-                        for (int tmp_dz = -1; tmp_dz <= 1; tmp_dz++)
-                        {
-                            for (int tmp_dx = -1; tmp_dx <= 1; tmp_dx++)
-                            {
-                                if (!tmp_dx && !tmp_dz)
-                                    continue;
+// thermal erosion, all iterations in one node      代替子图：Erode_Thermal 的迭代循环
+// each iteration runs the 8 color passes of erode_tumble_material_erosion in
+// the order given by erode_rand_color, p_dirs and x_dirs come from
+// erode_rand_dir with iter and iter + iterations; the grid is walked in
+// square tiles so the 3x3 neighbourhoods stay in cache, and since the passes
+// only depend on the seed the result doesn't depend on the thread count
+struct erode_tumble_material_erosion_iterations : INode {
+    void apply() override {
 
-                                int tmp_samplex = clamp(cidx + tmp_dx, 0, clamp_x);
-                                int tmp_samplez = clamp(cidz + tmp_dz, 0, clamp_z);
-                                int tmp_validsource = (tmp_samplex == (cidx + tmp_dx)) && (tmp_samplez == (cidz + tmp_dz));
-                                tmp_validsource = tmp_validsource || !openborder;
-                                int tmp_j_idx = Pos2Idx(tmp_samplex, tmp_samplez, nx);
+        ////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////
+        // 初始化
+        ////////////////////////////////////////////////////////////////////////////////////////
 
-                                float n_height = _temp_height[tmp_j_idx];
+        // 初始化网格
+        auto terrain = get_input<PrimitiveObject>("prim_2DGrid");
+        int nx, nz;
+        auto &ud = terrain->userData();
+        if ((!ud.has<int>("nx")) || (!ud.has<int>("nz")))
+            zeno::log_error("no such UserData named '{}' and '{}'.", "nx", "nz");
+        nx = ud.get2<int>("nx");
+        nz = ud.get2<int>("nz");
+        auto &pos = terrain->verts;
+        vec3f p0 = pos[0];
+        vec3f p1 = pos[1];
+        float cellSize = length(p1 - p0);
 
-                                float tmp_diff = n_height - (c_height);
+        // 获取面板参数
+        auto gridbias = get_input2<float>("gridbias");
+        auto cut_angle = get_input2<float>("cutangle");
+        auto global_erosionrate = get_input2<float>("global_erosionrate");
+        auto erosionrate = get_input2<float>("erosionrate");
+        auto erodability = get_input2<float>("erodability");
+        auto removalrate = get_input2<float>("removalrate");
+        auto maxdepth = get_input2<float>("maxdepth");
+        auto seed = get_input2<float>("seed");
+        auto iterations = get_input2<int>("iterations");
+        auto openborder = get_input2<int>("openborder");
+        auto tileSize = std::max(get_input2<int>("tileSize"), 8) & ~1; // even, so tiles keep the row/column parity
+
+        // 如果 mask 属性不存在，则添加此属性，且初始化为 1.0
+        auto &_erodabilitymask = terrain->add_attr<float>(get_input2<std::string>("erodability_mask_layer"), 1.0f);
+        auto &_removalratemask = terrain->add_attr<float>(get_input2<std::string>("removalrate_mask_layer"), 1.0f);
+        auto &_cutanglemask = terrain->add_attr<float>(get_input2<std::string>("cutangle_mask_layer"), 1.0f);
+        auto &_gridbiasmask = terrain->add_attr<float>(get_input2<std::string>("gridbias_mask_layer"), 1.0f);
+
+        // 存放地质特征的属性，备份用的临时数据不再需要 _temp_height、_temp_debris 属性
+        if (!terrain->verts.has_attr("_height") || !terrain->verts.has_attr("_debris")) {
+            zeno::log_error("Node [erode_tumble_material_erosion_iterations], no such data layer named '{}' or '{}'.",
+                            "_height", "_debris");
+        }
+        auto &_height = terrain->verts.attr<float>("_height");
+        auto &_debris = terrain->verts.attr<float>("_debris");
+        std::vector<float> _temp_height(_height.size());
+        std::vector<float> _temp_debris(_debris.size());
 
-                                //float _gridbias = clamp(gridbias, -1.0f, 1.0f);
-                                float _gridbias = clamp(gridbias * c_gridbiasmask, -1.0f, 1.0f);
 
-                                if (tmp_dx && tmp_dz)
-                                    tmp_diff *= clamp(1.0f - _gridbias, 0.0f, 1.0f) / 1.4142136f;
-                                else
-                                    tmp_diff *= clamp(1.0f + _gridbias, 0.0f, 1.0f);
+        ////////////////////////////////////////////////////////////////////////////////////////
+        ////////////////////////////////////////////////////////////////////////////////////////
+        // 计算
+        ////////////////////////////////////////////////////////////////////////////////////////
 
-                                if (tmp_diff <= 0.0f)
-                                {
-                                    if ((dx_check == tmp_dx) && (dz_check == tmp_dz))
-                                        dir_prob = tmp_diff;
-                                    if (tmp_diff < max_diff)
-                                        max_diff = tmp_diff;
-                                }
-                            }
-                        }
-                        if (max_diff > 0.001f || max_diff < -0.001f)
-                            dir_prob = dir_prob / max_diff;
+        ErodeThermalParams params{nx, nz, cellSize, seed, openborder, maxdepth, global_erosionrate, erosionrate,
+                                  cut_angle, erodability, removalrate, gridbias,
+                                  _cutanglemask.data(), _erodabilitymask.data(), _removalratemask.data(),
+                                  _gridbiasmask.data(), _temp_height.data(), _temp_debris.data(),
+                                  _height.data(), _debris.data()};
+        int ntx = (nx + tileSize - 1) / tileSize;
+        int ntz = (nz + tileSize - 1) / tileSize;
+        int ncells = nx * nz;
+
+        // one parallel region for the whole run, the implicit barrier after
+        // each omp for separates the backup from the pass that reads it
+#pragma omp parallel
+        for (int iter = 1; iter <= iterations; iter++)
+        {
+            int perm[8], p_dirs[2], x_dirs[2];
+            erode_rand_perm(iterations, iter, perm);
+            erode_rand_dirs(iterations, iter, p_dirs);
+            erode_rand_dirs(iterations, iter + iterations, x_dirs);
+            int iterseed = iter * 134775813;
+            int dxs[] = { 0, p_dirs[0], 0, p_dirs[0], x_dirs[0], x_dirs[1], x_dirs[0], x_dirs[1] };
+            int dzs[] = { p_dirs[1], 0, p_dirs[1], 0, x_dirs[0],-x_dirs[1], x_dirs[0],-x_dirs[1] };
+
+            for (int i = 0; i < 8; i++)
+            {
+                int color = perm[i];
+                // only every other row (red, blue) or column (the others) has this color
+                int z_first = color == 1 ? 1 : 0, z_step = color == 1 || color == 3 ? 2 : 1;
+                int x_first = color == 2 || color == 5 || color == 6 ? 1 : 0, x_step = color <= 3 && color != 2 ? 1 : 2;
 
-                        int cond = 0;
-                        if (dir_prob >= 1.0f)
-                            cond = 1;
-                        else
-                        {
-                            dir_prob = dir_prob * dir_prob * dir_prob * dir_prob;
-                            unsigned int cutoff = (unsigned int)(dir_prob * 4294967295.0);
-                            unsigned int randval = erode_random(seed, (idx + nx * nz) * 8 + color + iterseed);
-                            cond = randval < cutoff;
-                        }
+#pragma omp for schedule(static)
+                for (int idx = 0; idx < ncells; idx++)
+                {
+                    _temp_height[idx] = _height[idx];
+                    _temp_debris[idx] = _debris[idx];
+                }
 
-                        if (cond)
+#pragma omp for schedule(static)
+                for (int tile = 0; tile < ntx * ntz; tile++)
+                {
+                    int x0 = tile % ntx * tileSize, x1 = std::min(x0 + tileSize, nx);
+                    int z0 = tile / ntx * tileSize, z1 = std::min(z0 + tileSize, nz);
+                    for (int id_z = z0 + z_first; id_z < z1; id_z += z_step)
+                    {
+                        for (int id_x = x0 + x_first; id_x < x1; id_x += x_step)
                         {
-                            float abs_h_diff = h_diff < 0.0f ? -h_diff : h_diff;
-                            //float _cut_angle = clamp(cut_angle, 0.0f, 90.0f);
-                            float _cut_angle = clamp(cut_angle * _cutanglemask[n_idx], 0.0f, 90.0f);
-                            float delta_x = cellSize * (dx && dz ? 1.4142136f : 1.0f);
-                            float height_removed = _cut_angle < 90.0f ? tan(_cut_angle * M_PI / 180) * delta_x : 1e10f;
-                            float height_diff = abs_h_diff - height_removed;
-                            if (height_diff < 0.0f)
-                                height_diff = 0.0f;
-                            float prob = ((n_debris + c_debris) != 0.0f) ? clamp((height_diff / (n_debris + c_debris)), 0.0f, 1.0f) : 1.0f;
-                            unsigned int cutoff = (unsigned int)(prob * 4294967295.0);
-                            unsigned int randval = erode_random(seed * 3.14, (idx + nx * nz) * 8 + color + iterseed);
-                            int do_erode = randval < cutoff;
-
-                            float height_removal_amt = do_erode * clamp(global_erosionrate * erosionrate * erodability * _erodabilitymask[c_idx], 0.0f, height_diff);
-
-                            _height[c_idx] -= height_removal_amt;
-
-                            //float bedrock_density = 1.0f - (removalrate);
-                            float bedrock_density = 1.0f - (removalrate * _removalratemask[c_idx]);
-                            if (bedrock_density > 0.0f)
-                            {
-                                float newdebris = bedrock_density * height_removal_amt;
-                                if (n_debris + newdebris > maxdepth)
-                                {
-                                    float rollback = n_debris + newdebris - maxdepth;
-                                    rollback = min(rollback, newdebris);
-                                    _height[c_idx] += rollback / bedrock_density;
-                                    newdebris -= rollback;
-                                }
-                                _debris[c_idx] += newdebris;
-                            }
+                            erode_thermal_cell(params, id_x, id_z, color, iterseed, dxs, dzs);
                         }
                     }
                 }
@@ -501,18 +720,12 @@ struct erode_tumble_material_erosion : INode {
         set_output("prim_2DGrid", std::move(terrain));
     }
 };
-ZENDEFNODE(erode_tumble_material_erosion,
+ZENDEFNODE(erode_tumble_material_erosion_iterations,
            {/* inputs: */ {
                    "prim_2DGrid",
 
-                   {"ListObject", "perm"},
-                   {"ListObject", "p_dirs"},
-                   {"ListObject", "x_dirs"},
-
                    {"float", "seed", "9676.79"},
-                   {"int", "iterations", "0"},
-                   {"int", "iter", "0"},
-                   {"int", "i", "0"},
+                   {"int", "iterations", "10"},
 
                    {"int", "openborder", "0"},
                    {"float", "maxdepth", "5.0"},
@@ -530,6 +743,8 @@ ZENDEFNODE(erode_tumble_material_erosion,
 
                    {"float", "gridbias", "0.0"},
                    {"string", "gridbias_mask_layer", "gridbias_mask"},
+
+                   {"int", "tileSize", "256"},
                },
                /* outputs: */
                {
@@ -0,0 +1,66 @@
+#include <zeno/utils/mapped_file.h>
+#include <filesystem>
+#ifdef _WIN32
+#include <zeno/utils/fuck_win.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace zeno {
+
+#ifdef _WIN32
+ZENO_API MappedFile::MappedFile(std::string const &path) {
+    auto native_path = std::filesystem::u8path(path).wstring();
+    HANDLE file = CreateFileW(native_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    m_file = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+        return;
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping)
+        return;
+    m_mapping = mapping;
+    m_data = (char const *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_data)
+        m_size = size.QuadPart;
+}
+
+ZENO_API MappedFile::~MappedFile() {
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+    if (m_file)
+        CloseHandle(m_file);
+}
+#else
+ZENO_API MappedFile::MappedFile(std::string const &path) {
+    m_fd = open(std::filesystem::u8path(path).c_str(), O_RDONLY);
+    if (m_fd == -1)
+        return;
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || st.st_size == 0)
+        return;
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (p == MAP_FAILED)
+        return;
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    m_data = (char const *)p;
+    m_size = st.st_size;
+}
+
+ZENO_API MappedFile::~MappedFile() {
+    if (m_data)
+        munmap((void *)m_data, m_size);
+    if (m_fd != -1)
+        close(m_fd);
+}
+#endif
+
+}